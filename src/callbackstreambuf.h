@@ -0,0 +1,142 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_CALLBACK_STREAM_BUF
+#define CHARLS_CALLBACK_STREAM_BUF
+
+#include "charls.h"
+#include "util.h"
+#include <algorithm>
+#include <cstring>
+#include <streambuf>
+#include <vector>
+
+
+//
+// CallbackStreamBuf: stream buffer on top of the read/write/skip callbacks of the C API. The callbacks are called with
+// blocks of the block size of the callbacks. The last block size bytes that have been read remain available: the decoder can put
+// back the bytes it has read beyond a scan (with a relative seek), also when the source itself doesn't support seeking.
+// A block size of 1 reads the source unbuffered: only the bytes that are actually consumed are taken from the source.
+//
+class CallbackStreamBuf : public std::basic_streambuf<char>
+{
+public:
+    explicit CallbackStreamBuf(const JlsStreamCallbacks& callbacks) :
+        CallbackStreamBuf(callbacks, GetStreamBlockSize(callbacks.blockSize))
+    {
+    }
+
+    CallbackStreamBuf(const JlsStreamCallbacks& callbacks, std::size_t blockSize) :
+        _callbacks(callbacks),
+        _blockSize(blockSize),
+        _buffer(_callbacks.read ? 2 * _blockSize : _blockSize)
+    {
+        if (_callbacks.read)
+        {
+            setg(_buffer.data() + _blockSize, _buffer.data() + _blockSize, _buffer.data() + _blockSize);
+        }
+        else
+        {
+            setp(_buffer.data(), _buffer.data() + _buffer.size());
+        }
+    }
+
+protected:
+    int_type underflow() override
+    {
+        if (!_callbacks.read)
+            return traits_type::eof();
+
+        // Keep the last consumed bytes (history) in front of the new block.
+        const std::size_t historyCount = std::min<std::size_t>(gptr() - eback(), _blockSize);
+        char* history = _buffer.data() + _blockSize - historyCount;
+        std::memmove(history, gptr() - historyCount, historyCount);
+
+        const std::size_t count = _callbacks.read(_callbacks.context, _buffer.data() + _blockSize, _blockSize);
+        setg(history, _buffer.data() + _blockSize, _buffer.data() + _blockSize + std::min(count, _blockSize));
+
+        return count == 0 ? traits_type::eof() : traits_type::to_int_type(*gptr());
+    }
+
+    int_type overflow(int_type ch) override
+    {
+        if (!_callbacks.write)
+            return traits_type::eof();
+
+        WriteBlock();
+
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        if (_callbacks.write)
+        {
+            WriteBlock();
+        }
+
+        return 0;
+    }
+
+    pos_type seekoff(off_type offset, std::ios_base::seekdir direction, std::ios_base::openmode which) override
+    {
+        if (direction != std::ios_base::cur || (which & std::ios_base::in) == 0 || !_callbacks.read)
+            return pos_type(off_type(-1));
+
+        // Bytes before the kept block cannot be put back.
+        if (offset < eback() - gptr())
+            return pos_type(off_type(-1));
+
+        // Inside the buffered bytes (this includes putting back the bytes that have been read last).
+        if (offset <= egptr() - gptr())
+        {
+            gbump(static_cast<int>(offset));
+            return pos_type(off_type(0));
+        }
+
+        // Skip the buffered bytes, the rest is skipped in the source. The get area is only changed when that succeeds;
+        // the kept bytes no longer precede the new position and are dropped.
+        const off_type remaining = offset - (egptr() - gptr());
+        if (_callbacks.skip)
+        {
+            if (_callbacks.skip(_callbacks.context, remaining) != 0)
+                return pos_type(off_type(-1));
+
+            setg(egptr(), egptr(), egptr());
+            return pos_type(off_type(0));
+        }
+
+        // Without a skip function the rest is read from the source, this only fails when the source ends.
+        setg(eback(), egptr(), egptr());
+        for (off_type skipped = 0; skipped < remaining; ++skipped)
+        {
+            if (traits_type::eq_int_type(sbumpc(), traits_type::eof()))
+                return pos_type(off_type(-1));
+        }
+
+        return pos_type(off_type(0));
+    }
+
+private:
+    void WriteBlock()
+    {
+        const auto count = static_cast<std::size_t>(pptr() - pbase());
+        if (count != 0 && _callbacks.write(_callbacks.context, pbase(), count) != count)
+            throw charls_error(charls::ApiResult::UnspecifiedFailure, "The write callback failed");
+
+        setp(_buffer.data(), _buffer.data() + _buffer.size());
+    }
+
+    JlsStreamCallbacks _callbacks;
+    std::size_t _blockSize;
+    std::vector<char> _buffer;
+};
+
+#endif
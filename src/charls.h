@@ -34,12 +34,148 @@
 
 
 #ifdef __cplusplus
+class JlsPushDecoder;
+class JlsPushEncoder;
+class JlsBatch;
+
 extern "C"
 {
 #else
 #include <stddef.h>
+
+typedef struct JlsPushDecoder JlsPushDecoder;
+typedef struct JlsPushEncoder JlsPushEncoder;
+typedef struct JlsBatch JlsBatch;
 #endif
 
+/// <summary>
+/// Function that is called by the decoder for every decoded line.
+/// </summary>
+/// <param name="context">The context pointer that was passed to the decode function.</param>
+/// <param name="line">The pixels of the line, in the same format as they would be stored in an output buffer.</param>
+/// <param name="pixelCount">The number of pixels of the line (the width).</param>
+/// <param name="stride">The size of the line in bytes.</param>
+/// <returns>0 to continue, any other value aborts the decoding.</returns>
+typedef int (*JlsLineDecodedCallback)(void* context, const void* line, int pixelCount, size_t stride);
+
+/// <summary>
+/// Function that is called by the encoder for every line that needs to be encoded.
+/// </summary>
+/// <param name="context">The context pointer that was passed to the encode function.</param>
+/// <param name="line">Buffer that needs to be filled with the pixels of the line, in the same format as they would be stored in an input buffer.</param>
+/// <param name="pixelCount">The number of pixels of the line (the width).</param>
+/// <param name="stride">The size of the line buffer in bytes.</param>
+/// <returns>0 to continue, any other value aborts the encoding.</returns>
+typedef int (*JlsLineRequestedCallback)(void* context, void* line, int pixelCount, size_t stride);
+
+/// <summary>
+/// Function that is called when all jobs of a batch are completed. Called on the worker thread that completed the last job.
+/// </summary>
+/// <param name="context">The context pointer that was passed to the batch function.</param>
+typedef void (*JlsBatchCompletedCallback)(void* context);
+
+/// <summary>
+/// Function that is called by the encoder when it needs a new chunk to store the encoded bytes.
+/// </summary>
+/// <param name="context">The context pointer that was passed to the encode function.</param>
+/// <param name="chunkLength">Receives the size of the returned chunk in bytes.</param>
+/// <returns>The new chunk, NULL aborts the encoding.</returns>
+typedef void* (*JlsAllocateChunkCallback)(void* context, size_t* chunkLength);
+
+/// <summary>
+/// Function that is called to read the next bytes of a stream.
+/// </summary>
+/// <param name="context">The context pointer of the stream callbacks.</param>
+/// <param name="buffer">Buffer that receives the bytes.</param>
+/// <param name="count">The number of bytes requested (the block size of the callbacks).</param>
+/// <returns>The number of bytes read, less than count is allowed. 0 signals the end of the stream (or a read error).</returns>
+typedef size_t (*JlsReadCallback)(void* context, void* buffer, size_t count);
+
+/// <summary>
+/// Function that is called to write bytes to a stream.
+/// </summary>
+/// <param name="context">The context pointer of the stream callbacks.</param>
+/// <param name="buffer">The bytes to write.</param>
+/// <param name="count">The number of bytes to write (at most the block size of the callbacks).</param>
+/// <returns>The number of bytes written, any value other than count aborts the encoding or decoding.</returns>
+typedef size_t (*JlsWriteCallback)(void* context, const void* buffer, size_t count);
+
+/// <summary>
+/// Function that is called to move the read position of a stream relative to the current position.
+/// </summary>
+/// <param name="context">The context pointer of the stream callbacks.</param>
+/// <param name="offset">The number of bytes to skip, negative values move the position back.</param>
+/// <returns>0 on success, any other value signals that the position could not be moved.</returns>
+typedef int (*JlsSkipCallback)(void* context, long long offset);
+
+/// <summary>
+/// Set of callback functions that gives access to a stream (for example a socket or an object in object storage).
+/// A source needs read, a destination needs write. skip is optional: without it, skipping forward reads and discards
+/// the bytes. The last block that has been read is kept, the codec never needs to move the position back in the stream itself.
+/// blockSize is the number of bytes passed to read and write at a time: 0 selects the default (64 KiB), the minimum is 1 KiB.
+/// </summary>
+struct JlsStreamCallbacks
+{
+    void* context;
+    JlsReadCallback read;
+    JlsWriteCallback write;
+    JlsSkipCallback skip;
+    size_t blockSize;
+};
+
+/// <summary>
+/// A task that is submitted to an executor.
+/// </summary>
+/// <param name="taskContext">The pointer that was passed together with the task.</param>
+typedef void (*JlsTaskFunction)(void* taskContext);
+
+/// <summary>
+/// Interface to the thread pool that runs all parallel work of CharLS. An application can pass its own pool (for example
+/// a TBB or OpenMP based scheduler) to avoid oversubscription. Tasks are submitted in groups: CharLS creates a group,
+/// submits its tasks and waits for the group. A task can itself create, submit to and wait for a group.
+/// </summary>
+struct JlsExecutor
+{
+    /// <summary>Pointer that is passed to all functions of the executor.</summary>
+    void* context;
+
+    /// <summary>Creates a new (empty) task group. The group is released by wait.</summary>
+    void* (*createGroup)(void* context);
+
+    /// <summary>Runs task(taskContext) exactly once, on any thread (including the calling thread).</summary>
+    void (*submit)(void* context, void* group, JlsTaskFunction task, void* taskContext);
+
+    /// <summary>Returns when all tasks submitted to the group are completed and releases the group.</summary>
+    void (*wait)(void* context, void* group);
+};
+
+/// <summary>
+/// Describes a single image to decode in a batch. result is set when the job is completed.
+/// </summary>
+struct JlsDecodeJob
+{
+    const void* source;
+    size_t sourceLength;
+    void* destination;
+    size_t destinationLength;
+    const struct JlsParameters* params;
+    CharlsApiResultType result;
+};
+
+/// <summary>
+/// Describes a single image to encode in a batch. bytesWritten and result are set when the job is completed.
+/// </summary>
+struct JlsEncodeJob
+{
+    void* destination;
+    size_t destinationLength;
+    const void* source;
+    size_t sourceLength;
+    const struct JlsParameters* params;
+    size_t bytesWritten;
+    CharlsApiResultType result;
+};
+
 /// <summary>
 /// Encodes a byte array with pixel data to a JPEG-LS encoded (compressed) byte array.
 /// </summary>
@@ -53,6 +189,90 @@ extern "C"
 CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncode(void* destination, size_t destinationLength, size_t* bytesWritten,
     const void* source, size_t sourceLength, const struct JlsParameters* params, char* errorMessage);
 
+/// <summary>
+/// Encodes a byte array with pixel data to a chain of chunks that are requested from an allocator callback.
+/// Every chunk is filled completely before the next one is requested, only the last chunk is partially used.
+/// The output size doesn't need to be known in advance and no output capacity is wasted.
+/// </summary>
+/// <param name="allocateChunk">Function that is called every time a new chunk is needed.</param>
+/// <param name="allocatorContext">Pointer that is passed to the allocator callback.</param>
+/// <param name="bytesWritten">This parameter will hold the total number of bytes written to the chunks. Cannot be NULL.</param>
+/// <param name="source">Byte array that holds the pixels that should be encoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeToChunks(JlsAllocateChunkCallback allocateChunk, void* allocatorContext,
+    size_t* bytesWritten, const void* source, size_t sourceLength, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Encodes a file with pixel data to a JPEG-LS file. Both files are memory mapped (with a sequential access hint): the codec reads
+/// the pixels directly from the source file and writes the encoded bytes directly to the destination file, without intermediate buffers.
+/// The destination is written as a temporary file (destinationPath + ".partial") with the worst case size, truncated to the encoded size
+/// and renamed when the encoding is complete. On failure the temporary file is removed and an existing destination file is left untouched.
+/// </summary>
+/// <param name="destinationPath">Path of the JPEG-LS file to create. An existing file is replaced when the call succeeds.</param>
+/// <param name="sourcePath">Path of the file with the pixel data, in the same format as the source of JpegLsEncode.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it.</param>
+/// <param name="bytesWritten">Receives the size of the encoded file in bytes, can be NULL.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeFile(const char* destinationPath, const char* sourcePath,
+    const struct JlsParameters* params, size_t* bytesWritten, char* errorMessage);
+
+/// <summary>
+/// Decodes a JPEG-LS file to a file with pixel data. Both files are memory mapped (with a sequential access hint): the codec reads
+/// the encoded bytes directly from the source file and writes the pixels directly to the destination file, without intermediate buffers.
+/// The pixels are written to a temporary file (destinationPath + ".partial") that is renamed when the decoding is complete; on failure
+/// it is removed and an existing destination file is left untouched.
+/// </summary>
+/// <param name="destinationPath">Path of the file to create for the pixel data. An existing file is replaced when the call succeeds.</param>
+/// <param name="sourcePath">Path of the JPEG-LS file.</param>
+/// <param name="params">Parameter object that describes how to decode the pixel data (outputBgr) or NULL. stride is ignored.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeFile(const char* destinationPath, const char* sourcePath,
+    const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Encodes pixel data that is read from a stream to a JPEG-LS encoded stream. Both streams are accessed with callback functions,
+/// in blocks of the block size of the callbacks: neither the pixel data nor the encoded data needs to be in memory.
+/// </summary>
+/// <param name="destination">The stream callbacks that receive the encoded bytes (write is used).</param>
+/// <param name="bytesWritten">This parameter will hold the number of bytes written to the destination stream. Cannot be NULL.</param>
+/// <param name="source">The stream callbacks that provide the pixels (read and optionally skip are used).</param>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeCallbackStream(const struct JlsStreamCallbacks* destination, size_t* bytesWritten,
+    const struct JlsStreamCallbacks* source, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Decodes a JPEG-LS encoded stream to a stream with pixel data. Both streams are accessed with callback functions,
+/// in blocks of the block size of the callbacks.
+/// </summary>
+/// <param name="destination">The stream callbacks that receive the pixels (write is used).</param>
+/// <param name="source">The stream callbacks that provide the encoded bytes (read and optionally skip are used).</param>
+/// <param name="params">Parameter object that describes how to decode the pixel data or NULL.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeCallbackStream(const struct JlsStreamCallbacks* destination,
+    const struct JlsStreamCallbacks* source, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Retrieves the JPEG-LS header from a stream that is accessed with callback functions. The stream is read unbuffered (one byte per
+/// read call): exactly the header bytes, up to and including the start of scan segment, are consumed from the stream.
+/// </summary>
+/// <param name="source">The stream callbacks that provide the encoded bytes (read is used).</param>
+/// <param name="params">Parameter object that describes how the pixel data is encoded.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsReadHeaderCallbackStream(const struct JlsStreamCallbacks* source,
+    struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Computes the maximum size of the encoded data of an image, the worst case for any pixel values. A destination of this
+/// size never causes JpegLsEncode to fail with CompressedBufferTooSmall.
+/// </summary>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it.</param>
+/// <param name="size">Receives the maximum size in bytes.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsGetMaximumEncodedSize(const struct JlsParameters* params, size_t* size, char* errorMessage);
+
 /// <summary>
 /// Retrieves the JPEG-LS header. This info can be used to pre-allocate the uncompressed output buffer.
 /// </summary>
@@ -79,6 +299,417 @@ CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeRect(void* uncompresse
     const void* compressedData, size_t compressedLength,
     struct JlsRect roi, const struct JlsParameters* info, char* errorMessage);
 
+/// <summary>
+/// Decodes only the selected components of an image that is encoded with interleave mode None (1 scan per component).
+/// The scans of the other components are skipped by searching for the next SOS marker, without decoding them.
+/// The selected components are stored consecutively (planar) in the destination, in component order.
+/// </summary>
+/// <param name="destination">Byte array that holds the pixel data of the selected components when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes, only the selected components need to fit.</param>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be decoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="componentMask">Bit i selects component i (the first 32 components can be selected). For interleave mode Line or Sample all components must be selected.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to decode it or NULL.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeComponents(void* destination, size_t destinationLength,
+    const void* source, size_t sourceLength, unsigned int componentMask, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Encodes indices (for example of an indexed color image) together with a mapping table (palette), written in LSE type 2
+/// segments (and type 3 continuations for large tables). All components select the table.
+/// </summary>
+/// <param name="destination">Byte array that holds the encoded bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes, see JpegLsGetMaximumEncodedMappedSize. If the array is too small the function will return an error.</param>
+/// <param name="bytesWritten">This parameter will hold the number of bytes written to the destination byte array. Cannot be NULL.</param>
+/// <param name="source">Byte array that holds the indices that should be encoded, in the same format as the source of JpegLsEncode.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="params">Parameter object that describes the indices and how to encode them.</param>
+/// <param name="mappingTable">The mapping table to store in the encoded data.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeMapped(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, const struct JlsParameters* params, const struct JlsMappingTable* mappingTable, char* errorMessage);
+
+/// <summary>
+/// Computes the maximum size of the data encoded by JpegLsEncodeMapped: the worst case size of JpegLsGetMaximumEncodedSize
+/// plus the LSE segments that hold the mapping table.
+/// </summary>
+/// <param name="params">Parameter object that describes the indices and how to encode them.</param>
+/// <param name="mappingTable">The mapping table to store in the encoded data.</param>
+/// <param name="size">Receives the maximum size in bytes.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsGetMaximumEncodedMappedSize(const struct JlsParameters* params,
+    const struct JlsMappingTable* mappingTable, size_t* size, char* errorMessage);
+
+/// <summary>
+/// Retrieves the mapping table that is selected by the first scan. tableId is 0 when the first scan doesn't use a mapping table.
+/// Decoders like JpegLsDecode return the indices, JpegLsDecodeMapped returns the table entries.
+/// </summary>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="mappingTable">Receives the table identifier, entry width and count. entries points to the entries argument.</param>
+/// <param name="entries">Byte array that receives the table entries (entryCount * entryWidth bytes) or NULL to only retrieve the size.</param>
+/// <param name="entriesLength">Length of the entries array in bytes.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsReadMappingTable(const void* source, size_t sourceLength,
+    struct JlsMappingTable* mappingTable, void* entries, size_t entriesLength, char* errorMessage);
+
+/// <summary>
+/// Decodes JPEG-LS encoded data and replaces every sample by the entry of the mapping table that is selected by its scan,
+/// while the lines are stored (without an intermediate image of indices). The destination holds entryWidth bytes per sample
+/// (see JlsMappingTable), samples of scans without a mapping table are stored as by JpegLsDecode.
+/// Mapping tables can only be applied to scans with 1 component (interleave mode None or single component images).
+/// </summary>
+/// <param name="destination">Byte array that holds the mapped pixel data when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be decoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to decode it or NULL. stride is ignored for mapped scans.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeMapped(void* destination, size_t destinationLength,
+    const void* source, size_t sourceLength, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Re-encodes JPEG-LS encoded data with other coding parameters (for example lossless to near-lossless, another interleave mode
+/// or color transformation). Every decoded line is encoded directly, without an intermediate image: the memory use doesn't depend
+/// on the image size. A change between interleave mode None and Line/Sample stores the lines of the components that cannot be encoded yet.
+/// </summary>
+/// <param name="destination">Byte array that holds the re-encoded bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="bytesWritten">This parameter will hold the number of bytes written to the destination byte array. Cannot be NULL.</param>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be re-encoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="params">Parameter object that describes how to encode. width, height, bitsPerSample and components are taken from the source, stride and outputBgr are ignored.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsTranscode(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Decodes a JPEG-LS encoded byte array and computes reduced resolution images (thumbnails or the levels of an image pyramid)
+/// while the lines are decoded, without a second pass over the full resolution image. Storing the full resolution image is optional.
+/// </summary>
+/// <param name="destination">Byte array that holds the full resolution pixel data when the function returns or NULL (destinationLength 0) to only create the reduced images.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be decoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="reducedImages">The reduced images to create (see JlsReducedImage).</param>
+/// <param name="reducedImageCount">The number of reduced images, at least 1.</param>
+/// <param name="params">Parameter object that describes how to decode the pixel data (outputBgr, stride of the full resolution image) or NULL.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeReduced(void* destination, size_t destinationLength, const void* source, size_t sourceLength,
+    const struct JlsReducedImage* reducedImages, size_t reducedImageCount, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Decodes a JPEG-LS encoded byte array and maps every sample with a window, a shift or a lookup table (see JlsSampleTransform)
+/// while the lines are stored, for example to display 12 or 16 bit images with 8 bits. The destination holds the output samples only,
+/// 1 byte per sample for up to 8 output bits and 2 bytes per sample otherwise.
+/// </summary>
+/// <param name="destination">Byte array that holds the transformed pixel data when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be decoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="transform">The mapping from decoded samples to output samples.</param>
+/// <param name="params">Parameter object that describes how to decode the pixel data (outputBgr, stride in bytes of the output) or NULL.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeTransformed(void* destination, size_t destinationLength, const void* source, size_t sourceLength,
+    const struct JlsSampleTransform* transform, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Decodes a JPEG-LS encoded byte array to the pixel layout of the caller (planar or interleaved, component order, padding channels, stride),
+/// independent of the interleave mode of the encoded data. The scans of an image with interleave mode None are decoded together
+/// in bands of lines when the layout is interleaved, no separate pass is needed to interleave the components.
+/// The orientation of the layout flips, mirrors or rotates the image while the lines are stored, for example for a bottom-up DIB.
+/// </summary>
+/// <param name="destination">Byte array that holds the pixel data in the given layout when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be decoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="layout">The layout of the pixels in the destination.</param>
+/// <param name="params">Parameter object that describes how to decode the pixel data or NULL. stride and outputBgr are replaced by the layout and should be 0.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeLayout(void* destination, size_t destinationLength, const void* source, size_t sourceLength,
+    const struct JlsPixelLayout* layout, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Builds an index of all marker segments of a JPEG-LS byte stream (from SOI up to and including EOI), without decoding
+/// the entropy coded data: the end of every scan is found with a (vectorized) search for the next marker.
+/// Call with segmentCapacity 0 to retrieve the number of segments.
+/// </summary>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="segments">Array that receives the first segmentCapacity segments, can be NULL when segmentCapacity is 0.</param>
+/// <param name="segmentCapacity">The number of elements of the segments array.</param>
+/// <param name="segmentCount">Receives the total number of segments, also when it is larger than segmentCapacity.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsGetSegmentIndex(const void* source, size_t sourceLength,
+    struct JlsSegmentInfo* segments, size_t segmentCapacity, size_t* segmentCount, char* errorMessage);
+
+/// <summary>
+/// Retrieves the JPEG-LS header from encoded data that is stored in multiple buffers (fragments).
+/// </summary>
+/// <param name="fragments">Array with the parts of the encoded data, in stream order.</param>
+/// <param name="fragmentCount">The number of fragments in the array.</param>
+/// <param name="params">Parameter object that describes how the pixel data is encoded.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsReadHeaderFragments(const struct JlsFragment* fragments, size_t fragmentCount,
+    struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Decodes JPEG-LS encoded data that is stored in multiple buffers (for example the fragments of DICOM encapsulated pixel data)
+/// without copying it to a contiguous buffer first.
+/// </summary>
+/// <param name="destination">Byte array that holds the uncompressed pixel data bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="fragments">Array with the parts of the encoded data, in stream order. Fragments can have any size (also 0).</param>
+/// <param name="fragmentCount">The number of fragments in the array.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to decode it.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeFragments(void* destination, size_t destinationLength,
+    const struct JlsFragment* fragments, size_t fragmentCount, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Encodes pixel data that is requested line by line from a callback function to a JPEG-LS encoded (compressed) byte array.
+/// Allows to produce the lines while encoding, without an intermediate buffer for the complete image.
+/// </summary>
+/// <param name="destination">Byte array that holds the encoded bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="bytesWritten">This parameter will hold the number of bytes written to the destination byte array. Cannot be NULL.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it. stride is ignored.</param>
+/// <param name="lineRequested">Function that is called for every line. For interleave mode None all lines of the first component are requested first.</param>
+/// <param name="context">Pointer that is passed to the callback function.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeWithCallback(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const struct JlsParameters* params, JlsLineRequestedCallback lineRequested, void* context, char* errorMessage);
+
+/// <summary>
+/// Encodes pixel data that is read directly from the pixel layout of the caller (separate planes or interleaved pixels with
+/// padding channels, see JlsSourceLayout), independent of the interleave mode of the encoded data: no intermediate planar
+/// or interleaved copy of the image is needed.
+/// </summary>
+/// <param name="destination">Byte array that holds the encoded bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="bytesWritten">This parameter will hold the number of bytes written to the destination byte array. Cannot be NULL.</param>
+/// <param name="layout">The layout of the pixel data that should be encoded.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it. stride is ignored.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeLayout(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const struct JlsSourceLayout* layout, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Encodes pixel data that is stored in a big endian, MSB aligned or bit packed source format (see CharlsSourceFormat).
+/// Every line is converted to native samples while it is requested by the encoder, no converted copy of the image is needed.
+/// </summary>
+/// <param name="destination">Byte array that holds the encoded bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="bytesWritten">This parameter will hold the number of bytes written to the destination byte array. Cannot be NULL.</param>
+/// <param name="source">Byte array that holds the pixel data in the source format. Packed lines start at a byte boundary.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="sourceFormat">The format of the samples in the source byte array.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it. stride is the stride of the source lines, 0 for no padding.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeFormat(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, CharlsSourceFormatType sourceFormat, const struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Decodes a JPEG-LS encoded byte array and passes every decoded line to a callback function.
+/// Allows to process the lines while they are still in the cache, without an output buffer for the complete image.
+/// </summary>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be decoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="params">Parameter object that describes how to decode the pixel data (outputBgr) or NULL. stride is ignored.</param>
+/// <param name="lineDecoded">Function that is called for every decoded line. For interleave mode None all lines of the first component are passed first.</param>
+/// <param name="context">Pointer that is passed to the callback function.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeWithCallback(const void* source, size_t sourceLength,
+    const struct JlsParameters* params, JlsLineDecodedCallback lineDecoded, void* context, char* errorMessage);
+
+/// <summary>
+/// Encodes like JpegLsEncode, but the lines are read and converted (color transformation, deinterleaving) by a task on the
+/// executor while the previous lines are encoded: a single image is encoded by 2 threads.
+/// When the executor cannot run the task in parallel (for example the serial executor) the image is encoded on the calling thread.
+/// </summary>
+/// <param name="destination">Byte array that holds the encoded bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="bytesWritten">This parameter will hold the number of bytes written to the destination byte array. Cannot be NULL.</param>
+/// <param name="source">Byte array that holds the pixels that should be encoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it.</param>
+/// <param name="executor">The executor that reads and converts the lines or NULL to use the executor registered with JpegLsSetExecutor.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodePipelined(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, const struct JlsParameters* params, const struct JlsExecutor* executor, char* errorMessage);
+
+/// <summary>
+/// Decodes like JpegLsDecode, but the decoded lines are post-processed (inverse color transformation, interleaving, output)
+/// by a task on the executor while the next lines are decoded: a single image is decoded by 2 threads.
+/// When the executor cannot run the task in parallel (for example the serial executor) the image is decoded on the calling thread.
+/// </summary>
+/// <param name="destination">Byte array that holds the uncompressed pixel data bytes when the function returns.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="source">Byte array that holds the JPEG-LS encoded data that should be decoded.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="params">Parameter object that describes the pixel data and how to decode it.</param>
+/// <param name="executor">The executor that runs the post-processing or NULL to use the executor registered with JpegLsSetExecutor.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodePipelined(void* destination, size_t destinationLength,
+    const void* source, size_t sourceLength, const struct JlsParameters* params, const struct JlsExecutor* executor, char* errorMessage);
+
+/// <summary>
+/// Starts to decode a batch of independent images on an executor and returns immediately.
+/// Idle workers steal jobs from busy workers: the load is balanced when the images differ in size.
+/// </summary>
+/// <param name="jobs">Array of jobs. Must remain valid until the batch is completed.</param>
+/// <param name="jobCount">The number of jobs in the array.</param>
+/// <param name="workerCount">The maximum number of jobs that run in parallel, 0 to use the number of hardware threads.</param>
+/// <param name="executor">The executor that runs the jobs or NULL to use the executor registered with JpegLsSetExecutor.</param>
+/// <param name="completed">Function called when all jobs are completed, can be NULL.</param>
+/// <param name="context">Pointer that is passed to the completed callback.</param>
+/// <returns>Handle to wait for the completion of the batch or NULL when the batch could not be started. Must be released with JpegLsBatchDestroy.</returns>
+CHARLS_DLL_IMPORT_EXPORT(JlsBatch*) JpegLsDecodeBatchAsync(struct JlsDecodeJob* jobs, size_t jobCount, int workerCount,
+    const struct JlsExecutor* executor, JlsBatchCompletedCallback completed, void* context);
+
+/// <summary>
+/// Starts to encode a batch of independent images on an executor and returns immediately.
+/// </summary>
+/// <param name="jobs">Array of jobs. Must remain valid until the batch is completed.</param>
+/// <param name="jobCount">The number of jobs in the array.</param>
+/// <param name="workerCount">The maximum number of jobs that run in parallel, 0 to use the number of hardware threads.</param>
+/// <param name="executor">The executor that runs the jobs or NULL to use the executor registered with JpegLsSetExecutor.</param>
+/// <param name="completed">Function called when all jobs are completed, can be NULL.</param>
+/// <param name="context">Pointer that is passed to the completed callback.</param>
+/// <returns>Handle to wait for the completion of the batch or NULL when the batch could not be started. Must be released with JpegLsBatchDestroy.</returns>
+CHARLS_DLL_IMPORT_EXPORT(JlsBatch*) JpegLsEncodeBatchAsync(struct JlsEncodeJob* jobs, size_t jobCount, int workerCount,
+    const struct JlsExecutor* executor, JlsBatchCompletedCallback completed, void* context);
+
+/// <summary>
+/// Waits until all jobs of the batch are completed.
+/// </summary>
+/// <param name="batch">The batch.</param>
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsBatchWait(JlsBatch* batch);
+
+/// <summary>
+/// Waits until all jobs of the batch are completed and releases the batch. Cannot be called from the completed callback.
+/// </summary>
+/// <param name="batch">The batch to release, can be NULL.</param>
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsBatchDestroy(JlsBatch* batch);
+
+/// <summary>
+/// Registers the executor that is used when NULL is passed as executor. By default a pool of std::thread workers
+/// (1 per hardware thread) is used.
+/// </summary>
+/// <param name="executor">The executor, must remain valid while it is registered. NULL restores the default executor.</param>
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsSetExecutor(const struct JlsExecutor* executor);
+
+/// <summary>
+/// Returns an executor that runs every task directly on the calling thread (no parallelism).
+/// </summary>
+CHARLS_DLL_IMPORT_EXPORT(const struct JlsExecutor*) JpegLsGetSerialExecutor(void);
+
+/// <summary>
+/// Creates an executor with its own pool of std::thread workers.
+/// </summary>
+/// <param name="threadCount">The number of worker threads, 0 to use the number of hardware threads.</param>
+/// <returns>The executor or NULL when it could not be created. Must be released with JpegLsDestroyThreadExecutor.</returns>
+CHARLS_DLL_IMPORT_EXPORT(struct JlsExecutor*) JpegLsCreateThreadExecutor(int threadCount);
+
+/// <summary>
+/// Releases an executor created by JpegLsCreateThreadExecutor. All groups must have been waited for.
+/// </summary>
+/// <param name="executor">The executor to release, can be NULL.</param>
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsDestroyThreadExecutor(struct JlsExecutor* executor);
+
+/// <summary>
+/// Creates a decoder that accepts the JPEG-LS encoded data in chunks, as it arrives.
+/// Decoded lines are written to the destination as soon as enough encoded data is available; the decoder never blocks.
+/// </summary>
+/// <param name="params">Parameter object that describes how to decode the pixel data (stride, outputBgr) or NULL.</param>
+/// <param name="decoder">Receives the decoder. Must be released with JpegLsPushDecoderDestroy.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsPushDecoderCreate(const struct JlsParameters* params, JlsPushDecoder** decoder, char* errorMessage);
+
+/// <summary>
+/// Releases a decoder created by JpegLsPushDecoderCreate.
+/// </summary>
+/// <param name="decoder">The decoder to release, can be NULL.</param>
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsPushDecoderDestroy(JlsPushDecoder* decoder);
+
+/// <summary>
+/// Passes the next chunk of JPEG-LS encoded data to the decoder and decodes all lines for which enough data is available.
+/// </summary>
+/// <param name="decoder">The decoder.</param>
+/// <param name="source">Byte array that holds the next chunk of JPEG-LS encoded data.</param>
+/// <param name="sourceLength">Length of the array in bytes.</param>
+/// <param name="decodedLineCount">Holds the total number of lines that are decoded to the destination when the function returns. Can be NULL.
+/// For images with interleave mode None the lines of all components are counted, the image is complete when the count is height * components.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsPushDecoderAddBytes(JlsPushDecoder* decoder, const void* source, size_t sourceLength,
+    size_t* decodedLineCount, char* errorMessage);
+
+/// <summary>
+/// Retrieves the JPEG-LS header. Returns CompressedBufferTooSmall as long as not enough data is passed to read the complete header.
+/// The height is 0 when it is defined by a DNL segment after the scan, it is updated after the DNL segment has been read.
+/// </summary>
+/// <param name="decoder">The decoder.</param>
+/// <param name="params">Parameter object that describes how the pixel data is encoded.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsPushDecoderReadHeader(JlsPushDecoder* decoder, struct JlsParameters* params, char* errorMessage);
+
+/// <summary>
+/// Sets the byte array for the uncompressed pixel data. Decoding of the lines starts after the destination has been set.
+/// Encoded data that is passed before is buffered.
+/// </summary>
+/// <param name="decoder">The decoder.</param>
+/// <param name="destination">Byte array that holds the uncompressed pixel data bytes. Must remain valid until the image is decoded.</param>
+/// <param name="destinationLength">Length of the array in bytes. If the array is too small the function will return an error.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsPushDecoderSetDestination(JlsPushDecoder* decoder, void* destination, size_t destinationLength,
+    char* errorMessage);
+
+/// <summary>
+/// Creates an encoder that accepts the pixel data line by line and returns the encoded bytes as soon as they are available.
+/// The encoder holds only 2 lines of the image: no frame buffer is needed.
+/// </summary>
+/// <param name="params">Parameter object that describes the pixel data and how to encode it. stride is the size of 1 line in bytes.
+/// height can be 0 when the number of lines is not known: the height is written in a DNL segment by JpegLsPushEncoderFinish.</param>
+/// <param name="encoder">Receives the encoder. Must be released with JpegLsPushEncoderDestroy.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsPushEncoderCreate(const struct JlsParameters* params, JlsPushEncoder** encoder, char* errorMessage);
+
+/// <summary>
+/// Releases an encoder created by JpegLsPushEncoderCreate.
+/// </summary>
+/// <param name="encoder">The encoder to release, can be NULL.</param>
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsPushEncoderDestroy(JlsPushEncoder* encoder);
+
+/// <summary>
+/// Encodes the next lines and copies the encoded bytes that are available to the destination.
+/// Every call flushes all complete bytes: at most 7 bits of the last line are held back until the next line is passed.
+/// The header is returned with the first call, the end of image marker after the last line.
+/// When bytesWritten equals destinationLength more bytes may be pending: call again without source lines to retrieve them.
+/// For interleave mode None all lines of the first component are passed first, followed by the lines of the next component.
+/// </summary>
+/// <param name="encoder">The encoder.</param>
+/// <param name="source">Byte array that holds the lines to encode, can be NULL when sourceLength is 0.</param>
+/// <param name="sourceLength">Length of the array in bytes, must be a multiple of the stride.</param>
+/// <param name="destination">Byte array that receives the encoded bytes.</param>
+/// <param name="destinationLength">Length of the destination array in bytes.</param>
+/// <param name="bytesWritten">Receives the number of bytes copied to the destination.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsPushEncoderEncodeLines(JlsPushEncoder* encoder, const void* source, size_t sourceLength,
+    void* destination, size_t destinationLength, size_t* bytesWritten, char* errorMessage);
+
+/// <summary>
+/// Completes an image that was created with height 0: ends the scan and writes a DNL segment with the number of passed lines
+/// and the end of image marker. For images with a known height the function only verifies that all lines have been passed.
+/// Pending bytes are retrieved in the same way as with JpegLsPushEncoderEncodeLines.
+/// </summary>
+/// <param name="encoder">The encoder.</param>
+/// <param name="destination">Byte array that receives the encoded bytes.</param>
+/// <param name="destinationLength">Length of the destination array in bytes.</param>
+/// <param name="bytesWritten">Receives the number of bytes copied to the destination.</param>
+/// <param name="errorMessage">Character array of at least 256 characters or NULL. Hold the error message when a failure occurs, empty otherwise.</param>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsPushEncoderFinish(JlsPushEncoder* encoder, void* destination, size_t destinationLength,
+    size_t* bytesWritten, char* errorMessage);
+
 #ifdef __cplusplus
 }
 
@@ -86,6 +717,20 @@ CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeStream(ByteStreamInfo
 CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeStream(ByteStreamInfo rawStream, ByteStreamInfo compressedStream, const JlsParameters* info, char* errorMessage);
 CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsReadHeaderStream(ByteStreamInfo rawStreamInfo, JlsParameters* params, char* errorMessage);
 
+/// <summary>
+/// Encodes like JpegLsEncodeStream, with the line input of JpegLsEncodePipelined: the lines are read from rawStreamInfo and converted
+/// by a task on the executor (NULL for the executor registered with JpegLsSetExecutor), the stream input overlaps the encoding.
+/// </summary>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsEncodeStreamPipelined(ByteStreamInfo compressedStreamInfo, size_t& bytesWritten,
+    ByteStreamInfo rawStreamInfo, const JlsParameters& params, const JlsExecutor* executor, char* errorMessage);
+
+/// <summary>
+/// Decodes like JpegLsDecodeStream, with the post-processing of JpegLsDecodePipelined: the decoded lines are converted and written
+/// to rawStream by a task on the executor (NULL for the executor registered with JpegLsSetExecutor), the stream output overlaps the decoding.
+/// </summary>
+CHARLS_DLL_IMPORT_EXPORT(CharlsApiResultType) JpegLsDecodeStreamPipelined(ByteStreamInfo rawStream, ByteStreamInfo compressedStream,
+    const JlsParameters* info, const JlsExecutor* executor, char* errorMessage);
+
 #endif
 
 #endif
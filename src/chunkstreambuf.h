@@ -0,0 +1,85 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_CHUNK_STREAM_BUF
+#define CHARLS_CHUNK_STREAM_BUF
+
+#include "charls.h"
+#include "util.h"
+#include <algorithm>
+#include <cstring>
+#include <streambuf>
+
+
+//
+// ChunkStreamBuf: output stream buffer that writes into a chain of chunks. A new chunk is requested from the
+// allocator callback when the current chunk is full: every chunk is filled completely, except the last one.
+//
+class ChunkStreamBuf : public std::basic_streambuf<char>
+{
+public:
+    ChunkStreamBuf(JlsAllocateChunkCallback allocateChunk, void* context) noexcept :
+        _allocateChunk(allocateChunk),
+        _context(context),
+        _bytesWritten(0)
+    {
+    }
+
+    std::size_t GetBytesWritten() const noexcept
+    {
+        return _bytesWritten + static_cast<std::size_t>(pptr() - pbase());
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        NextChunk();
+
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize count) override
+    {
+        std::streamsize written = 0;
+        while (written < count)
+        {
+            if (pptr() == epptr())
+            {
+                NextChunk();
+            }
+
+            const auto copyCount = std::min<std::streamsize>({count - written, epptr() - pptr(), INT32_MAX});
+            std::memcpy(pptr(), s + written, static_cast<std::size_t>(copyCount));
+            pbump(static_cast<int>(copyCount));
+            written += copyCount;
+        }
+
+        return written;
+    }
+
+private:
+    void NextChunk()
+    {
+        _bytesWritten += static_cast<std::size_t>(pptr() - pbase());
+
+        std::size_t length = 0;
+        const auto chunk = static_cast<char*>(_allocateChunk(_context, &length));
+        if (!chunk || length == 0)
+            throw charls_error(charls::ApiResult::CompressedBufferTooSmall, "The chunk allocator didn't provide a new chunk");
+
+        setp(chunk, chunk + length);
+    }
+
+    JlsAllocateChunkCallback _allocateChunk;
+    void* _context;
+    std::size_t _bytesWritten;
+};
+
+#endif
@@ -8,6 +8,8 @@
 #include "util.h"
 #include "processline.h"
 #include <memory>
+#include <algorithm>
+#include <cstring>
 
 // Purpose: Implements encoding to stream of bits. In encoding mode JpegLsCodec inherits from EncoderStrategy
 class DecoderStrategy
@@ -20,7 +22,12 @@ public:
         _validBits(0),
         _position(nullptr),
         _nextFFPosition(nullptr),
-        _endPosition(nullptr)
+        _endPosition(nullptr),
+        _windowStart(nullptr),
+        _fragments(nullptr),
+        _fragmentCount(0),
+        _resumeFragment(0),
+        _resumeOffset(0)
     {
     }
 
@@ -34,15 +41,33 @@ public:
     virtual std::unique_ptr<ProcessLine> CreateProcess(ByteStreamInfo rawStreamInfo) = 0;
     virtual void SetPresets(const JpegLSPresetCodingParameters& presets) = 0;
     virtual void DecodeScan(std::unique_ptr<ProcessLine> outputData, const JlsRect& size, ByteStreamInfo& compressedData) = 0;
+    virtual void DecodeScan(ByteStreamInfo rawPixels, const JlsRect& size, ByteStreamInfo& compressedData) = 0;
+    virtual void StartDecodeScan(std::unique_ptr<ProcessLine> outputData, const JlsRect& size, ByteStreamInfo& compressedData) = 0;
+    virtual void DecodeLines(int32_t lineCount) = 0;
+
+    // Push mode: decodes the next line only when the buffered bytes contain it completely, returns false (and leaves the
+    // state of the scan unchanged) when the line needs bytes that have not been added yet.
+    virtual bool TryDecodeLine() = 0;
 
     void Init(ByteStreamInfo& compressedStream)
     {
         _validBits = 0;
         _readCache = 0;
 
+        if (!compressedStream.rawStream && !compressedStream.rawData)
+        {
+            // Push mode: the compressed bytes will be passed later with AddBytes.
+            _byteStream = nullptr;
+            _buffer.clear();
+            _position = nullptr;
+            _endPosition = nullptr;
+            _nextFFPosition = nullptr;
+            return;
+        }
+
         if (compressedStream.rawStream)
         {
-            _buffer.resize(40000);
+            _buffer.resize(GetStreamBlockSize(compressedStream.blockSize));
             _position = _buffer.data();
             _endPosition = _position;
             _byteStream = compressedStream.rawStream;
@@ -54,13 +79,31 @@ public:
             _position = compressedStream.rawData;
             _endPosition = _position + compressedStream.count;
         }
+        _windowStart = _position;
 
         _nextFFPosition = FindNextFF();
         MakeValid();
     }
 
+    // Scatter-gather input: the bytes passed to Init are the tail of fragments[currentFragment], the compressed
+    // data continues in the next fragments. Must be called before Init.
+    void SetFragments(const JlsFragment* fragments, std::size_t fragmentCount, std::size_t currentFragment)
+    {
+        _fragments = fragments;
+        _fragmentCount = fragmentCount;
+        _resumeFragment = currentFragment + 1;
+        _resumeOffset = 0;
+        _buffer.resize(BridgeSize);
+    }
+
     void AddBytesFromStream()
     {
+        if (_resumeFragment < _fragmentCount)
+        {
+            AddBytesFromFragments();
+            return;
+        }
+
         if (!_byteStream || _byteStream->sgetc() == std::char_traits<char>::eof())
             return;
 
@@ -83,19 +126,92 @@ public:
         _endPosition += readbytes;
     }
 
-    FORCE_INLINE void Skip(int32_t length) noexcept
+    // Appends compressed bytes to the internal buffer (push mode). Already consumed bytes are discarded.
+    void AddBytes(const uint8_t* data, std::size_t count)
     {
-        _validBits -= length;
-        _readCache = _readCache << length;
+        ASSERT(!_byteStream);
+
+        // Keep a couple of consumed bytes, GetCurBytePos may need to look back.
+        const std::size_t consumedCount = _position ? static_cast<std::size_t>(_position - _buffer.data()) : 0;
+        const std::size_t lookBackCount = std::min(consumedCount, 2 * sizeof(bufType));
+        _buffer.erase(_buffer.begin(), _buffer.begin() + static_cast<std::ptrdiff_t>(consumedCount - lookBackCount));
+        _buffer.insert(_buffer.end(), data, data + count);
+
+        _position = _buffer.data() + lookBackCount;
+        _endPosition = _buffer.data() + _buffer.size();
+        _nextFFPosition = FindNextFF();
+    }
+
+    // Stream mode: the stream is read in blocks, the bytes after the scan that have been read from the stream are put back
+    // to let the marker segments after the scan be read from the stream. The stream must support seeking, otherwise the
+    // next marker would be read from the wrong position. Only valid after EndScan.
+    void PutBackBytesAfterScan()
+    {
+        const auto count = static_cast<std::streamoff>(_endPosition - GetCurBytePos());
+        if (count != 0 &&
+            _byteStream->pubseekoff(-count, std::ios_base::cur, std::ios_base::in) == std::streambuf::pos_type(std::streambuf::off_type(-1)))
+            throw charls_error(charls::ApiResult::ParameterValueNotSupported, "The compressed stream must support seeking to put back the bytes read after the scan");
+
+        _endPosition -= count;
+    }
+
+    std::size_t GetNextFragment() const noexcept
+    {
+        return _resumeFragment;
+    }
+
+    std::size_t GetBufferedByteCount() const noexcept
+    {
+        return _endPosition - _position;
+    }
+
+    // Returns the compressed bytes that follow the scan, only valid after EndScan. With scatter-gather input these are
+    // the remaining bytes of the fragment that holds the end of the scan, GetNextFragment returns the fragment after it.
+    ByteStreamInfo GetRemainingBytes() noexcept
+    {
+        uint8_t* position = GetCurBytePos();
+        if (_fragmentCount == 0 || _windowStart != _buffer.data())
+            return FromByteArray(position, _endPosition - position);
+
+        // The position is in the bridge buffer: walk back from the resume point to find it in the fragments.
+        std::size_t distance = _endPosition - position;
+        std::size_t index = _resumeFragment;
+        std::size_t offset = _resumeOffset;
+        while (offset < distance || index == _fragmentCount)
+        {
+            distance -= offset;
+            --index;
+            offset = _fragments[index].length;
+        }
+
+        _resumeFragment = index + 1;
+        _resumeOffset = 0;
+        offset -= distance;
+        return FromByteArrayConst(static_cast<const uint8_t*>(_fragments[index].data) + offset, _fragments[index].length - offset);
     }
 
-    static void OnLineBegin(int32_t /*cpixel*/, void* /*ptypeBuffer*/, int32_t /*pixelStride*/) noexcept
+    // Returns the buffered bytes that follow the scan, only valid after EndScan.
+    std::vector<uint8_t> GetBytesAfterScan() const
     {
+        return std::vector<uint8_t>(GetCurBytePos(), _endPosition);
     }
 
-    void OnLineEnd(int32_t pixelCount, const void* ptypeBuffer, int32_t pixelStride) const
+    // Returns true when all lines of the scan are decoded: only the padding bits of the last byte remain before
+    // the next marker. Used when the number of lines is defined by a DNL segment after the scan.
+    // Note: every encoded line contains at least 1 set bit, padding bits are always 0.
+    bool IsAtEndOfScan()
     {
-        _processLine->NewLineDecoded(ptypeBuffer, pixelCount, pixelStride);
+        if (_readCache != 0 || _validBits >= 8)
+            return false;
+
+        AddBytesFromStream();
+        return _endPosition - _position >= 2 && _position[0] == 0xFF && (_position[1] & 0x80) != 0;
+    }
+
+    FORCE_INLINE void Skip(int32_t length) noexcept
+    {
+        _validBits -= length;
+        _readCache = _readCache << length;
     }
 
     void EndScan()
@@ -115,7 +231,7 @@ public:
     FORCE_INLINE bool OptimizedRead() noexcept
     {
         // Easy & fast: if there is no 0xFF byte in sight, we can read without bit stuffing
-        if (_position < _nextFFPosition - (sizeof(bufType)-1))
+        if (_nextFFPosition - _position > static_cast<std::ptrdiff_t>(sizeof(bufType) - 1))
         {
             _readCache |= FromBigEndian<sizeof(bufType)>::Read(_position) >> _validBits;
             const int bytesToRead = (bufType_bit_count - _validBits) >> 3;
@@ -129,6 +245,10 @@ public:
 
     void MakeValid()
     {
+        // Bits past the end of the data have been read (only zero bits are available there).
+        if (_validBits < 0)
+            throw charls_error(charls::ApiResult::InvalidCompressedData);
+
         ASSERT(static_cast<size_t>(_validBits) <=bufType_bit_count - 8);
 
         if (OptimizedRead())
@@ -288,12 +408,94 @@ public:
     }
 
 protected:
+    struct ReaderState
+    {
+        std::size_t readCache;
+        int32_t validBits;
+        uint8_t* position;
+        uint8_t* nextFFPosition;
+    };
+
+    ReaderState GetReaderState() const noexcept
+    {
+        return {_readCache, _validBits, _position, _nextFFPosition};
+    }
+
+    void SetReaderState(const ReaderState& state) noexcept
+    {
+        _readCache = state.readCache;
+        _validBits = state.validBits;
+        _position = state.position;
+        _nextFFPosition = state.nextFFPosition;
+    }
+
+    // Returns true when the decoder has read bits past the buffered bytes (only zero bits are available there).
+    bool IsReadPastBufferedBytes() const noexcept
+    {
+        return _validBits < 0;
+    }
+
+    // Returns true when all buffered bytes have been read, except a last 0xFF byte (it needs the next byte).
+    bool IsAtEndOfBufferedBytes() const noexcept
+    {
+        return _endPosition - _position <= 1;
+    }
+
     JlsParameters _params;
     std::unique_ptr<ProcessLine> _processLine;
 
 private:
     using bufType = std::size_t;
     static constexpr size_t bufType_bit_count = sizeof(bufType) * 8;
+    static constexpr size_t BridgeSize = 256;
+
+    // Continues reading in the next fragment. Like AddBytesFromStream this is only done when 64 bytes or less are left.
+    // When the bytes that are not consumed yet (and the consumed bytes GetCurBytePos can look back at) are in the same
+    // fragment as the next bytes, reading continues directly in that fragment. Otherwise they are copied to a small
+    // bridge buffer, followed by the first bytes of the next fragment(s).
+    void AddBytesFromFragments()
+    {
+        const std::size_t count = _endPosition - _position;
+        if (count > 64)
+            return;
+
+        const std::size_t lookBackCount = std::min<std::size_t>(_position - _windowStart, 2 * sizeof(bufType));
+        const std::size_t keepCount = lookBackCount + count;
+        const JlsFragment& resume = _fragments[_resumeFragment];
+
+        if (_resumeOffset >= keepCount && _resumeOffset < resume.length)
+        {
+            _windowStart = const_cast<uint8_t*>(static_cast<const uint8_t*>(resume.data));
+            _position = _windowStart + _resumeOffset - count;
+            _endPosition = _windowStart + resume.length;
+            ++_resumeFragment;
+            _resumeOffset = 0;
+        }
+        else
+        {
+            std::memmove(_buffer.data(), _position - lookBackCount, keepCount);
+            std::size_t size = keepCount;
+            while (size < BridgeSize && _resumeFragment < _fragmentCount)
+            {
+                const JlsFragment& fragment = _fragments[_resumeFragment];
+                const std::size_t copyCount = std::min(BridgeSize - size, fragment.length - _resumeOffset);
+                std::memcpy(_buffer.data() + size, static_cast<const uint8_t*>(fragment.data) + _resumeOffset, copyCount);
+                size += copyCount;
+                _resumeOffset += copyCount;
+                if (_resumeOffset == fragment.length)
+                {
+                    ++_resumeFragment;
+                    _resumeOffset = 0;
+                }
+            }
+
+            _windowStart = _buffer.data();
+            _position = _windowStart + lookBackCount;
+            _endPosition = _windowStart + size;
+        }
+
+        _nextFFPosition = FindNextFF();
+    }
 
     std::vector<uint8_t> _buffer;
     std::basic_streambuf<char>* _byteStream;
@@ -304,6 +506,13 @@ private:
     uint8_t* _position;
     uint8_t* _nextFFPosition;
     uint8_t* _endPosition;
+
+    // scatter-gather input
+    uint8_t* _windowStart;
+    const JlsFragment* _fragments;
+    std::size_t _fragmentCount;
+    std::size_t _resumeFragment;
+    std::size_t _resumeOffset;
 };
 
 
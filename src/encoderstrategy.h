@@ -36,18 +36,30 @@ public:
     virtual std::unique_ptr<ProcessLine> CreateProcess(ByteStreamInfo rawStreamInfo) = 0;
     virtual void SetPresets(const JpegLSPresetCodingParameters& presets) = 0;
     virtual std::size_t EncodeScan(std::unique_ptr<ProcessLine> rawData, ByteStreamInfo& compressedData) = 0;
+    virtual std::size_t EncodeScan(ByteStreamInfo rawPixels, ByteStreamInfo& compressedData) = 0;
+    virtual void StartEncodeScan(ByteStreamInfo& compressedData) = 0;
+    virtual void EncodeLines(std::unique_ptr<ProcessLine> rawData, int32_t lineCount) = 0;
 
-    int32_t PeekByte();
-
-    void OnLineBegin(int32_t cpixel, void* ptypeBuffer, int32_t pixelStride) const
+    // Moves the encoded bytes to the destination (push mode). Only complete bytes are moved, at most 7 bits
+    // remain in the bit buffer until more lines are encoded. At the end of the scan all bits are moved.
+    void TakeEncodedBytes(std::vector<uint8_t>& destination, bool endOfScan)
     {
-        _processLine->NewLineRequested(ptypeBuffer, cpixel, pixelStride);
-    }
+        if (endOfScan)
+        {
+            EndScan();
+        }
+        else
+        {
+            FlushCompleteBytes();
+        }
 
-    static void OnLineEnd(int32_t /*cpixel*/, void* /*ptypeBuffer*/, int32_t /*pixelStride*/) noexcept
-    {
+        destination.insert(destination.end(), _buffer.data(), _position);
+        _position = _buffer.data();
+        _compressedLength = _buffer.size();
     }
 
+    int32_t PeekByte();
+
 protected:
 
     void Init(ByteStreamInfo& compressedStream)
@@ -55,15 +67,17 @@ protected:
         _freeBitCount = sizeof(_bitBuffer) * 8;
         _bitBuffer = 0;
 
-        if (compressedStream.rawStream)
+        if (compressedStream.rawStream || !compressedStream.rawData)
         {
+            // Stream or push mode (no destination): bytes are collected in the buffer.
             _compressedStream = compressedStream.rawStream;
-            _buffer.resize(4000);
+            _buffer.resize(GetStreamBlockSize(compressedStream.blockSize));
             _position = _buffer.data();
             _compressedLength = _buffer.size();
         }
         else
         {
+            _buffer.clear();
             _position = compressedStream.rawData;
             _compressedLength = compressedStream.count;
         }
@@ -123,7 +137,17 @@ protected:
     void OverFlow()
     {
         if (!_compressedStream)
-            throw charls_error(charls::ApiResult::CompressedBufferTooSmall);
+        {
+            if (_buffer.empty())
+                throw charls_error(charls::ApiResult::CompressedBufferTooSmall);
+
+            // Push mode: keep the bytes until they are taken.
+            const std::size_t bytesCount = _position - _buffer.data();
+            _buffer.resize(_buffer.size() * 2);
+            _position = _buffer.data() + bytesCount;
+            _compressedLength = _buffer.size() - bytesCount;
+            return;
+        }
 
         const std::size_t bytesCount = _position - _buffer.data();
         const auto bytesWritten = static_cast<std::size_t>(_compressedStream->sputn(reinterpret_cast<char*>(_buffer.data()), _position - _buffer.data()));
@@ -168,6 +192,36 @@ protected:
         }
     }
 
+    // Writes the bytes of the bit buffer that are completely filled (after a 0xFF byte 7 bits fill a byte).
+    void FlushCompleteBytes()
+    {
+        if (_compressedLength < 4)
+        {
+            OverFlow();
+        }
+
+        while (32 - _freeBitCount >= (_isFFWritten ? 7 : 8))
+        {
+            if (_isFFWritten)
+            {
+                *_position = static_cast<uint8_t>(_bitBuffer >> 25);
+                _bitBuffer = _bitBuffer << 7;
+                _freeBitCount += 7;
+            }
+            else
+            {
+                *_position = static_cast<uint8_t>(_bitBuffer >> 24);
+                _bitBuffer = _bitBuffer << 8;
+                _freeBitCount += 8;
+            }
+
+            _isFFWritten = *_position == 0xFF;
+            _position++;
+            _compressedLength--;
+            _bytesWritten++;
+        }
+    }
+
     std::size_t GetLength() const noexcept
     {
         return _bytesWritten - (_freeBitCount - 32) / 8;
@@ -7,23 +7,38 @@
 #include "jpegstreamreader.h"
 #include "jpegstreamwriter.h"
 #include "jpegmarkersegment.h"
+#include "jlspushdecoder.h"
+#include "jlspushencoder.h"
+#include "jlsbatch.h"
+#include "jlsexecutor.h"
+#include "chunkstreambuf.h"
+#include "callbackstreambuf.h"
+#include "jlsmappedfile.h"
+#include "jlssegmentindex.h"
+#include "jlstranscoder.h"
+#include "processlineunpack.h"
 #include <cstring>
+#include <algorithm>
 
 using namespace charls;
 
 namespace
 {
 
-void VerifyInput(const ByteStreamInfo& uncompressedStream, const JlsParameters& parameters)
+void VerifyParameters(const JlsParameters& parameters, bool heightRequired)
 {
-    if (!uncompressedStream.rawStream && !uncompressedStream.rawData)
-        throw charls_error(ApiResult::InvalidJlsParameters, "rawStream or rawData needs to reference to something");
+    // Dimensions above 65535 are stored in an oversize image dimension (LSE type 4) segment.
+    if (parameters.width < 1)
+        throw charls_error(ApiResult::InvalidJlsParameters, "width needs to be in the range [1, 2147483647]");
+
+    if (heightRequired && parameters.height < 1)
+        throw charls_error(ApiResult::InvalidJlsParameters, "height needs to be in the range [1, 2147483647]");
 
-    if (parameters.width < 1 || parameters.width > 65535)
-        throw charls_error(ApiResult::InvalidJlsParameters, "width needs to be in the range [1, 65535]");
+    if (!heightRequired && parameters.height < 0)
+        throw charls_error(ApiResult::InvalidJlsParameters, "height needs to be in the range [0, 2147483647] (0 = defined by a DNL segment)");
 
-    if (parameters.height < 1 || parameters.height > 65535)
-        throw charls_error(ApiResult::InvalidJlsParameters, "height needs to be in the range [1, 65535]");
+    if (parameters.height == 0 && parameters.interleaveMode == InterleaveMode::None && parameters.components > 1)
+        throw charls_error(ApiResult::InvalidJlsParameters, "height 0 (defined by a DNL segment) is only supported for images with 1 scan");
 
     if (parameters.bitsPerSample < 2 || parameters.bitsPerSample > 16)
         throw charls_error(ApiResult::InvalidJlsParameters, "bitspersample needs to be in the range [2, 16]");
@@ -34,11 +49,8 @@ void VerifyInput(const ByteStreamInfo& uncompressedStream, const JlsParameters&
     if (parameters.components < 1 || parameters.components > 255)
         throw charls_error(ApiResult::InvalidJlsParameters, "components needs to be in the range [1, 255]");
 
-    if (uncompressedStream.rawData)
-    {
-        if (uncompressedStream.count < static_cast<size_t>(parameters.height) * parameters.width * parameters.components * (parameters.bitsPerSample > 8 ? 2 : 1))
-            throw charls_error(ApiResult::InvalidJlsParameters, "uncompressed size does not match with the other parameters");
-    }
+    if (static_cast<int64_t>(parameters.width) * parameters.components * ((parameters.bitsPerSample + 7) / 8) > INT32_MAX)
+        throw charls_error(ApiResult::InvalidJlsParameters, "the size of a line needs to be less than 2 GiB");
 
     switch (parameters.components)
     {
@@ -56,6 +68,21 @@ void VerifyInput(const ByteStreamInfo& uncompressedStream, const JlsParameters&
 }
 
 
+void VerifyInput(const ByteStreamInfo& uncompressedStream, const JlsParameters& parameters)
+{
+    if (!uncompressedStream.rawStream && !uncompressedStream.rawData)
+        throw charls_error(ApiResult::InvalidJlsParameters, "rawStream or rawData needs to reference to something");
+
+    VerifyParameters(parameters, true);
+
+    if (uncompressedStream.rawData)
+    {
+        if (uncompressedStream.count < static_cast<size_t>(parameters.height) * parameters.width * parameters.components * (parameters.bitsPerSample > 8 ? 2 : 1))
+            throw charls_error(ApiResult::InvalidJlsParameters, "uncompressed size does not match with the other parameters");
+    }
+}
+
+
 ApiResult ResultAndErrorMessage(ApiResult result, char* errorMessage) noexcept
 {
     if (errorMessage)
@@ -90,55 +117,152 @@ ApiResult ResultAndErrorMessageFromException(char* errorMessage)
     }
 }
 
-} // namespace
 
+void AddFrameSegments(JpegStreamWriter& writer, const JlsParameters& info)
+{
+    if (info.jfif.version)
+    {
+        writer.AddSegment(JpegMarkerSegment::CreateJpegFileInterchangeFormatSegment(info.jfif));
+    }
 
-CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeStream(ByteStreamInfo compressedStreamInfo, size_t& pcbyteWritten,
-    ByteStreamInfo rawStreamInfo, const struct JlsParameters& params, char* errorMessage)
+    writer.AddStartOfFrame(info);
+
+    if (info.colorTransformation != ColorTransformation::None)
+    {
+        writer.AddColorTransform(info.colorTransformation);
+    }
+}
+
+
+// Checks the source layout and replaces the strides that are 0 by the size of a line without padding.
+JlsSourceLayout VerifySourceLayout(const JlsSourceLayout& layout, const JlsParameters& params)
 {
-    try
+    if (params.components > 4)
+        throw charls_error(ApiResult::ParameterValueNotSupported, "A source layout can only be used for images with up to 4 components");
+
+    if (layout.interleaved && (layout.channelCount < params.components || layout.channelCount > 255))
+        throw charls_error(ApiResult::InvalidJlsParameters, "channelCount needs to be in the range [components, 255]");
+
+    JlsSourceLayout result = layout;
+    const size_t bytesPerSample = (params.bitsPerSample + 7) / 8;
+    const int planeCount = layout.interleaved ? 1 : params.components;
+    for (int plane = 0; plane < planeCount; ++plane)
     {
-        VerifyInput(rawStreamInfo, params);
+        if (!layout.planes[plane])
+            throw charls_error(ApiResult::InvalidJlsParameters, "planes cannot hold NULL for a component");
 
-        JlsParameters info = params;
-        if (info.stride == 0)
+        const size_t minimumStride = static_cast<size_t>(params.width) * (layout.interleaved ? layout.channelCount : 1) * bytesPerSample;
+        if (layout.strides[plane] == 0)
         {
-            info.stride = info.width * ((info.bitsPerSample + 7)/8);
-            if (info.interleaveMode != InterleaveMode::None)
-            {
-                info.stride *= info.components;
-            }
+            result.strides[plane] = minimumStride;
         }
+        else if (layout.strides[plane] < minimumStride || layout.strides[plane] % bytesPerSample != 0)
+            throw charls_error(ApiResult::InvalidJlsParameters, "strides needs to hold 0 or a multiple of the sample size that holds a line");
+    }
 
-        JpegStreamWriter writer;
-        if (info.jfif.version)
-        {
-            writer.AddSegment(JpegMarkerSegment::CreateJpegFileInterchangeFormatSegment(info.jfif));
-        }
+    for (int component = 0; layout.interleaved && component < params.components; ++component)
+    {
+        const int channel = layout.componentChannels[component];
+        if (channel < 0 || channel >= layout.channelCount || std::count(layout.componentChannels, layout.componentChannels + params.components, channel) != 1)
+            throw charls_error(ApiResult::InvalidJlsParameters, "componentChannels needs to hold a different channel for every component");
+    }
+
+    return result;
+}
 
-        writer.AddSegment(JpegMarkerSegment::CreateStartOfFrameSegment(info.width, info.height, info.bitsPerSample, info.components));
 
-        if (info.colorTransformation != ColorTransformation::None)
-        {
-            writer.AddColorTransform(info.colorTransformation);
-        }
+// Worst case size of a complete JPEG-LS stream: the marker segments (see JpegMarkerSegment) and the worst case size
+// of the encoded lines of every scan.
+std::size_t MaximumEncodedByteCount(const JlsParameters& params, const JlsMappingTable* mappingTable = nullptr) noexcept
+{
+    const std::size_t scanCount = params.interleaveMode == InterleaveMode::None ? params.components : 1;
+    const std::size_t scanComponentCount = params.interleaveMode == InterleaveMode::None ? 1 : params.components;
+    const std::size_t lineCount = params.height != 0 ? params.height : UINT16_MAX;
+
+    std::size_t size = 2 + 2 + 6; // SOI, EOI, DNL
+    if (params.jfif.version)
+    {
+        size += 2 + 2 + 14 + static_cast<std::size_t>(3) * params.jfif.Xthumbnail * params.jfif.Ythumbnail;
+    }
+    size += 2 + 2 + 6 + static_cast<std::size_t>(3) * params.components; // SOF
+    size += 2 + 2 + 2 + 2 * 4; // LSE (oversize image dimension)
+    size += 2 + 2 + 5; // HP color transform (mrfx)
+    size += scanCount * (2 + 2 + 11); // LSE (preset parameters)
+    size += scanCount * (2 + 2 + 4 + 2 * scanComponentCount); // SOS
+    size += scanCount * lineCount * MaximumEncodedLineByteCount(params);
+    if (mappingTable)
+    {
+        // LSE (mapping table), split in continuation segments as done by JpegStreamWriter::AddMappingTable.
+        const std::size_t entriesByteCount = static_cast<std::size_t>(mappingTable->entryCount) * mappingTable->entryWidth;
+        const std::size_t segmentByteCount = (UINT16_MAX - 2 - 3) / mappingTable->entryWidth * mappingTable->entryWidth;
+        size += entriesByteCount + (entriesByteCount + segmentByteCount - 1) / segmentByteCount * (2 + 2 + 3);
+    }
+    return size;
+}
+
+
+void VerifyMappingTable(const JlsMappingTable& mappingTable)
+{
+    if (!mappingTable.entries || mappingTable.tableId < 1 || mappingTable.tableId > UINT8_MAX ||
+        mappingTable.entryWidth < 1 || mappingTable.entryWidth > UINT8_MAX || mappingTable.entryCount < 1)
+        throw charls_error(ApiResult::InvalidJlsParameters, "Invalid mapping table");
+}
+
+size_t EncodeStream(ByteStreamInfo compressedStreamInfo, ByteStreamInfo rawStreamInfo, const JlsParameters& params, const JlsMappingTable* mappingTable,
+    const JlsExecutor* pipelineExecutor = nullptr)
+{
+    VerifyInput(rawStreamInfo, params);
 
-        if (info.interleaveMode == InterleaveMode::None)
+    JlsParameters info = params;
+    if (info.stride == 0)
+    {
+        info.stride = info.width * ((info.bitsPerSample + 7)/8);
+        if (info.interleaveMode != InterleaveMode::None)
         {
-            const int32_t cbyteComp = info.width * info.height * ((info.bitsPerSample + 7) / 8);
-            for (int32_t component = 0; component < info.components; ++component)
-            {
-                writer.AddScan(rawStreamInfo, info);
-                SkipBytes(rawStreamInfo, cbyteComp);
-            }
+            info.stride *= info.components;
         }
-        else
+    }
+
+    JpegStreamWriter writer;
+    AddFrameSegments(writer, info);
+
+    if (pipelineExecutor)
+    {
+        writer.SetPipelineExecutor(*pipelineExecutor);
+    }
+
+    if (mappingTable)
+    {
+        writer.AddMappingTable(*mappingTable);
+    }
+
+    if (info.interleaveMode == InterleaveMode::None)
+    {
+        const size_t cbyteComp = static_cast<size_t>(info.width) * info.height * ((info.bitsPerSample + 7) / 8);
+        for (int32_t component = 0; component < info.components; ++component)
         {
             writer.AddScan(rawStreamInfo, info);
+            SkipBytes(rawStreamInfo, cbyteComp);
         }
+    }
+    else
+    {
+        writer.AddScan(rawStreamInfo, info);
+    }
 
-        writer.Write(compressedStreamInfo);
-        pcbyteWritten = writer.GetBytesWritten();
+    writer.Write(compressedStreamInfo);
+    return writer.GetBytesWritten();
+}
+
+} // namespace
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeStream(ByteStreamInfo compressedStreamInfo, size_t& pcbyteWritten,
+    ByteStreamInfo rawStreamInfo, const struct JlsParameters& params, char* errorMessage)
+{
+    try
+    {
+        pcbyteWritten = EncodeStream(compressedStreamInfo, rawStreamInfo, params, nullptr);
 
         return ResultAndErrorMessage(ApiResult::OK, errorMessage);
     }
@@ -171,6 +295,46 @@ CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeStream(ByteStreamInfo rawStream,
 }
 
 
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeStreamPipelined(ByteStreamInfo compressedStreamInfo, size_t& bytesWritten,
+    ByteStreamInfo rawStreamInfo, const JlsParameters& params, const JlsExecutor* executor, char* errorMessage)
+{
+    try
+    {
+        bytesWritten = EncodeStream(compressedStreamInfo, rawStreamInfo, params, nullptr, &GetExecutor(executor));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeStreamPipelined(ByteStreamInfo rawStream, ByteStreamInfo compressedStream, const JlsParameters* info,
+    const JlsExecutor* executor, char* errorMessage)
+{
+    try
+    {
+        JpegStreamReader reader(compressedStream);
+
+        if (info)
+        {
+            reader.SetInfo(*info);
+        }
+
+        reader.SetPipelineExecutor(GetExecutor(executor));
+        reader.Read(rawStream);
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
 CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsReadHeaderStream(ByteStreamInfo rawStreamInfo, JlsParameters* params, char* errorMessage)
 {
     try
@@ -202,6 +366,190 @@ CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncode(void* destination, size_t desti
 }
 
 
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeToChunks(JlsAllocateChunkCallback allocateChunk, void* allocatorContext,
+    size_t* bytesWritten, const void* source, size_t sourceLength, const struct JlsParameters* params, char* errorMessage)
+{
+    if (!allocateChunk || !bytesWritten || !source || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    // Note: JpegStreamWriter doesn't count the bytes written to a stream, the stream buffer does.
+    ChunkStreamBuf chunks(allocateChunk, allocatorContext);
+    size_t byteCount;
+    const ApiResult result = JpegLsEncodeStream({&chunks, nullptr, 0}, byteCount, FromByteArrayConst(source, sourceLength), *params, errorMessage);
+    *bytesWritten = chunks.GetBytesWritten();
+    return result;
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeFile(const char* destinationPath, const char* sourcePath,
+    const struct JlsParameters* params, size_t* bytesWritten, char* errorMessage)
+{
+    if (!destinationPath || !sourcePath || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyParameters(*params, true);
+
+        JlsMappedFile source;
+        source.OpenForReading(sourcePath);
+
+        JlsMappedFile destination;
+        destination.CreateForWriting(destinationPath, MaximumEncodedByteCount(*params));
+
+        size_t byteCount = 0;
+        const ApiResult result = JpegLsEncodeStream(FromByteArray(destination.GetData(), destination.GetSize()), byteCount,
+            FromByteArray(source.GetData(), source.GetSize()), *params, errorMessage);
+        if (result == ApiResult::OK)
+        {
+            destination.Commit(byteCount);
+        }
+
+        if (bytesWritten)
+        {
+            *bytesWritten = result == ApiResult::OK ? byteCount : 0;
+        }
+
+        return result;
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeCallbackStream(const struct JlsStreamCallbacks* destination, size_t* bytesWritten,
+    const struct JlsStreamCallbacks* source, const struct JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !destination->write || !bytesWritten || !source || !source->read || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        CallbackStreamBuf destinationStream(*destination);
+        CallbackStreamBuf sourceStream(*source);
+
+        const ApiResult result = JpegLsEncodeStream({&destinationStream, nullptr, 0, destination->blockSize}, *bytesWritten,
+            {&sourceStream, nullptr, 0, source->blockSize}, *params, errorMessage);
+        if (result != ApiResult::OK)
+            return result;
+
+        destinationStream.pubsync();
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeCallbackStream(const struct JlsStreamCallbacks* destination,
+    const struct JlsStreamCallbacks* source, const struct JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !destination->write || !source || !source->read)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        CallbackStreamBuf destinationStream(*destination);
+        CallbackStreamBuf sourceStream(*source);
+
+        const ApiResult result = JpegLsDecodeStream({&destinationStream, nullptr, 0, destination->blockSize}, {&sourceStream, nullptr, 0, source->blockSize}, params, errorMessage);
+        if (result != ApiResult::OK)
+            return result;
+
+        destinationStream.pubsync();
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsReadHeaderCallbackStream(const struct JlsStreamCallbacks* source,
+    struct JlsParameters* params, char* errorMessage)
+{
+    if (!source || !source->read || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        // Unbuffered: a callback source cannot take back bytes that were read beyond the header.
+        CallbackStreamBuf sourceStream(*source, 1);
+        return JpegLsReadHeaderStream({&sourceStream, nullptr, 0}, params, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeFile(const char* destinationPath, const char* sourcePath,
+    const struct JlsParameters* params, char* errorMessage)
+{
+    if (!destinationPath || !sourcePath)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JlsMappedFile source;
+        source.OpenForReading(sourcePath);
+
+        JlsParameters header{};
+        const ApiResult result = JpegLsReadHeader(source.GetData(), source.GetSize(), &header, errorMessage);
+        if (result != ApiResult::OK)
+            return result;
+
+        // When the height is defined by a DNL segment, the file is created for the maximum height and truncated after decoding.
+        const size_t bytesPerLine = static_cast<size_t>(header.width) * header.components * ((header.bitsPerSample + 7) / 8);
+        const size_t lineCount = header.height != 0 ? header.height : UINT16_MAX;
+
+        JlsMappedFile destination;
+        destination.CreateForWriting(destinationPath, bytesPerLine * lineCount);
+
+        JpegStreamReader reader(FromByteArray(source.GetData(), source.GetSize()));
+        if (params)
+        {
+            JlsParameters info = *params;
+            info.stride = 0;
+            reader.SetInfo(info);
+        }
+
+        reader.Read(FromByteArray(destination.GetData(), destination.GetSize()));
+        destination.Commit(bytesPerLine * reader.GetMetadata().height);
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsGetMaximumEncodedSize(const struct JlsParameters* params, size_t* size, char* errorMessage)
+{
+    if (!params || !size)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyParameters(*params, false);
+        *size = MaximumEncodedByteCount(*params);
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
 CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsReadHeader(const void* compressedData, size_t compressedLength, JlsParameters* params, char* errorMessage)
 {
     return JpegLsReadHeaderStream(FromByteArrayConst(compressedData, compressedLength), params, errorMessage);
@@ -243,4 +591,721 @@ CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeRect(void* uncompressedData, siz
     }
 }
 
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeComponents(void* destination, size_t destinationLength,
+    const void* source, size_t sourceLength, unsigned int componentMask, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !source)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(FromByteArrayConst(source, sourceLength));
+
+        if (params)
+        {
+            reader.SetInfo(*params);
+        }
+
+        reader.SetComponentMask(componentMask);
+        reader.Read(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeMapped(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, const JlsParameters* params, const JlsMappingTable* mappingTable, char* errorMessage)
+{
+    if (!destination || !bytesWritten || !source || !params || !mappingTable || !mappingTable->entries)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyMappingTable(*mappingTable);
+        *bytesWritten = EncodeStream(FromByteArray(destination, destinationLength), FromByteArrayConst(source, sourceLength), *params, mappingTable);
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsGetMaximumEncodedMappedSize(const struct JlsParameters* params,
+    const struct JlsMappingTable* mappingTable, size_t* size, char* errorMessage)
+{
+    if (!params || !mappingTable || !size)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyParameters(*params, false);
+        VerifyMappingTable(*mappingTable);
+        *size = MaximumEncodedByteCount(*params, mappingTable);
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsReadMappingTable(const void* source, size_t sourceLength, JlsMappingTable* mappingTable,
+    void* entries, size_t entriesLength, char* errorMessage)
+{
+    if (!source || !mappingTable)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(FromByteArrayConst(source, sourceLength));
+        reader.ReadHeader();
+        reader.ReadStartOfScan(true);
+
+        *mappingTable = JlsMappingTable();
+        const MappingTable* table = reader.GetMappingTable();
+        if (table)
+        {
+            mappingTable->tableId = table->tableId;
+            mappingTable->entryWidth = table->entryWidth;
+            mappingTable->entryCount = table->GetEntryCount();
+            if (entries)
+            {
+                if (entriesLength < table->entries.size())
+                    throw charls_error(ApiResult::UncompressedBufferTooSmall);
+
+                table->CopyEntries(entries);
+                mappingTable->entries = entries;
+            }
+        }
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeMapped(void* destination, size_t destinationLength,
+    const void* source, size_t sourceLength, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !source)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(FromByteArrayConst(source, sourceLength));
+
+        if (params)
+        {
+            reader.SetInfo(*params);
+        }
+
+        reader.SetApplyMappingTable(true);
+        reader.Read(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsTranscode(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !bytesWritten || !source || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader headerReader(FromByteArrayConst(source, sourceLength));
+        headerReader.ReadHeader();
+        headerReader.ReadStartOfScan(true);
+        const JlsParameters sourceParams = headerReader.GetMetadata();
+
+        JlsParameters transcodedParams = *params;
+        transcodedParams.width = sourceParams.width;
+        transcodedParams.height = sourceParams.height;
+        transcodedParams.bitsPerSample = sourceParams.bitsPerSample;
+        transcodedParams.components = sourceParams.components;
+        VerifyParameters(transcodedParams, false);
+
+        JlsTranscoder transcoder(static_cast<const uint8_t*>(source), sourceLength, sourceParams, transcodedParams);
+        *bytesWritten = transcoder.Transcode(static_cast<uint8_t*>(destination), destinationLength);
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeReduced(void* destination, size_t destinationLength, const void* source, size_t sourceLength,
+    const JlsReducedImage* reducedImages, size_t reducedImageCount, const JlsParameters* params, char* errorMessage)
+{
+    if ((!destination && destinationLength != 0) || !source || !reducedImages || reducedImageCount == 0)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(FromByteArrayConst(source, sourceLength));
+
+        if (params)
+        {
+            reader.SetInfo(*params);
+        }
+
+        reader.SetReducedImages(reducedImages, reducedImageCount);
+        reader.Read(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeTransformed(void* destination, size_t destinationLength, const void* source, size_t sourceLength,
+    const JlsSampleTransform* transform, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !source || !transform)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(FromByteArrayConst(source, sourceLength));
+
+        if (params)
+        {
+            reader.SetInfo(*params);
+        }
+
+        reader.SetSampleTransform(*transform);
+        reader.Read(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeLayout(void* destination, size_t destinationLength, const void* source, size_t sourceLength,
+    const JlsPixelLayout* layout, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !source || !layout)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(FromByteArrayConst(source, sourceLength));
+
+        if (params)
+        {
+            reader.SetInfo(*params);
+        }
+
+        reader.SetPixelLayout(*layout);
+        reader.Read(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsGetSegmentIndex(const void* source, size_t sourceLength,
+    JlsSegmentInfo* segments, size_t segmentCapacity, size_t* segmentCount, char* errorMessage)
+{
+    if (!source || (!segments && segmentCapacity != 0) || !segmentCount)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        const std::vector<JlsSegmentInfo> index = BuildSegmentIndex(static_cast<const uint8_t*>(source), sourceLength);
+        std::copy(index.begin(), index.begin() + std::min(index.size(), segmentCapacity), segments);
+        *segmentCount = index.size();
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsReadHeaderFragments(const JlsFragment* fragments, size_t fragmentCount,
+    JlsParameters* params, char* errorMessage)
+{
+    if (!fragments || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(fragments, fragmentCount);
+        reader.ReadHeader();
+        reader.ReadStartOfScan(true);
+        *params = reader.GetMetadata();
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeFragments(void* destination, size_t destinationLength,
+    const JlsFragment* fragments, size_t fragmentCount, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !fragments)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(fragments, fragmentCount);
+
+        if (params)
+        {
+            reader.SetInfo(*params);
+        }
+
+        reader.Read(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeWithCallback(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const JlsParameters* params, JlsLineRequestedCallback lineRequested, void* context, char* errorMessage)
+{
+    if (!destination || !bytesWritten || !params || !lineRequested)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyParameters(*params, true);
+
+        JpegStreamWriter writer;
+        AddFrameSegments(writer, *params);
+
+        const int32_t scanCount = params->interleaveMode == InterleaveMode::None ? params->components : 1;
+        for (int32_t scan = 0; scan < scanCount; ++scan)
+        {
+            writer.AddScan(lineRequested, context, *params);
+        }
+
+        *bytesWritten = writer.Write(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeLayout(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const JlsSourceLayout* layout, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !bytesWritten || !layout || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyParameters(*params, true);
+        const JlsSourceLayout sourceLayout = VerifySourceLayout(*layout, *params);
+
+        JpegStreamWriter writer;
+        AddFrameSegments(writer, *params);
+
+        const int32_t scanCount = params->interleaveMode == InterleaveMode::None ? params->components : 1;
+        for (int32_t scan = 0; scan < scanCount; ++scan)
+        {
+            writer.AddScan(sourceLayout, scan, *params);
+        }
+
+        *bytesWritten = writer.Write(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodeFormat(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, SourceFormat sourceFormat, const JlsParameters* params, char* errorMessage)
+{
+    if (!destination || !bytesWritten || !source || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyParameters(*params, true);
+
+        switch (sourceFormat)
+        {
+        case SourceFormat::Native:
+        case SourceFormat::PackedLsb:
+            break;
+
+        case SourceFormat::BigEndian16:
+        case SourceFormat::MsbAligned16:
+        case SourceFormat::MsbAlignedBigEndian16:
+            if (params->bitsPerSample <= 8)
+                throw charls_error(ApiResult::InvalidJlsParameters, "a 16 bit source format requires more than 8 bits per sample");
+            break;
+
+        default:
+            throw charls_error(ApiResult::InvalidJlsParameters, "sourceFormat is not a valid source format");
+        }
+
+        const int32_t scanCount = params->interleaveMode == InterleaveMode::None ? params->components : 1;
+        const int32_t componentsPerLine = params->components / scanCount;
+        const size_t lineByteCount = GetSourceLineByteCount(sourceFormat, static_cast<size_t>(params->width) * componentsPerLine, params->bitsPerSample);
+
+        JlsParameters sourceParams = *params;
+        if (sourceParams.stride == 0)
+        {
+            sourceParams.stride = static_cast<int32_t>(lineByteCount);
+        }
+        else if (static_cast<size_t>(sourceParams.stride) < lineByteCount)
+            throw charls_error(ApiResult::InvalidJlsParameters, "stride is smaller than a line in the source format");
+
+        const size_t planeSize = static_cast<size_t>(sourceParams.stride) * params->height;
+        if (sourceLength < (scanCount - 1) * planeSize + planeSize - sourceParams.stride + lineByteCount)
+            throw charls_error(ApiResult::UncompressedBufferTooSmall);
+
+        JpegStreamWriter writer;
+        AddFrameSegments(writer, *params);
+
+        const auto sourceBytes = static_cast<const uint8_t*>(source);
+        for (int32_t scan = 0; scan < scanCount; ++scan)
+        {
+            const size_t offset = scan * planeSize;
+            writer.AddScan(FromByteArrayConst(sourceBytes + offset, sourceLength - offset), sourceParams, sourceFormat);
+        }
+
+        *bytesWritten = writer.Write(FromByteArray(destination, destinationLength));
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodeWithCallback(const void* source, size_t sourceLength,
+    const JlsParameters* params, JlsLineDecodedCallback lineDecoded, void* context, char* errorMessage)
+{
+    if (!source || !lineDecoded)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        JpegStreamReader reader(FromByteArrayConst(source, sourceLength));
+
+        if (params)
+        {
+            reader.SetInfo(*params);
+        }
+
+        reader.SetLineCallback(lineDecoded, context);
+        reader.Read(ByteStreamInfo());
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsEncodePipelined(void* destination, size_t destinationLength, size_t* bytesWritten,
+    const void* source, size_t sourceLength, const JlsParameters* params, const JlsExecutor* executor, char* errorMessage)
+{
+    if (!destination || !bytesWritten || !source || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    return JpegLsEncodeStreamPipelined(FromByteArray(destination, destinationLength), *bytesWritten, FromByteArrayConst(source, sourceLength), *params, executor, errorMessage);
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsDecodePipelined(void* destination, size_t destinationLength, const void* source, size_t sourceLength,
+    const JlsParameters* params, const JlsExecutor* executor, char* errorMessage)
+{
+    return JpegLsDecodeStreamPipelined(FromByteArray(destination, destinationLength), FromByteArrayConst(source, sourceLength), params, executor, errorMessage);
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(JlsBatch*) JpegLsDecodeBatchAsync(JlsDecodeJob* jobs, size_t jobCount, int workerCount,
+    const JlsExecutor* executor, JlsBatchCompletedCallback completed, void* context)
+{
+    if (!jobs && jobCount != 0)
+        return nullptr;
+
+    try
+    {
+        return new JlsBatch(jobCount, [jobs](size_t jobIndex)
+        {
+            JlsDecodeJob& job = jobs[jobIndex];
+            job.result = JpegLsDecode(job.destination, job.destinationLength, job.source, job.sourceLength, job.params, nullptr);
+        }, workerCount, GetExecutor(executor), completed, context);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(JlsBatch*) JpegLsEncodeBatchAsync(JlsEncodeJob* jobs, size_t jobCount, int workerCount,
+    const JlsExecutor* executor, JlsBatchCompletedCallback completed, void* context)
+{
+    if (!jobs && jobCount != 0)
+        return nullptr;
+
+    try
+    {
+        return new JlsBatch(jobCount, [jobs](size_t jobIndex)
+        {
+            JlsEncodeJob& job = jobs[jobIndex];
+            job.bytesWritten = 0;
+            job.result = JpegLsEncode(job.destination, job.destinationLength, &job.bytesWritten, job.source, job.sourceLength, job.params, nullptr);
+        }, workerCount, GetExecutor(executor), completed, context);
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsBatchWait(JlsBatch* batch)
+{
+    if (batch)
+    {
+        batch->Wait();
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsBatchDestroy(JlsBatch* batch)
+{
+    delete batch;
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsSetExecutor(const JlsExecutor* executor)
+{
+    SetGlobalExecutor(executor);
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(const JlsExecutor*) JpegLsGetSerialExecutor()
+{
+    return &GetSerialExecutor();
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(JlsExecutor*) JpegLsCreateThreadExecutor(int threadCount)
+{
+    try
+    {
+        return (new ThreadExecutor(threadCount))->GetExecutor();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsDestroyThreadExecutor(JlsExecutor* executor)
+{
+    if (executor)
+    {
+        delete ThreadExecutor::FromExecutor(executor);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsPushDecoderCreate(const JlsParameters* params, JlsPushDecoder** decoder, char* errorMessage)
+{
+    if (!decoder)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        *decoder = new JlsPushDecoder(params);
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsPushDecoderDestroy(JlsPushDecoder* decoder)
+{
+    delete decoder;
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsPushDecoderAddBytes(JlsPushDecoder* decoder, const void* source, size_t sourceLength,
+    size_t* decodedLineCount, char* errorMessage)
+{
+    if (!decoder || (!source && sourceLength != 0))
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        decoder->AddBytes(static_cast<const uint8_t*>(source), sourceLength);
+        if (decodedLineCount)
+        {
+            *decodedLineCount = decoder->GetDecodedLineCount();
+        }
+
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsPushDecoderReadHeader(JlsPushDecoder* decoder, JlsParameters* params, char* errorMessage)
+{
+    if (!decoder || !params)
+        return ApiResult::InvalidJlsParameters;
+
+    if (!decoder->IsHeaderRead())
+        return ResultAndErrorMessage(ApiResult::CompressedBufferTooSmall, errorMessage);
+
+    *params = decoder->GetMetadata();
+    return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsPushDecoderSetDestination(JlsPushDecoder* decoder, void* destination, size_t destinationLength, char* errorMessage)
+{
+    if (!decoder || !destination)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        decoder->SetDestination(FromByteArray(destination, destinationLength));
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsPushEncoderCreate(const JlsParameters* params, JlsPushEncoder** encoder, char* errorMessage)
+{
+    if (!params || !encoder)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        VerifyParameters(*params, false);
+        *encoder = new JlsPushEncoder(*params);
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(void) JpegLsPushEncoderDestroy(JlsPushEncoder* encoder)
+{
+    delete encoder;
+}
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsPushEncoderEncodeLines(JlsPushEncoder* encoder, const void* source, size_t sourceLength,
+    void* destination, size_t destinationLength, size_t* bytesWritten, char* errorMessage)
+{
+    if (!encoder || (!source && sourceLength != 0) || (!destination && destinationLength != 0) || !bytesWritten)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        encoder->EncodeLines(static_cast<const uint8_t*>(source), sourceLength);
+        *bytesWritten = encoder->TakeBytes(static_cast<uint8_t*>(destination), destinationLength);
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
+
+
+CHARLS_DLL_IMPORT_EXPORT(ApiResult) JpegLsPushEncoderFinish(JlsPushEncoder* encoder, void* destination, size_t destinationLength,
+    size_t* bytesWritten, char* errorMessage)
+{
+    if (!encoder || (!destination && destinationLength != 0) || !bytesWritten)
+        return ApiResult::InvalidJlsParameters;
+
+    try
+    {
+        encoder->Finish();
+        *bytesWritten = encoder->TakeBytes(static_cast<uint8_t*>(destination), destinationLength);
+        return ResultAndErrorMessage(ApiResult::OK, errorMessage);
+    }
+    catch (...)
+    {
+        return ResultAndErrorMessageFromException(errorMessage);
+    }
+}
+
 }
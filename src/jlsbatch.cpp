@@ -0,0 +1,115 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "jlsbatch.h"
+#include <algorithm>
+
+
+JlsBatch::JlsBatch(std::size_t jobCount, std::function<void(std::size_t)> runJob, int workerCount, const JlsExecutor& executor,
+    JlsBatchCompletedCallback completed, void* context) :
+    _runJob(std::move(runJob)),
+    _completed(completed),
+    _context(context),
+    _remainingJobCount(jobCount),
+    _taskGroup(executor)
+{
+    if (jobCount == 0)
+    {
+        Complete();
+        return;
+    }
+
+    std::size_t queueCount = workerCount > 0 ? static_cast<std::size_t>(workerCount) : std::max(1U, std::thread::hardware_concurrency());
+    queueCount = std::min(queueCount, jobCount);
+
+    // Distribute the jobs in contiguous ranges: neighbouring frames are often similar in size.
+    for (std::size_t worker = 0; worker < queueCount; ++worker)
+    {
+        _queues.push_back(std::make_unique<WorkerQueue>());
+        _queues.back()->batch = this;
+        _queues.back()->workerIndex = worker;
+        for (std::size_t job = jobCount * worker / queueCount; job < jobCount * (worker + 1) / queueCount; ++job)
+        {
+            _queues.back()->jobs.push_back(job);
+        }
+    }
+
+    // All queues must be filled before the first task starts: a serial executor runs the task during Submit.
+    for (const auto& queue : _queues)
+    {
+        _taskGroup.Submit(RunWorkerTask, queue.get());
+    }
+}
+
+
+JlsBatch::~JlsBatch()
+{
+    Wait();
+}
+
+
+void JlsBatch::Wait()
+{
+    _taskGroup.Wait();
+}
+
+
+void JlsBatch::RunWorkerTask(void* taskContext)
+{
+    const auto queue = static_cast<WorkerQueue*>(taskContext);
+    queue->batch->RunWorker(queue->workerIndex);
+}
+
+
+void JlsBatch::RunWorker(std::size_t workerIndex)
+{
+    std::size_t jobIndex;
+    while (TryTakeJob(workerIndex, jobIndex))
+    {
+        _runJob(jobIndex);
+        if (--_remainingJobCount == 0)
+        {
+            Complete();
+        }
+    }
+}
+
+
+bool JlsBatch::TryTakeJob(std::size_t workerIndex, std::size_t& jobIndex)
+{
+    {
+        WorkerQueue& own = *_queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty())
+        {
+            jobIndex = own.jobs.front();
+            own.jobs.pop_front();
+            return true;
+        }
+    }
+
+    // No jobs are added after the start: when all queues are empty the worker is done.
+    for (std::size_t i = 1; i < _queues.size(); ++i)
+    {
+        WorkerQueue& victim = *_queues[(workerIndex + i) % _queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty())
+        {
+            jobIndex = victim.jobs.back();
+            victim.jobs.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+void JlsBatch::Complete()
+{
+    if (_completed)
+    {
+        _completed(_context);
+    }
+}
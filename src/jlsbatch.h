@@ -0,0 +1,59 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_JLS_BATCH
+#define CHARLS_JLS_BATCH
+
+#include "charls.h"
+#include "jlsexecutor.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+
+//
+// JlsBatch: runs a number of independent jobs (encode or decode a complete image) as worker tasks on an executor.
+// Every worker starts with an equal share of the jobs; a worker that has finished its own jobs steals jobs from
+// the back of the queues of the other workers. The completion callback is called by the thread that finishes the last job.
+//
+class JlsBatch
+{
+public:
+    JlsBatch(std::size_t jobCount, std::function<void(std::size_t)> runJob, int workerCount, const JlsExecutor& executor,
+        JlsBatchCompletedCallback completed, void* context);
+    ~JlsBatch();
+
+    JlsBatch(const JlsBatch&) = delete;
+    JlsBatch(JlsBatch&&) = delete;
+    JlsBatch& operator=(const JlsBatch&) = delete;
+    JlsBatch& operator=(JlsBatch&&) = delete;
+
+    void Wait();
+
+private:
+    struct WorkerQueue
+    {
+        JlsBatch* batch;
+        std::size_t workerIndex;
+        std::mutex mutex;
+        std::deque<std::size_t> jobs;
+    };
+
+    static void RunWorkerTask(void* taskContext);
+    void RunWorker(std::size_t workerIndex);
+    bool TryTakeJob(std::size_t workerIndex, std::size_t& jobIndex);
+    void Complete();
+
+    std::function<void(std::size_t)> _runJob;
+    JlsBatchCompletedCallback _completed;
+    void* _context;
+    std::vector<std::unique_ptr<WorkerQueue>> _queues;
+    std::atomic<std::size_t> _remainingJobCount;
+    TaskGroup _taskGroup;
+};
+
+#endif
@@ -0,0 +1,189 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "jlsexecutor.h"
+#include <algorithm>
+#include <atomic>
+
+namespace
+{
+
+std::atomic<const JlsExecutor*> globalExecutor(nullptr);
+
+
+void SubmitSerial(void* /*context*/, void* /*group*/, JlsTaskFunction task, void* taskContext)
+{
+    task(taskContext);
+}
+
+
+void* CreateGroupSerial(void* /*context*/) noexcept
+{
+    return nullptr;
+}
+
+
+void WaitSerial(void* /*context*/, void* /*group*/) noexcept
+{
+}
+
+
+const JlsExecutor serialExecutor = { nullptr, CreateGroupSerial, SubmitSerial, WaitSerial };
+
+} // namespace
+
+
+ThreadExecutor::ThreadExecutor(int threadCount) :
+    _executor{this, CreateGroup, Submit, Wait},
+    _stop(false)
+{
+    const unsigned int count = threadCount > 0 ? static_cast<unsigned int>(threadCount) : std::max(1U, std::thread::hardware_concurrency());
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        _threads.emplace_back(&ThreadExecutor::RunWorker, this);
+    }
+}
+
+
+ThreadExecutor::~ThreadExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _taskAvailable.notify_all();
+
+    for (auto& thread : _threads)
+    {
+        thread.join();
+    }
+}
+
+
+void* ThreadExecutor::CreateGroup(void* /*context*/)
+{
+    return new Group{0};
+}
+
+
+void ThreadExecutor::Submit(void* context, void* group, JlsTaskFunction task, void* taskContext)
+{
+    auto executor = static_cast<ThreadExecutor*>(context);
+    {
+        std::lock_guard<std::mutex> lock(executor->_mutex);
+        static_cast<Group*>(group)->pendingTaskCount++;
+        executor->_tasks.push_back({task, taskContext, static_cast<Group*>(group)});
+    }
+    executor->_taskAvailable.notify_one();
+}
+
+
+void ThreadExecutor::Wait(void* context, void* group)
+{
+    auto executor = static_cast<ThreadExecutor*>(context);
+    auto taskGroup = static_cast<Group*>(group);
+    {
+        std::unique_lock<std::mutex> lock(executor->_mutex);
+        while (taskGroup->pendingTaskCount != 0)
+        {
+            // Help to execute the queued tasks instead of blocking a (possibly pool) thread.
+            if (!executor->_tasks.empty())
+            {
+                executor->RunTask(lock);
+            }
+            else
+            {
+                executor->_taskCompleted.wait(lock);
+            }
+        }
+    }
+
+    delete taskGroup;
+}
+
+
+void ThreadExecutor::RunWorker()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    for (;;)
+    {
+        _taskAvailable.wait(lock, [this] { return _stop || !_tasks.empty(); });
+        if (_tasks.empty())
+            return;
+
+        RunTask(lock);
+    }
+}
+
+
+void ThreadExecutor::RunTask(std::unique_lock<std::mutex>& lock)
+{
+    const Task task = _tasks.front();
+    _tasks.pop_front();
+
+    lock.unlock();
+    task.function(task.context);
+    lock.lock();
+
+    task.group->pendingTaskCount--;
+    _taskCompleted.notify_all();
+}
+
+
+TaskGroup::TaskGroup(const JlsExecutor& executor) :
+    _executor(executor),
+    _group(executor.createGroup(executor.context))
+{
+}
+
+
+TaskGroup::~TaskGroup()
+{
+    Wait();
+}
+
+
+void TaskGroup::Submit(JlsTaskFunction task, void* context) const
+{
+    _executor.submit(_executor.context, _group, task, context);
+}
+
+
+void TaskGroup::Wait()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_group == this)
+        return;
+
+    _executor.wait(_executor.context, _group);
+
+    // The group is released by wait: mark it as done.
+    _group = this;
+}
+
+
+const JlsExecutor& GetExecutor(const JlsExecutor* executor)
+{
+    if (executor)
+        return *executor;
+
+    executor = globalExecutor.load();
+    if (executor)
+        return *executor;
+
+    static ThreadExecutor defaultExecutor(0);
+    return *defaultExecutor.GetExecutor();
+}
+
+
+void SetGlobalExecutor(const JlsExecutor* executor) noexcept
+{
+    globalExecutor = executor;
+}
+
+
+const JlsExecutor& GetSerialExecutor() noexcept
+{
+    return serialExecutor;
+}
@@ -0,0 +1,102 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_JLS_EXECUTOR
+#define CHARLS_JLS_EXECUTOR
+
+#include "charls.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//
+// ThreadExecutor: the default JlsExecutor implementation, a fixed pool of std::thread workers that share a task queue.
+// A thread that waits for a group executes queued tasks itself, waiting from a task cannot deadlock the pool.
+//
+class ThreadExecutor
+{
+public:
+    explicit ThreadExecutor(int threadCount);
+    ~ThreadExecutor();
+
+    ThreadExecutor(const ThreadExecutor&) = delete;
+    ThreadExecutor(ThreadExecutor&&) = delete;
+    ThreadExecutor& operator=(const ThreadExecutor&) = delete;
+    ThreadExecutor& operator=(ThreadExecutor&&) = delete;
+
+    JlsExecutor* GetExecutor() noexcept
+    {
+        return &_executor;
+    }
+
+    static ThreadExecutor* FromExecutor(const JlsExecutor* executor) noexcept
+    {
+        return static_cast<ThreadExecutor*>(executor->context);
+    }
+
+private:
+    struct Group
+    {
+        std::size_t pendingTaskCount;
+    };
+
+    struct Task
+    {
+        JlsTaskFunction function;
+        void* context;
+        Group* group;
+    };
+
+    static void* CreateGroup(void* context);
+    static void Submit(void* context, void* group, JlsTaskFunction task, void* taskContext);
+    static void Wait(void* context, void* group);
+
+    void RunWorker();
+    void RunTask(std::unique_lock<std::mutex>& lock);
+
+    JlsExecutor _executor;
+    std::mutex _mutex;
+    std::condition_variable _taskAvailable;
+    std::condition_variable _taskCompleted;
+    std::deque<Task> _tasks;
+    std::vector<std::thread> _threads;
+    bool _stop;
+};
+
+
+//
+// TaskGroup: submits tasks to an executor and waits for their completion (RAII wrapper for the C executor interface).
+//
+class TaskGroup
+{
+public:
+    explicit TaskGroup(const JlsExecutor& executor);
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup(TaskGroup&&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+    TaskGroup& operator=(TaskGroup&&) = delete;
+
+    void Submit(JlsTaskFunction task, void* context) const;
+    void Wait();
+
+private:
+    const JlsExecutor& _executor;
+    void* _group;
+    std::mutex _mutex;
+};
+
+
+// Returns the executor passed to a function or, when NULL, the globally registered executor.
+const JlsExecutor& GetExecutor(const JlsExecutor* executor);
+
+void SetGlobalExecutor(const JlsExecutor* executor) noexcept;
+
+const JlsExecutor& GetSerialExecutor() noexcept;
+
+#endif
@@ -0,0 +1,263 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "jlsmappedfile.h"
+#include "util.h"
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace charls;
+
+namespace
+{
+
+void ThrowFileError(const char* operation, const char* path)
+{
+    throw charls_error(ApiResult::UnspecifiedFailure, std::string("Failed to ") + operation + " file " + path);
+}
+
+
+std::string GetTemporaryPath(const char* path)
+{
+    return std::string(path) + ".partial";
+}
+
+} // namespace
+
+
+#ifdef _WIN32
+
+JlsMappedFile::JlsMappedFile() noexcept :
+    _data(nullptr),
+    _size(0),
+    _writable(false),
+    _file(INVALID_HANDLE_VALUE),
+    _mapping(nullptr)
+{
+}
+
+
+void JlsMappedFile::OpenForReading(const char* path)
+{
+    _file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+        ThrowFileError("open", path);
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size))
+        ThrowFileError("read the size of", path);
+
+    _size = static_cast<std::size_t>(size.QuadPart);
+    if (_size != 0)
+    {
+        Map(false);
+    }
+}
+
+
+void JlsMappedFile::CreateForWriting(const char* path, std::size_t size)
+{
+    _path = path;
+    _temporaryPath = GetTemporaryPath(path);
+    _file = CreateFileA(_temporaryPath.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (_file == INVALID_HANDLE_VALUE)
+    {
+        _temporaryPath.clear();
+        ThrowFileError("create", path);
+    }
+
+    // The file mapping extends the file to the requested size.
+    _size = size;
+    _writable = true;
+    Map(true);
+}
+
+
+void JlsMappedFile::Map(bool writable)
+{
+    const auto size = static_cast<uint64_t>(_size);
+    _mapping = CreateFileMappingA(_file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, static_cast<DWORD>(size >> 32), static_cast<DWORD>(size), nullptr);
+    if (!_mapping)
+        throw charls_error(ApiResult::UnspecifiedFailure, "Failed to map the file");
+
+    _data = static_cast<uint8_t*>(MapViewOfFile(_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, _size));
+    if (!_data)
+        throw charls_error(ApiResult::UnspecifiedFailure, "Failed to map the file");
+}
+
+
+void JlsMappedFile::Commit(std::size_t length)
+{
+    if (_data)
+    {
+        UnmapViewOfFile(_data);
+        _data = nullptr;
+    }
+    if (_mapping)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+    }
+
+    if (_writable && length != _size)
+    {
+        LARGE_INTEGER position;
+        position.QuadPart = static_cast<LONGLONG>(length);
+        if (!SetFilePointerEx(_file, position, nullptr, FILE_BEGIN) || !SetEndOfFile(_file))
+            throw charls_error(ApiResult::UnspecifiedFailure, "Failed to truncate the file");
+    }
+
+    CloseHandle(_file);
+    _file = INVALID_HANDLE_VALUE;
+    if (_writable)
+    {
+        if (!MoveFileExA(_temporaryPath.c_str(), _path.c_str(), MOVEFILE_REPLACE_EXISTING))
+            ThrowFileError("replace", _path.c_str());
+
+        _temporaryPath.clear();
+    }
+}
+
+
+void JlsMappedFile::Release() noexcept
+{
+    if (_data)
+    {
+        UnmapViewOfFile(_data);
+        _data = nullptr;
+    }
+    if (_mapping)
+    {
+        CloseHandle(_mapping);
+        _mapping = nullptr;
+    }
+    if (_file != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(_file);
+        _file = INVALID_HANDLE_VALUE;
+    }
+    if (!_temporaryPath.empty())
+    {
+        DeleteFileA(_temporaryPath.c_str());
+        _temporaryPath.clear();
+    }
+}
+
+#else
+
+JlsMappedFile::JlsMappedFile() noexcept :
+    _data(nullptr),
+    _size(0),
+    _writable(false),
+    _file(-1)
+{
+}
+
+
+void JlsMappedFile::OpenForReading(const char* path)
+{
+    _file = open(path, O_RDONLY);
+    if (_file == -1)
+        ThrowFileError("open", path);
+
+    struct stat status;
+    if (fstat(_file, &status) != 0)
+        ThrowFileError("read the size of", path);
+
+    _size = static_cast<std::size_t>(status.st_size);
+    if (_size != 0)
+    {
+        Map(false);
+    }
+}
+
+
+void JlsMappedFile::CreateForWriting(const char* path, std::size_t size)
+{
+    _path = path;
+    _temporaryPath = GetTemporaryPath(path);
+    _file = open(_temporaryPath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+    if (_file == -1)
+    {
+        _temporaryPath.clear();
+        ThrowFileError("create", path);
+    }
+
+    if (ftruncate(_file, static_cast<off_t>(size)) != 0)
+        ThrowFileError("resize", path);
+
+    _size = size;
+    _writable = true;
+    Map(true);
+}
+
+
+void JlsMappedFile::Map(bool writable)
+{
+    void* data = mmap(nullptr, _size, writable ? PROT_READ | PROT_WRITE : PROT_READ, writable ? MAP_SHARED : MAP_PRIVATE, _file, 0);
+    if (data == MAP_FAILED)
+        throw charls_error(ApiResult::UnspecifiedFailure, "Failed to map the file");
+
+    _data = static_cast<uint8_t*>(data);
+    madvise(data, _size, MADV_SEQUENTIAL);
+}
+
+
+void JlsMappedFile::Commit(std::size_t length)
+{
+    if (_data)
+    {
+        munmap(_data, _size);
+        _data = nullptr;
+    }
+
+    if (_writable && length != _size && ftruncate(_file, static_cast<off_t>(length)) != 0)
+        throw charls_error(ApiResult::UnspecifiedFailure, "Failed to truncate the file");
+
+    close(_file);
+    _file = -1;
+    if (_writable)
+    {
+        if (rename(_temporaryPath.c_str(), _path.c_str()) != 0)
+            ThrowFileError("replace", _path.c_str());
+
+        _temporaryPath.clear();
+    }
+}
+
+
+void JlsMappedFile::Release() noexcept
+{
+    if (_data)
+    {
+        munmap(_data, _size);
+        _data = nullptr;
+    }
+    if (_file != -1)
+    {
+        close(_file);
+        _file = -1;
+    }
+    if (!_temporaryPath.empty())
+    {
+        unlink(_temporaryPath.c_str());
+        _temporaryPath.clear();
+    }
+}
+
+#endif
+
+
+JlsMappedFile::~JlsMappedFile()
+{
+    Release();
+}
@@ -0,0 +1,64 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_JLS_MAPPED_FILE
+#define CHARLS_JLS_MAPPED_FILE
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+
+//
+// JlsMappedFile: maps a complete file in memory, to let the codec read from or write to it without an intermediate buffer.
+// The mapping is advised to be accessed sequentially: the codec reads and writes every byte once, from the start to the end.
+// A file that is created for writing is mapped shared with the requested size. It is written as a temporary file next to the
+// destination: Commit truncates it to the bytes actually written and renames it, a file that is not committed is removed.
+// A failed encode or decode never leaves a partial file behind (or replaces an existing file).
+//
+class JlsMappedFile
+{
+public:
+    JlsMappedFile() noexcept;
+    ~JlsMappedFile();
+
+    JlsMappedFile(const JlsMappedFile&) = delete;
+    JlsMappedFile(JlsMappedFile&&) = delete;
+    JlsMappedFile& operator=(const JlsMappedFile&) = delete;
+    JlsMappedFile& operator=(JlsMappedFile&&) = delete;
+
+    void OpenForReading(const char* path);
+    void CreateForWriting(const char* path, std::size_t size);
+
+    // Releases the mapping, the file created for writing is truncated to length bytes and renamed to its destination path.
+    void Commit(std::size_t length);
+
+    uint8_t* GetData() const noexcept
+    {
+        return _data;
+    }
+
+    std::size_t GetSize() const noexcept
+    {
+        return _size;
+    }
+
+private:
+    void Map(bool writable);
+    void Release() noexcept;
+
+    uint8_t* _data;
+    std::size_t _size;
+    bool _writable;
+    std::string _path;
+    std::string _temporaryPath;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping;
+#else
+    int _file;
+#endif
+};
+
+#endif
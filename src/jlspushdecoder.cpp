@@ -0,0 +1,293 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "jlspushdecoder.h"
+#include "util.h"
+#include "decoderstrategy.h"
+#include "jlscodecfactory.h"
+#include "jpegstreamreader.h"
+#include <algorithm>
+
+using namespace charls;
+
+extern template class JlsCodecFactory<DecoderStrategy>;
+
+namespace
+{
+
+bool IsCompressedBufferTooSmall(const charls_error& error) noexcept
+{
+    return error.code().value() == static_cast<int>(ApiResult::CompressedBufferTooSmall);
+}
+
+} // namespace
+
+
+JlsPushDecoder::JlsPushDecoder(const JlsParameters* params) :
+    _state(State::Header),
+    _params(),
+    _rawPixels(),
+    _componentIndex(0),
+    _scanLine(0),
+    _maximumLineByteCount(0),
+    _retryByteCount(0),
+    _maximumLineCount(0),
+    _decodedLineCount(0),
+    _endOfScanReceived(false),
+    _previousByte(0)
+{
+    if (params)
+    {
+        _params = *params;
+    }
+}
+
+
+JlsPushDecoder::~JlsPushDecoder() = default;
+
+
+void JlsPushDecoder::AddBytes(const uint8_t* data, std::size_t count)
+{
+    if (_state == State::Scan)
+    {
+        AddScanBytes(data, count);
+    }
+    else if (_state != State::Done)
+    {
+        _pending.insert(_pending.end(), data, data + count);
+    }
+
+    Process();
+}
+
+
+void JlsPushDecoder::SetDestination(ByteStreamInfo rawPixels)
+{
+    if (!rawPixels.rawData || _rawPixels.rawData)
+        throw charls_error(ApiResult::InvalidJlsParameters);
+
+    _rawPixels = rawPixels;
+    Process();
+}
+
+
+void JlsPushDecoder::Process()
+{
+    for (;;)
+    {
+        bool progress;
+        switch (_state)
+        {
+        case State::Header:
+            progress = TryReadHeader();
+            break;
+
+        case State::StartOfScan:
+            progress = TryReadStartOfScan();
+            break;
+
+        case State::ScanPending:
+            progress = TryStartScan();
+            break;
+
+        case State::Scan:
+            progress = DecodeAvailableLines();
+            break;
+
+        case State::DefineNumberOfLines:
+            progress = TryReadDefineNumberOfLines();
+            break;
+
+        default:
+            return;
+        }
+
+        if (!progress)
+            return;
+    }
+}
+
+
+bool JlsPushDecoder::TryReadHeader()
+{
+    JpegStreamReader reader(FromByteArray(_pending.data(), _pending.size()));
+    reader.SetInfo(_params);
+
+    try
+    {
+        reader.ReadHeader();
+        reader.ReadStartOfScan(true);
+        reader.CheckParameterCoherent();
+    }
+    catch (const charls_error& error)
+    {
+        if (IsCompressedBufferTooSmall(error))
+            return false;
+
+        throw;
+    }
+
+    _params = reader.GetMetadata();
+    _pending.erase(_pending.begin(), _pending.end() - static_cast<std::ptrdiff_t>(reader.GetBytesRemaining()));
+    _state = State::ScanPending;
+    return true;
+}
+
+
+bool JlsPushDecoder::TryReadStartOfScan()
+{
+    JpegStreamReader reader(FromByteArray(_pending.data(), _pending.size()));
+    reader.SetInfo(_params);
+
+    try
+    {
+        reader.ReadStartOfScan(false);
+    }
+    catch (const charls_error& error)
+    {
+        if (IsCompressedBufferTooSmall(error))
+            return false;
+
+        throw;
+    }
+
+    _params = reader.GetMetadata();
+    _pending.erase(_pending.begin(), _pending.end() - static_cast<std::ptrdiff_t>(reader.GetBytesRemaining()));
+    _state = State::ScanPending;
+    return true;
+}
+
+
+bool JlsPushDecoder::TryStartScan()
+{
+    if (!_rawPixels.rawData)
+        return false;
+
+    if (_componentIndex == 0)
+    {
+        const std::size_t bytesPerPlane = static_cast<std::size_t>(_params.width) * _params.height * ((_params.bitsPerSample + 7) / 8);
+        if (_rawPixels.count < bytesPerPlane * _params.components)
+            throw charls_error(ApiResult::UncompressedBufferTooSmall);
+    }
+
+    _codec = JlsCodecFactory<DecoderStrategy>().CreateCodec(_params, _params.custom);
+
+    // When the height is defined by a DNL segment after the scan, decode as many lines as fit in the destination.
+    _maximumLineCount = _params.height != 0 ? _params.height :
+        static_cast<int32_t>(std::min<std::size_t>(_rawPixels.count / _params.stride, UINT16_MAX));
+    const JlsRect rect{0, 0, _params.width, _maximumLineCount};
+    ByteStreamInfo compressedData{};
+    _codec->StartDecodeScan(_codec->CreateProcess(_rawPixels), rect, compressedData);
+
+    _scanLine = 0;
+    _maximumLineByteCount = MaximumEncodedLineByteCount(_params);
+    _retryByteCount = 0;
+    _endOfScanReceived = false;
+    _previousByte = 0;
+    _state = State::Scan;
+
+    std::vector<uint8_t> scanBytes;
+    scanBytes.swap(_pending);
+    AddScanBytes(scanBytes.data(), scanBytes.size());
+    return true;
+}
+
+
+bool JlsPushDecoder::TryReadDefineNumberOfLines()
+{
+    JpegStreamReader reader(FromByteArray(_pending.data(), _pending.size()));
+    reader.SetInfo(_params);
+
+    try
+    {
+        reader.ReadDefineNumberOfLines();
+    }
+    catch (const charls_error& error)
+    {
+        if (IsCompressedBufferTooSmall(error))
+            return false;
+
+        throw;
+    }
+
+    if (reader.GetMetadata().height != _scanLine)
+        throw charls_error(ApiResult::InvalidCompressedData, "The number of lines in the DNL segment doesn't match the decoded lines");
+
+    _params.height = reader.GetMetadata().height;
+    _pending.clear();
+    _state = State::Done;
+    return true;
+}
+
+
+void JlsPushDecoder::AddScanBytes(const uint8_t* data, std::size_t count)
+{
+    _codec->AddBytes(data, count);
+
+    // A marker (0xFF followed by a value >= 0x80) cannot occur in the encoded data: it marks the end of the scan.
+    for (std::size_t i = 0; i < count && !_endOfScanReceived; ++i)
+    {
+        _endOfScanReceived = _previousByte == 0xFF && data[i] >= 0x80;
+        _previousByte = data[i];
+    }
+}
+
+
+bool JlsPushDecoder::DecodeAvailableLines()
+{
+    for (;;)
+    {
+        if (_params.height == 0 ? _codec->IsAtEndOfScan() : _scanLine == _params.height)
+        {
+            // The last line can be decoded before the marker after the scan has been received.
+            if (!_endOfScanReceived)
+                return false;
+
+            break;
+        }
+
+        if (_scanLine == _maximumLineCount)
+            throw charls_error(ApiResult::UncompressedBufferTooSmall);
+
+        // The worst case size of an encoded line is far larger than a typical line: below it the line is decoded
+        // speculatively, as soon as its bytes have been added.
+        if (_endOfScanReceived || _codec->GetBufferedByteCount() >= _maximumLineByteCount)
+        {
+            _codec->DecodeLines(1);
+        }
+        else
+        {
+            // After an under-run the line is decoded again when 1/16 more bytes are buffered: passing the data in very
+            // small chunks doesn't decode the same line for every chunk.
+            const std::size_t bufferedByteCount = _codec->GetBufferedByteCount();
+            if (bufferedByteCount < _retryByteCount)
+                return false;
+
+            if (!_codec->TryDecodeLine())
+            {
+                _retryByteCount = bufferedByteCount + bufferedByteCount / 16 + 1;
+                return false;
+            }
+            _retryByteCount = 0;
+        }
+        ++_scanLine;
+        ++_decodedLineCount;
+    }
+
+    _codec->EndScan();
+    _pending = _codec->GetBytesAfterScan();
+    _codec.reset();
+
+    if (_params.height == 0)
+    {
+        _state = State::DefineNumberOfLines;
+        return true;
+    }
+
+    SkipBytes(_rawPixels, static_cast<std::size_t>(_params.width) * _params.height * ((_params.bitsPerSample + 7) / 8));
+
+    ++_componentIndex;
+    _state = _params.interleaveMode == InterleaveMode::None && _componentIndex < _params.components ? State::StartOfScan : State::Done;
+    return true;
+}
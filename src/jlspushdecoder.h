@@ -0,0 +1,86 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_JLS_PUSH_DECODER
+#define CHARLS_JLS_PUSH_DECODER
+
+#include "publictypes.h"
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+class DecoderStrategy;
+
+
+//
+// JlsPushDecoder: decodes a JPEG-LS byte stream that is passed in chunks, as the data arrives.
+// The decoder never waits for data: every call decodes the lines for which enough compressed bytes are
+// available and returns. A line is decoded as soon as the buffered bytes contain it completely: when less than the
+// worst case size of an encoded line is buffered the line is decoded speculatively and rolled back on an under-run.
+// Images with height 0 (height defined by a DNL segment after the scan) are decoded until the end of the scan.
+//
+class JlsPushDecoder
+{
+public:
+    explicit JlsPushDecoder(const JlsParameters* params);
+    ~JlsPushDecoder();
+
+    JlsPushDecoder(const JlsPushDecoder&) = delete;
+    JlsPushDecoder(JlsPushDecoder&&) = delete;
+    JlsPushDecoder& operator=(const JlsPushDecoder&) = delete;
+    JlsPushDecoder& operator=(JlsPushDecoder&&) = delete;
+
+    void AddBytes(const uint8_t* data, std::size_t count);
+    void SetDestination(ByteStreamInfo rawPixels);
+
+    bool IsHeaderRead() const noexcept
+    {
+        return _state != State::Header;
+    }
+
+    const JlsParameters& GetMetadata() const noexcept
+    {
+        return _params;
+    }
+
+    std::size_t GetDecodedLineCount() const noexcept
+    {
+        return _decodedLineCount;
+    }
+
+private:
+    enum class State
+    {
+        Header,
+        StartOfScan,
+        ScanPending,
+        Scan,
+        DefineNumberOfLines,
+        Done
+    };
+
+    void Process();
+    bool TryReadHeader();
+    bool TryReadStartOfScan();
+    bool TryStartScan();
+    bool DecodeAvailableLines();
+    bool TryReadDefineNumberOfLines();
+    void AddScanBytes(const uint8_t* data, std::size_t count);
+
+    State _state;
+    JlsParameters _params;
+    std::vector<uint8_t> _pending;
+    ByteStreamInfo _rawPixels;
+    std::unique_ptr<DecoderStrategy> _codec;
+    int _componentIndex;
+    int32_t _scanLine;
+    std::size_t _maximumLineByteCount;
+    std::size_t _retryByteCount;
+    int32_t _maximumLineCount;
+    std::size_t _decodedLineCount;
+    bool _endOfScanReceived;
+    uint8_t _previousByte;
+};
+
+#endif
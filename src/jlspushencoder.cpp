@@ -0,0 +1,165 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "jlspushencoder.h"
+#include "util.h"
+#include "encoderstrategy.h"
+#include "jlscodecfactory.h"
+#include "jpegmarkersegment.h"
+#include <algorithm>
+#include <sstream>
+
+using namespace charls;
+
+extern template class JlsCodecFactory<EncoderStrategy>;
+
+
+JlsPushEncoder::JlsPushEncoder(const JlsParameters& params) :
+    _params(params),
+    _outputPosition(0),
+    _scanCount(params.interleaveMode == InterleaveMode::None ? params.components : 1),
+    _componentIndex(0),
+    _scanLine(0)
+{
+    if (_params.stride == 0)
+    {
+        _params.stride = _params.width * ((_params.bitsPerSample + 7) / 8);
+        if (_params.interleaveMode != InterleaveMode::None)
+        {
+            _params.stride *= _params.components;
+        }
+    }
+
+    if (_params.jfif.version)
+    {
+        _writer.AddSegment(JpegMarkerSegment::CreateJpegFileInterchangeFormatSegment(_params.jfif));
+    }
+
+    _writer.AddStartOfFrame(_params);
+
+    if (_params.colorTransformation != ColorTransformation::None)
+    {
+        _writer.AddColorTransform(_params.colorTransformation);
+    }
+
+    _writer.AddScanHeader(_params);
+    WriteSegments(true, false);
+    StartScan();
+}
+
+
+JlsPushEncoder::~JlsPushEncoder() = default;
+
+
+void JlsPushEncoder::EncodeLines(const uint8_t* source, std::size_t sourceLength)
+{
+    if (sourceLength % _params.stride != 0)
+        throw charls_error(ApiResult::InvalidJlsParameters, "the source length needs to be a multiple of the stride");
+
+    auto lineCount = static_cast<int32_t>(sourceLength / _params.stride);
+    if (_params.height == 0)
+    {
+        // The height will be defined by a DNL segment when the encoding is finished.
+        if (lineCount > UINT16_MAX - _scanLine || (lineCount != 0 && IsComplete()))
+            throw charls_error(ApiResult::InvalidJlsParameters, "more lines passed than the image can contain");
+
+        if (lineCount != 0)
+        {
+            _codec->EncodeLines(_codec->CreateProcess(FromByteArrayConst(source, sourceLength)), lineCount);
+            _scanLine += lineCount;
+            _codec->TakeEncodedBytes(_output, false);
+        }
+        return;
+    }
+
+    if (lineCount > static_cast<int64_t>(_scanCount - _componentIndex) * _params.height - _scanLine)
+        throw charls_error(ApiResult::InvalidJlsParameters, "more lines passed than the image contains");
+
+    while (lineCount > 0)
+    {
+        const int32_t scanLineCount = std::min(lineCount, _params.height - _scanLine);
+        _codec->EncodeLines(_codec->CreateProcess(FromByteArrayConst(source, static_cast<std::size_t>(scanLineCount) * _params.stride)), scanLineCount);
+        source += static_cast<std::size_t>(scanLineCount) * _params.stride;
+        lineCount -= scanLineCount;
+        _scanLine += scanLineCount;
+
+        if (_scanLine < _params.height)
+            break;
+
+        _codec->TakeEncodedBytes(_output, true);
+        _codec.reset();
+        _scanLine = 0;
+
+        ++_componentIndex;
+        if (IsComplete())
+        {
+            WriteSegments(false, true);
+        }
+        else
+        {
+            _writer.AddScanHeader(_params);
+            WriteSegments(false, false);
+            StartScan();
+        }
+    }
+
+    if (_codec)
+    {
+        _codec->TakeEncodedBytes(_output, false);
+    }
+}
+
+
+void JlsPushEncoder::Finish()
+{
+    if (IsComplete())
+        return;
+
+    if (_params.height != 0 || _scanLine == 0)
+        throw charls_error(ApiResult::InvalidJlsParameters, "not all lines of the image are passed");
+
+    _codec->TakeEncodedBytes(_output, true);
+    _codec.reset();
+    ++_componentIndex;
+
+    _writer.AddSegment(JpegMarkerSegment::CreateDefineNumberOfLinesSegment(_scanLine));
+    WriteSegments(false, true);
+}
+
+
+std::size_t JlsPushEncoder::TakeBytes(uint8_t* destination, std::size_t destinationLength)
+{
+    const std::size_t byteCount = std::min(destinationLength, GetPendingByteCount());
+    std::copy_n(_output.data() + _outputPosition, byteCount, destination);
+    _outputPosition += byteCount;
+
+    if (_outputPosition == _output.size())
+    {
+        _output.clear();
+        _outputPosition = 0;
+    }
+
+    return byteCount;
+}
+
+
+void JlsPushEncoder::StartScan()
+{
+    JlsParameters info = _params;
+    info.components = _params.interleaveMode == InterleaveMode::None ? 1 : _params.components;
+    _codec = JlsCodecFactory<EncoderStrategy>().CreateCodec(info, _params.custom);
+
+    ByteStreamInfo compressedData{};
+    _codec->StartEncodeScan(compressedData);
+}
+
+
+void JlsPushEncoder::WriteSegments(bool startOfImage, bool endOfImage)
+{
+    std::stringbuf segments;
+    _writer.WriteSegments({&segments, nullptr, 0}, startOfImage, endOfImage);
+
+    const std::string bytes = segments.str();
+    _output.insert(_output.end(), bytes.begin(), bytes.end());
+}
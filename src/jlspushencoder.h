@@ -0,0 +1,63 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_JLS_PUSH_ENCODER
+#define CHARLS_JLS_PUSH_ENCODER
+
+#include "publictypes.h"
+#include "jpegstreamwriter.h"
+#include <cstdint>
+#include <vector>
+#include <memory>
+
+class EncoderStrategy;
+
+
+//
+// JlsPushEncoder: encodes an image that is passed line by line, as the lines are produced.
+// The encoder keeps only the state of the current scan (2 lines). After every call all completely encoded bytes
+// are available, at most 7 bits of the last encoded line are held back until the next line is passed.
+// For interleave mode None the lines of the first component are passed first, followed by the next component.
+// When the height is 0 the number of lines is unknown: Finish ends the scan and writes a DNL segment with the height.
+//
+class JlsPushEncoder
+{
+public:
+    explicit JlsPushEncoder(const JlsParameters& params);
+    ~JlsPushEncoder();
+
+    JlsPushEncoder(const JlsPushEncoder&) = delete;
+    JlsPushEncoder(JlsPushEncoder&&) = delete;
+    JlsPushEncoder& operator=(const JlsPushEncoder&) = delete;
+    JlsPushEncoder& operator=(JlsPushEncoder&&) = delete;
+
+    void EncodeLines(const uint8_t* source, std::size_t sourceLength);
+    void Finish();
+    std::size_t TakeBytes(uint8_t* destination, std::size_t destinationLength);
+
+    std::size_t GetPendingByteCount() const noexcept
+    {
+        return _output.size() - _outputPosition;
+    }
+
+    bool IsComplete() const noexcept
+    {
+        return _componentIndex == _scanCount;
+    }
+
+private:
+    void StartScan();
+    void WriteSegments(bool startOfImage, bool endOfImage);
+
+    JlsParameters _params;
+    JpegStreamWriter _writer;
+    std::unique_ptr<EncoderStrategy> _codec;
+    std::vector<uint8_t> _output;
+    std::size_t _outputPosition;
+    int32_t _scanCount;
+    int32_t _componentIndex;
+    int32_t _scanLine;
+};
+
+#endif
@@ -0,0 +1,152 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "jlssegmentindex.h"
+#include "jpegmarkercode.h"
+#include "util.h"
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CHARLS_SSE2
+#include <emmintrin.h>
+#endif
+
+using namespace charls;
+
+namespace
+{
+
+int ReadUInt16(const uint8_t* position) noexcept
+{
+    return position[0] * 256 + position[1];
+}
+
+} // namespace
+
+
+const uint8_t* FindMarker(const uint8_t* position, const uint8_t* end) noexcept
+{
+#ifdef CHARLS_SSE2
+    // Compare 16 bytes at a time: bit i of the result is set when byte i is 0xFF and byte i + 1 has its high bit set.
+    const __m128i ff = _mm_set1_epi8(static_cast<char>(0xFF));
+    while (end - position > 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+        const __m128i nextBytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position + 1));
+        const int candidates = _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, ff)) & _mm_movemask_epi8(nextBytes);
+        if (candidates != 0)
+        {
+            int index = 0;
+            while ((candidates >> index & 1) == 0)
+            {
+                ++index;
+            }
+            return position + index;
+        }
+        position += 16;
+    }
+#endif
+
+    while (end - position > 1)
+    {
+        position = static_cast<const uint8_t*>(memchr(position, 0xFF, static_cast<std::size_t>(end - position - 1)));
+        if (!position)
+            return end;
+
+        if (position[1] >= 0x80)
+            return position;
+
+        ++position;
+    }
+
+    return end;
+}
+
+
+std::vector<JlsSegmentInfo> BuildSegmentIndex(const uint8_t* data, std::size_t length)
+{
+    const uint8_t* const end = data + length;
+    const uint8_t* position = data;
+    std::vector<JlsSegmentInfo> segments;
+
+    for (;;)
+    {
+        if (position == end)
+            throw charls_error(ApiResult::CompressedBufferTooSmall, "The byte stream ends before the EOI marker");
+
+        if (*position != 0xFF)
+            throw charls_error(ApiResult::MissingJpegMarkerStart);
+
+        // Skip the fill bytes (see T.81, B.1.1.2).
+        while (end - position > 1 && position[1] == 0xFF)
+        {
+            ++position;
+        }
+        if (end - position < 2)
+            throw charls_error(ApiResult::CompressedBufferTooSmall, "The byte stream ends before the EOI marker");
+
+        JlsSegmentInfo segment{};
+        segment.markerCode = position[1];
+        segment.offset = static_cast<std::size_t>(position - data);
+        segment.length = 2;
+
+        const auto markerCode = static_cast<JpegMarkerCode>(segment.markerCode);
+        if (segments.empty() && markerCode != JpegMarkerCode::StartOfImage)
+            throw charls_error(ApiResult::InvalidCompressedData, "The byte stream doesn't start with a SOI marker");
+
+        if (markerCode == JpegMarkerCode::StartOfImage || markerCode == JpegMarkerCode::EndOfImage)
+        {
+            segments.push_back(segment);
+            if (markerCode == JpegMarkerCode::EndOfImage)
+                return segments;
+
+            position += 2;
+            continue;
+        }
+
+        if (end - position < 4)
+            throw charls_error(ApiResult::CompressedBufferTooSmall);
+
+        const int segmentSize = ReadUInt16(position + 2);
+        if (segmentSize < 2)
+            throw charls_error(ApiResult::InvalidCompressedData);
+
+        segment.length = 2 + static_cast<std::size_t>(segmentSize);
+        if (static_cast<std::size_t>(end - position) < segment.length)
+            throw charls_error(ApiResult::CompressedBufferTooSmall);
+
+        const uint8_t* const content = position + 4;
+        switch (markerCode)
+        {
+            case JpegMarkerCode::StartOfFrameJpegLS:
+                if (segmentSize >= 8)
+                {
+                    segment.componentCount = content[5];
+                }
+                break;
+
+            case JpegMarkerCode::StartOfScan:
+                if (segmentSize < 6 || segmentSize < 6 + 2 * content[0])
+                    throw charls_error(ApiResult::InvalidCompressedData);
+
+                segment.componentCount = content[0];
+                segment.allowedLossyError = content[1 + 2 * content[0]];
+                segment.interleaveMode = static_cast<CharlsInterleaveModeType>(content[2 + 2 * content[0]]);
+                break;
+
+            default:
+                break;
+        }
+
+        position += segment.length;
+        if (markerCode == JpegMarkerCode::StartOfScan)
+        {
+            const uint8_t* const marker = FindMarker(position, end);
+            segment.scanDataLength = static_cast<std::size_t>(marker - position);
+            position = marker;
+        }
+
+        segments.push_back(segment);
+    }
+}
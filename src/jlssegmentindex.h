@@ -0,0 +1,21 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_JLS_SEGMENT_INDEX
+#define CHARLS_JLS_SEGMENT_INDEX
+
+#include "publictypes.h"
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+
+// Returns the position of the first 0xFF byte in [position, end) that is followed by a byte >= 0x80 (the start of a marker
+// after entropy coded data) or end when there is none. The byte after the 0xFF byte must be in the range (it is never read beyond end).
+const uint8_t* FindMarker(const uint8_t* position, const uint8_t* end) noexcept;
+
+// Builds the index of all marker segments of a JPEG-LS byte stream, without decoding the entropy coded data.
+std::vector<JlsSegmentInfo> BuildSegmentIndex(const uint8_t* data, std::size_t length);
+
+#endif
@@ -0,0 +1,193 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "jlstranscoder.h"
+#include "jlspushencoder.h"
+#include "jpegstreamreader.h"
+#include "util.h"
+#include <cstring>
+
+using namespace charls;
+
+namespace
+{
+
+template<typename SAMPLE>
+void CopyComponent(const uint8_t* source, int sourceStep, uint8_t* destination, int destinationStep, int32_t pixelCount) noexcept
+{
+    const SAMPLE* sourceSample = reinterpret_cast<const SAMPLE*>(source);
+    SAMPLE* destinationSample = reinterpret_cast<SAMPLE*>(destination);
+
+    for (int32_t i = 0; i < pixelCount; ++i)
+    {
+        *destinationSample = *sourceSample;
+        sourceSample += sourceStep;
+        destinationSample += destinationStep;
+    }
+}
+
+} // namespace
+
+
+JlsTranscoder::JlsTranscoder(const uint8_t* source, std::size_t sourceLength, const JlsParameters& sourceParams, const JlsParameters& params) :
+    _source(source),
+    _sourceLength(sourceLength),
+    _params(params),
+    _sourceInterleaved(sourceParams.interleaveMode != InterleaveMode::None && sourceParams.components > 1),
+    _interleaved(params.interleaveMode != InterleaveMode::None && params.components > 1),
+    _bytesPerSample((params.bitsPerSample + 7) / 8),
+    _componentLineByteCount(static_cast<std::size_t>(params.width) * _bytesPerSample),
+    _lineIndex(0),
+    _destination(nullptr),
+    _destinationLength(0),
+    _bytesWritten(0)
+{
+    _params.stride = 0;
+    _params.outputBgr = 0;
+
+    if (_sourceInterleaved != _interleaved)
+    {
+        if (_params.height == 0)
+            throw charls_error(ApiResult::ParameterValueNotSupported, "the interleave mode of an image with a DNL segment cannot be changed");
+
+        _line.resize(_componentLineByteCount * _params.components);
+        _storedLines.resize(_componentLineByteCount * _params.height * (_params.components - 1));
+    }
+}
+
+
+JlsTranscoder::~JlsTranscoder() = default;
+
+
+std::size_t JlsTranscoder::Transcode(uint8_t* destination, std::size_t destinationLength)
+{
+    _destination = destination;
+    _destinationLength = destinationLength;
+    _encoder = std::make_unique<JlsPushEncoder>(_params);
+    TakeEncodedBytes();
+
+    JpegStreamReader reader(FromByteArrayConst(_source, _sourceLength));
+    reader.SetLineCallback(OnLineDecoded, this);
+    try
+    {
+        reader.Read(ByteStreamInfo());
+    }
+    catch (...)
+    {
+        if (_exception)
+            std::rethrow_exception(_exception);
+        throw;
+    }
+
+    if (_sourceInterleaved && !_interleaved)
+    {
+        // The scans of the other components can only be encoded after the scan of the first component.
+        for (int32_t component = 1; component < _params.components; ++component)
+        {
+            for (int32_t line = 0; line < _params.height; ++line)
+            {
+                EncodeLine(GetStoredLine(component - 1, line));
+            }
+        }
+    }
+
+    _encoder->Finish();
+    TakeEncodedBytes();
+
+    return _bytesWritten;
+}
+
+
+int JlsTranscoder::OnLineDecoded(void* context, const void* line, int /*pixelCount*/, std::size_t /*stride*/)
+{
+    auto* transcoder = static_cast<JlsTranscoder*>(context);
+    try
+    {
+        transcoder->LineDecoded(static_cast<const uint8_t*>(line));
+        return 0;
+    }
+    catch (...)
+    {
+        transcoder->_exception = std::current_exception();
+        return 1;
+    }
+}
+
+
+void JlsTranscoder::LineDecoded(const uint8_t* line)
+{
+    const int32_t components = _params.components;
+
+    if (_sourceInterleaved == _interleaved)
+    {
+        EncodeLine(line);
+    }
+    else if (_sourceInterleaved)
+    {
+        // The first component is encoded directly, the other components are stored for their own scans.
+        const auto lineInScan = static_cast<int32_t>(_lineIndex);
+        for (int32_t component = 0; component < components; ++component)
+        {
+            uint8_t* destination = component == 0 ? _line.data() : GetStoredLine(component - 1, lineInScan);
+            if (_bytesPerSample == 1)
+            {
+                CopyComponent<uint8_t>(line + component, components, destination, 1, _params.width);
+            }
+            else
+            {
+                CopyComponent<uint16_t>(line + component * _bytesPerSample, components, destination, 1, _params.width);
+            }
+        }
+        EncodeLine(_line.data());
+    }
+    else
+    {
+        // The lines of all components except the last are stored, the last component completes the interleaved lines.
+        const auto component = static_cast<int32_t>(_lineIndex / _params.height);
+        const auto lineInScan = static_cast<int32_t>(_lineIndex % _params.height);
+        if (component < components - 1)
+        {
+            memcpy(GetStoredLine(component, lineInScan), line, _componentLineByteCount);
+        }
+        else
+        {
+            for (int32_t i = 0; i < components; ++i)
+            {
+                const uint8_t* source = i == components - 1 ? line : GetStoredLine(i, lineInScan);
+                if (_bytesPerSample == 1)
+                {
+                    CopyComponent<uint8_t>(source, 1, _line.data() + i, components, _params.width);
+                }
+                else
+                {
+                    CopyComponent<uint16_t>(source, 1, _line.data() + i * _bytesPerSample, components, _params.width);
+                }
+            }
+            EncodeLine(_line.data());
+        }
+    }
+
+    ++_lineIndex;
+}
+
+
+void JlsTranscoder::EncodeLine(const uint8_t* line)
+{
+    _encoder->EncodeLines(line, _interleaved ? _componentLineByteCount * _params.components : _componentLineByteCount);
+    TakeEncodedBytes();
+}
+
+
+void JlsTranscoder::TakeEncodedBytes()
+{
+    _bytesWritten += _encoder->TakeBytes(_destination + _bytesWritten, _destinationLength - _bytesWritten);
+    if (_encoder->GetPendingByteCount() != 0)
+        throw charls_error(ApiResult::CompressedBufferTooSmall);
+}
+
+
+uint8_t* JlsTranscoder::GetStoredLine(int32_t storedComponent, int32_t line) noexcept
+{
+    return _storedLines.data() + (static_cast<std::size_t>(storedComponent) * _params.height + line) * _componentLineByteCount;
+}
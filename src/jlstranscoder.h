@@ -0,0 +1,61 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_JLS_TRANSCODER
+#define CHARLS_JLS_TRANSCODER
+
+#include "publictypes.h"
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <vector>
+
+class JlsPushEncoder;
+
+
+//
+// JlsTranscoder: re-encodes JPEG-LS encoded data with other coding parameters (NEAR, interleave mode, color transformation
+// or preset coding parameters). Every line that is passed to the line callback of the decoder is passed directly to a push
+// encoder, only the lines of the current scans are resident and the memory use doesn't depend on the image size.
+// A change between interleave mode None and Line/Sample needs the lines of all components: the components that cannot be
+// encoded yet are stored, all other lines are still transcoded directly.
+//
+class JlsTranscoder
+{
+public:
+    JlsTranscoder(const uint8_t* source, std::size_t sourceLength, const JlsParameters& sourceParams, const JlsParameters& params);
+    ~JlsTranscoder();
+
+    JlsTranscoder(const JlsTranscoder&) = delete;
+    JlsTranscoder(JlsTranscoder&&) = delete;
+    JlsTranscoder& operator=(const JlsTranscoder&) = delete;
+    JlsTranscoder& operator=(JlsTranscoder&&) = delete;
+
+    std::size_t Transcode(uint8_t* destination, std::size_t destinationLength);
+
+private:
+    static int OnLineDecoded(void* context, const void* line, int pixelCount, std::size_t stride);
+    void LineDecoded(const uint8_t* line);
+    void EncodeLine(const uint8_t* line);
+    void TakeEncodedBytes();
+    uint8_t* GetStoredLine(int32_t storedComponent, int32_t line) noexcept;
+
+    const uint8_t* _source;
+    std::size_t _sourceLength;
+    JlsParameters _params;
+    bool _sourceInterleaved;
+    bool _interleaved;
+    std::size_t _bytesPerSample;
+    std::size_t _componentLineByteCount;
+    std::unique_ptr<JlsPushEncoder> _encoder;
+    std::vector<uint8_t> _line;
+    std::vector<uint8_t> _storedLines;
+    int64_t _lineIndex;
+    uint8_t* _destination;
+    std::size_t _destinationLength;
+    std::size_t _bytesWritten;
+    std::exception_ptr _exception;
+};
+
+#endif
@@ -7,14 +7,40 @@
 
 #include "jpegsegment.h"
 #include "jpegstreamwriter.h"
+#include "charls.h"
 
 class JpegImageDataSegment : public JpegSegment
 {
 public:
-    JpegImageDataSegment(ByteStreamInfo rawStream, const JlsParameters& params, int componentCount) noexcept :
+    JpegImageDataSegment(ByteStreamInfo rawStream, const JlsParameters& params, int componentCount,
+        charls::SourceFormat sourceFormat = charls::SourceFormat::Native) noexcept :
         _componentCount(componentCount),
         _rawStreamInfo(rawStream),
-        _params(params)
+        _params(params),
+        _lineRequested(nullptr),
+        _lineRequestedContext(nullptr),
+        _sourceFormat(sourceFormat)
+    {
+    }
+
+    JpegImageDataSegment(JlsLineRequestedCallback lineRequested, void* context, const JlsParameters& params, int componentCount) noexcept :
+        _componentCount(componentCount),
+        _rawStreamInfo(),
+        _params(params),
+        _lineRequested(lineRequested),
+        _lineRequestedContext(context)
+    {
+    }
+
+    JpegImageDataSegment(const JlsSourceLayout& layout, int firstComponent, const JlsParameters& params, int componentCount) noexcept :
+        _componentCount(componentCount),
+        _rawStreamInfo(),
+        _params(params),
+        _lineRequested(nullptr),
+        _lineRequestedContext(nullptr),
+        _useSourceLayout(true),
+        _sourceLayout(layout),
+        _firstComponent(firstComponent)
     {
     }
 
@@ -24,6 +50,12 @@ private:
     int _componentCount;
     ByteStreamInfo _rawStreamInfo;
     JlsParameters _params;
+    JlsLineRequestedCallback _lineRequested;
+    void* _lineRequestedContext;
+    charls::SourceFormat _sourceFormat{};
+    bool _useSourceLayout{};
+    JlsSourceLayout _sourceLayout{};
+    int _firstComponent{};
 };
 
 #endif
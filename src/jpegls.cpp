@@ -84,6 +84,19 @@ const std::error_category& charls_error::CharLSCategoryInstance() noexcept
 }
 
 
+namespace
+{
+    constexpr std::size_t DefaultStreamBlockSize = 64 * 1024;
+    constexpr std::size_t MinimumStreamBlockSize = 1024;
+}
+
+
+std::size_t GetStreamBlockSize(std::size_t blockSize) noexcept
+{
+    return blockSize == 0 ? DefaultStreamBlockSize : std::max(blockSize, MinimumStreamBlockSize);
+}
+
+
 // Lookup tables to replace code with lookup tables.
 // To avoid threading issues, all tables are created when the program is loaded.
 
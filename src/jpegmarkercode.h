@@ -17,6 +17,7 @@ enum class JpegMarkerCode : uint8_t
     StartOfImage = 0xD8, // SOI: Marks the start of an image.
     EndOfImage = 0xD9,   // EOI: Marks the end of an image.
     StartOfScan = 0xDA,  // SOS: Marks the start of scan.
+    DefineNumberOfLines = 0xDC, // DNL: Defines the number of lines of the image, used when the frame header defines 0 lines.
 
     // The following markers are defined in ITU T.81 | ISO IEC 10918-1.
     StartOfFrameBaselineJpeg = 0xC0,            // SOF_0:  Marks the start of a baseline jpeg encoded frame.
@@ -7,6 +7,7 @@
 #include "util.h"
 #include <vector>
 #include <cstdint>
+#include <algorithm>
 
 using namespace charls;
 
@@ -93,7 +94,7 @@ std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateColorTransformSegmen
 }
 
 
-std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateStartOfScanSegment(int componentIndex, int componentCount, int allowedLossyError, InterleaveMode interleaveMode)
+std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateStartOfScanSegment(int componentIndex, int componentCount, int allowedLossyError, InterleaveMode interleaveMode, int mappingTableId)
 {
     ASSERT(componentIndex >= 0);
     ASSERT(componentCount > 0);
@@ -105,7 +106,7 @@ std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateStartOfScanSegment(i
     for (auto i = 0; i < componentCount; ++i)
     {
         content.push_back(static_cast<uint8_t>(componentIndex + i));
-        content.push_back(0);  // Mapping table selector (0 = no table)
+        content.push_back(static_cast<uint8_t>(mappingTableId)); // Mapping table selector (0 = no table)
     }
 
     content.push_back(static_cast<uint8_t>(allowedLossyError)); // NEAR parameter
@@ -114,3 +115,54 @@ std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateStartOfScanSegment(i
 
     return std::make_unique<JpegMarkerSegment>(JpegMarkerCode::StartOfScan, move(content));
 }
+
+
+std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateOversizeImageDimensionSegment(int width, int height)
+{
+    ASSERT(width > 0);
+    ASSERT(height >= 0);
+
+    // Create an oversize image dimension segment as defined in T.87, C.2.4.1.4
+    const int dimensionSize = std::max(width, height) > 0xFFFFFF ? 4 : 3;
+    std::vector<uint8_t> content;
+    content.push_back(4);                                     // ID = Oversize image dimension
+    content.push_back(static_cast<uint8_t>(dimensionSize));   // Wxy = Number of bytes used to represent Ye and Xe
+    for (const auto value : { height, width })                // Ye = Number of lines, Xe = Number of samples per line
+    {
+        for (int shift = 8 * (dimensionSize - 1); shift >= 0; shift -= 8)
+        {
+            content.push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >> shift));
+        }
+    }
+
+    return std::make_unique<JpegMarkerSegment>(JpegMarkerCode::JpegLSPresetParameters, move(content));
+}
+
+
+std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateMappingTableSegment(int tableId, int entryWidth, const uint8_t* entries, size_t byteCount, bool continuation)
+{
+    ASSERT(tableId > 0 && tableId <= UINT8_MAX);
+    ASSERT(entryWidth > 0 && entryWidth <= UINT8_MAX);
+    ASSERT(byteCount % entryWidth == 0);
+
+    // Create a mapping table segment as defined in T.87, C.2.4.1.2 and C.2.4.1.3
+    std::vector<uint8_t> content;
+    content.push_back(continuation ? 3 : 2);               // ID = Mapping table specification or continuation
+    content.push_back(static_cast<uint8_t>(tableId));     // TID = Table identifier
+    content.push_back(static_cast<uint8_t>(entryWidth));  // Wt = Width of the table entries in bytes
+    content.insert(content.end(), entries, entries + byteCount);
+
+    return std::make_unique<JpegMarkerSegment>(JpegMarkerCode::JpegLSPresetParameters, move(content));
+}
+
+
+std::unique_ptr<JpegMarkerSegment> JpegMarkerSegment::CreateDefineNumberOfLinesSegment(int height)
+{
+    ASSERT(height > 0 && height <= UINT16_MAX);
+
+    // Create a Define Number of Lines segment as defined in T.81, B.2.5
+    std::vector<uint8_t> content;
+    push_back(content, static_cast<uint16_t>(height)); // NL = Number of lines
+
+    return std::make_unique<JpegMarkerSegment>(JpegMarkerCode::DefineNumberOfLines, move(content));
+}
@@ -52,7 +52,31 @@ public:
     /// <param name="componentCount">The number of components in the scan segment. Can only be > 1 when the components are interleaved.</param>
     /// <param name="allowedLossyError">The allowed lossy error. 0 means lossless.</param>
     /// <param name="interleaveMode">The interleave mode of the components.</param>
-    static std::unique_ptr<JpegMarkerSegment> CreateStartOfScanSegment(int componentIndex, int componentCount, int allowedLossyError, charls::InterleaveMode interleaveMode);
+    /// <param name="mappingTableId">The mapping table that is selected for the components, 0 means no table.</param>
+    static std::unique_ptr<JpegMarkerSegment> CreateStartOfScanSegment(int componentIndex, int componentCount, int allowedLossyError, charls::InterleaveMode interleaveMode, int mappingTableId);
+
+    /// <summary>
+    /// Creates a JPEG-LS oversize image dimension (LSE type 4) segment, for a width or height above 65535.
+    /// </summary>
+    /// <param name="width">The width of the frame.</param>
+    /// <param name="height">The height of the frame.</param>
+    static std::unique_ptr<JpegMarkerSegment> CreateOversizeImageDimensionSegment(int width, int height);
+
+    /// <summary>
+    /// Creates a JPEG-LS mapping table specification or continuation (LSE type 2 or 3) segment.
+    /// </summary>
+    /// <param name="tableId">The table identifier.</param>
+    /// <param name="entryWidth">The size of 1 table entry in bytes.</param>
+    /// <param name="entries">The table entries, as they are stored in the byte stream.</param>
+    /// <param name="byteCount">The number of bytes of the entries to write into this segment.</param>
+    /// <param name="continuation">True to create a continuation segment (type 3), false for the first segment (type 2).</param>
+    static std::unique_ptr<JpegMarkerSegment> CreateMappingTableSegment(int tableId, int entryWidth, const uint8_t* entries, std::size_t byteCount, bool continuation);
+
+    /// <summary>
+    /// Creates a Define Number of Lines (DNL) segment, written after the first scan when the frame was started with 0 lines.
+    /// </summary>
+    /// <param name="height">The number of lines of the frame.</param>
+    static std::unique_ptr<JpegMarkerSegment> CreateDefineNumberOfLinesSegment(int height);
 
     JpegMarkerSegment(JpegMarkerCode markerCode, std::vector<uint8_t>&& content) :
         _markerCode(markerCode),
@@ -10,7 +10,15 @@
 #include "decoderstrategy.h"
 #include "encoderstrategy.h"
 #include "jlscodecfactory.h"
+#include "processlinecallback.h"
 #include "constants.h"
+#include "jlssegmentindex.h"
+#include "processlinemapped.h"
+#include "processlinereduced.h"
+#include "processlinelookup.h"
+#include "processlinepipelined.h"
+#include "processlinelayout.h"
+#include "processlineunpack.h"
 #include <memory>
 #include <iomanip>
 #include <algorithm>
@@ -22,6 +30,9 @@ extern template class JlsCodecFactory<DecoderStrategy>;
 
 namespace {
 
+// The size of the output lines that are decoded per component before the next component, when the scans are decoded in bands.
+const std::size_t BandByteCount = 64 * 1024;
+
 
 // JFIF\0
 uint8_t jfifID[] = { 'J', 'F', 'I', 'F', '\0' };
@@ -36,23 +47,21 @@ int32_t clamp(int32_t i, int32_t j, int32_t maximumSampleValue) noexcept
     return i;
 }
 
- 
-ApiResult CheckParameterCoherent(const JlsParameters& params) noexcept
-{
-    if (params.bitsPerSample < 2 || params.bitsPerSample > 16)
-        return ApiResult::ParameterValueNotSupported;
 
-    if (params.interleaveMode < InterleaveMode::None || params.interleaveMode > InterleaveMode::Sample)
-        return ApiResult::InvalidCompressedData;
+// Creates a codec that converts between the internal format and the line buffer of a ProcessLineBuffered (stride 0).
+template<typename STRATEGY>
+std::unique_ptr<STRATEGY> CreateBufferedCodec(JlsParameters params)
+{
+    params.stride = 0;
+    return JlsCodecFactory<STRATEGY>().CreateCodec(params, params.custom);
+}
 
-    switch (params.components)
-    {
-        case 4: return params.interleaveMode == InterleaveMode::Sample ? ApiResult::ParameterValueNotSupported : ApiResult::OK;
-        case 3: return ApiResult::OK;
-        case 0: return ApiResult::InvalidJlsParameters;
 
-        default: return params.interleaveMode != InterleaveMode::None ? ApiResult::ParameterValueNotSupported : ApiResult::OK;
-    }
+std::unique_ptr<ProcessLinePipelined> CreatePipelinedProcess(std::unique_ptr<ProcessLine> lineProcess, const JlsParameters& params, int32_t requestedLineCount, const JlsExecutor& executor)
+{
+    const size_t bytesPerPixel = static_cast<size_t>(params.bitsPerSample <= 8 ? 1 : 2) * (params.interleaveMode == InterleaveMode::Sample ? params.components : 1);
+    const int32_t componentsPerLine = params.interleaveMode == InterleaveMode::Line ? params.components : 1;
+    return std::make_unique<ProcessLinePipelined>(move(lineProcess), bytesPerPixel, componentsPerLine, params.width, requestedLineCount, executor);
 }
 
 } // namespace
@@ -79,62 +88,550 @@ void JpegImageDataSegment::Serialize(JpegStreamWriter& streamWriter)
 {
     JlsParameters info = _params;
     info.components = _componentCount;
-    auto codec = JlsCodecFactory<EncoderStrategy>().CreateCodec(info, _params.custom);
-    std::unique_ptr<ProcessLine> processLine(codec->CreateProcess(_rawStreamInfo));
+    const bool convertSource = _sourceFormat != SourceFormat::Native && _rawStreamInfo.rawData;
+    auto codec = _lineRequested || _useSourceLayout || convertSource ?
+        CreateBufferedCodec<EncoderStrategy>(info) : JlsCodecFactory<EncoderStrategy>().CreateCodec(info, _params.custom);
+    std::unique_ptr<ProcessLine> processLine;
+    ProcessLinePipelined* pipeline = nullptr;
+    if (_useSourceLayout)
+    {
+        processLine = _params.bitsPerSample <= 8 ?
+            CreateBufferedProcess<ProcessLineGather<uint8_t>>(*codec, _sourceLayout, _params.width, _componentCount, _firstComponent) :
+            CreateBufferedProcess<ProcessLineGather<uint16_t>>(*codec, _sourceLayout, _params.width, _componentCount, _firstComponent);
+    }
+    else if (convertSource)
+    {
+        const size_t sampleCount = static_cast<size_t>(_params.width) * _componentCount;
+        processLine = _params.bitsPerSample <= 8 ?
+            CreateBufferedProcess<ProcessLineUnpack<uint8_t>>(*codec, _rawStreamInfo, _params.stride, _sourceFormat, _params.bitsPerSample, sampleCount) :
+            CreateBufferedProcess<ProcessLineUnpack<uint16_t>>(*codec, _rawStreamInfo, _params.stride, _sourceFormat, _params.bitsPerSample, sampleCount);
+    }
+    else if (_lineRequested)
+    {
+        const size_t lineByteCount = static_cast<size_t>(_params.width) * _componentCount * ((_params.bitsPerSample + 7) / 8);
+        processLine = CreateBufferedProcess<ProcessLineCallback>(*codec, lineByteCount, nullptr, _lineRequested, _lineRequestedContext);
+    }
+    else if (streamWriter._pipelineExecutor && _params.height != 0)
+    {
+        auto pipelinedProcess = CreatePipelinedProcess(codec->CreateProcess(_rawStreamInfo), info, _params.height, *streamWriter._pipelineExecutor);
+        pipeline = pipelinedProcess.get();
+        processLine = move(pipelinedProcess);
+    }
     ByteStreamInfo compressedData = streamWriter.OutputStream();
-    const size_t cbyteWritten = codec->EncodeScan(move(processLine), compressedData);
+    const size_t cbyteWritten = processLine ? codec->EncodeScan(move(processLine), compressedData) : codec->EncodeScan(_rawStreamInfo, compressedData);
+    if (pipeline)
+    {
+        pipeline->Finish();
+    }
     streamWriter.Seek(cbyteWritten);
 }
 
 
 JpegStreamReader::JpegStreamReader(ByteStreamInfo byteStreamInfo) noexcept :
     _byteStream(byteStreamInfo),
+    _fragments(nullptr),
+    _fragmentCount(0),
+    _nextFragment(0),
     _params(),
-    _rect()
+    _rect(),
+    _componentMask(UINT32_MAX),
+    _applyMappingTable(false),
+    _transformSamples(false),
+    _sampleTransform(),
+    _usePixelLayout(false),
+    _pixelLayout(),
+    _lineDecoded(nullptr),
+    _lineDecodedContext(nullptr),
+    _pipelineExecutor(nullptr)
 {
 }
 
 
+JpegStreamReader::JpegStreamReader(const JlsFragment* fragments, std::size_t fragmentCount) noexcept :
+    _byteStream(),
+    _fragments(fragments),
+    _fragmentCount(fragmentCount),
+    _nextFragment(0),
+    _params(),
+    _rect(),
+    _componentMask(UINT32_MAX),
+    _applyMappingTable(false),
+    _transformSamples(false),
+    _sampleTransform(),
+    _usePixelLayout(false),
+    _pixelLayout(),
+    _lineDecoded(nullptr),
+    _lineDecodedContext(nullptr),
+    _pipelineExecutor(nullptr)
+{
+    if (fragmentCount != 0)
+    {
+        _byteStream = FromByteArrayConst(fragments[0].data, fragments[0].length);
+        _nextFragment = 1;
+    }
+}
+
+
 void JpegStreamReader::Read(ByteStreamInfo rawPixels)
 {
     ReadHeader();
+    CheckParameterCoherent();
+    ReadStartOfScan(true);
+    const int selectedComponentCount = GetSelectedComponentCount();
 
-    const auto result = CheckParameterCoherent(_params);
-    if (result != ApiResult::OK)
-        throw charls_error(result);
+    if (!_reducedImages.empty() && _params.height == 0)
+        throw charls_error(ApiResult::ParameterValueNotSupported, "Reduced images cannot be created when the height is defined by a DNL segment");
 
-    if (_rect.Width <= 0)
+    CheckSampleTransform();
+    if (_usePixelLayout)
+    {
+        if (_transformSamples || !_reducedImages.empty() || _lineDecoded || !rawPixels.rawData)
+            throw charls_error(ApiResult::ParameterValueNotSupported, "A pixel layout can only be applied when decoding to a byte array");
+
+        if (_params.height == 0)
+            throw charls_error(ApiResult::ParameterValueNotSupported, "A pixel layout cannot be applied when the height is defined by a DNL segment");
+    }
+    const int32_t bytesPerSample = _transformSamples ? (_sampleTransform.outputBitsPerSample + 7) / 8 : (_params.bitsPerSample + 7) / 8;
+
+    if (_params.height == 0)
+    {
+        // The height is defined by a DNL segment after the scan: decode as many lines as fit in the output.
+        if (_rect.Width > 0)
+            throw charls_error(ApiResult::ParameterValueNotSupported, "A rect cannot be decoded when the height is defined by a DNL segment");
+
+        const MappingTable* mappingTable = GetScanMappingTable();
+        const size_t bytesPerLine = mappingTable ? static_cast<size_t>(_params.width) * mappingTable->entryWidth :
+            _params.stride != 0 ? _params.stride : static_cast<size_t>(_params.components) * _params.width * bytesPerSample;
+        _rect.Width = _params.width;
+        _rect.Height = rawPixels.rawData && !_lineDecoded ? static_cast<int32_t>(std::min<size_t>(rawPixels.count / bytesPerLine, UINT16_MAX)) : UINT16_MAX;
+    }
+    else if (_rect.Width <= 0)
     {
         _rect.Width = _params.width;
         _rect.Height = _params.height;
     }
 
-    const int64_t bytesPerPlane = static_cast<int64_t>(_rect.Width) * _rect.Height * ((_params.bitsPerSample + 7)/8);
+    const int64_t bytesPerPlane = static_cast<int64_t>(_rect.Width) * _rect.Height * bytesPerSample;
 
-    if (rawPixels.rawData && static_cast<int64_t>(rawPixels.count) < bytesPerPlane * _params.components)
+    // With mapping tables the size of the planes is only known when the scans are read: the mapped lines are checked when stored.
+    if (rawPixels.rawData && !_lineDecoded && !_applyMappingTable && !_usePixelLayout && static_cast<int64_t>(rawPixels.count) < bytesPerPlane * selectedComponentCount)
         throw charls_error(ApiResult::UncompressedBufferTooSmall);
 
-    int componentIndex = 0;
+    if (_usePixelLayout)
+    {
+        CheckPixelLayout(rawPixels.count);
+        if (_pixelLayout.interleaved && _params.interleaveMode == InterleaveMode::None && selectedComponentCount > 1 && _fragmentCount == 0 && _byteStream.rawData)
+        {
+            ReadBandedScans(rawPixels.rawData);
+            return;
+        }
+    }
+
+    CheckReducedImages(selectedComponentCount);
+
+    int decodedComponentCount = 0;
 
-    while (componentIndex < _params.components)
+    for (int componentIndex = 0;; ++componentIndex)
     {
-        ReadStartOfScan(componentIndex == 0);
+        if (!IsComponentSelected(componentIndex))
+        {
+            const JpegMarkerCode markerCode = SkipScanData();
+            if (markerCode != JpegMarkerCode::StartOfScan && markerCode != JpegMarkerCode::JpegLSPresetParameters)
+                throw charls_error(ApiResult::InvalidCompressedData, "Expected a SOS or LSE marker after the skipped scan");
+
+            if (markerCode == JpegMarkerCode::JpegLSPresetParameters)
+            {
+                ReadPresetParametersSegment();
+            }
+            ReadStartOfScan(markerCode == JpegMarkerCode::StartOfScan);
+            continue;
+        }
+
+        std::unique_ptr<DecoderStrategy> qcodec;
+        std::unique_ptr<ProcessLine> processLine;
+        ProcessLinePipelined* pipeline = nullptr;
+        int64_t bytesDecoded = bytesPerPlane;
+        const MappingTable* mappingTable = _lineDecoded || !_reducedImages.empty() || _transformSamples || _usePixelLayout ? nullptr : GetScanMappingTable();
+        if (mappingTable)
+        {
+            qcodec = JlsCodecFactory<DecoderStrategy>().CreateCodec(_params, _params.custom);
+
+            const size_t bytesPerLine = static_cast<size_t>(_rect.Width) * mappingTable->entryWidth;
+            bytesDecoded = static_cast<int64_t>(bytesPerLine) * _rect.Height;
+            if (_params.bitsPerSample <= 8)
+            {
+                processLine = std::make_unique<ProcessLineMapped<uint8_t>>(rawPixels, *mappingTable, bytesPerLine);
+            }
+            else
+            {
+                processLine = std::make_unique<ProcessLineMapped<uint16_t>>(rawPixels, *mappingTable, bytesPerLine);
+            }
+        }
+        else if (_lineDecoded)
+        {
+            qcodec = CreateBufferedCodec<DecoderStrategy>(_params);
+
+            const size_t lineByteCount = static_cast<size_t>(_rect.Width) * (_params.interleaveMode == InterleaveMode::None ? 1 : _params.components) * ((_params.bitsPerSample + 7) / 8);
+            processLine = CreateBufferedProcess<ProcessLineCallback>(*qcodec, lineByteCount, _lineDecoded, nullptr, _lineDecodedContext);
+        }
+        else if (_usePixelLayout)
+        {
+            qcodec = CreateBufferedCodec<DecoderStrategy>(_params);
+            processLine = CreateLayoutProcess(*qcodec, rawPixels.rawData, componentIndex, decodedComponentCount == 0);
+
+            // Every scan stores its components in the complete layout.
+            bytesDecoded = 0;
+        }
+        else if (_transformSamples)
+        {
+            qcodec = CreateBufferedCodec<DecoderStrategy>(_params);
+
+            const int32_t componentsPerLine = _params.interleaveMode == InterleaveMode::None ? 1 : _params.components;
+            if (_params.bitsPerSample <= 8)
+            {
+                processLine = bytesPerSample == 1 ?
+                    CreateBufferedProcess<ProcessLineLookup<uint8_t, uint8_t>>(*qcodec, rawPixels, _params.stride, _sampleTransform, _params.bitsPerSample, _rect.Width, componentsPerLine) :
+                    CreateBufferedProcess<ProcessLineLookup<uint8_t, uint16_t>>(*qcodec, rawPixels, _params.stride, _sampleTransform, _params.bitsPerSample, _rect.Width, componentsPerLine);
+            }
+            else
+            {
+                processLine = bytesPerSample == 1 ?
+                    CreateBufferedProcess<ProcessLineLookup<uint16_t, uint8_t>>(*qcodec, rawPixels, _params.stride, _sampleTransform, _params.bitsPerSample, _rect.Width, componentsPerLine) :
+                    CreateBufferedProcess<ProcessLineLookup<uint16_t, uint16_t>>(*qcodec, rawPixels, _params.stride, _sampleTransform, _params.bitsPerSample, _rect.Width, componentsPerLine);
+            }
+        }
+        else if (!_reducedImages.empty())
+        {
+            qcodec = CreateBufferedCodec<DecoderStrategy>(_params);
+
+            const int32_t componentsPerLine = _params.interleaveMode == InterleaveMode::None ? 1 : _params.components;
+            const int32_t plane = _params.interleaveMode == InterleaveMode::None ? decodedComponentCount : 0;
+            processLine = _params.bitsPerSample <= 8 ?
+                CreateBufferedProcess<ProcessLineReduced<uint8_t>>(*qcodec, rawPixels, _params.stride, _reducedImages, _rect.Width, _rect.Height, componentsPerLine, plane) :
+                CreateBufferedProcess<ProcessLineReduced<uint16_t>>(*qcodec, rawPixels, _params.stride, _reducedImages, _rect.Width, _rect.Height, componentsPerLine, plane);
+        }
+        else
+        {
+            qcodec = JlsCodecFactory<DecoderStrategy>().CreateCodec(_params, _params.custom);
+            if (_pipelineExecutor)
+            {
+                auto pipelinedProcess = CreatePipelinedProcess(qcodec->CreateProcess(rawPixels), _params, 0, *_pipelineExecutor);
+                pipeline = pipelinedProcess.get();
+                processLine = move(pipelinedProcess);
+            }
+        }
+        if (_fragmentCount != 0)
+        {
+            qcodec->SetFragments(_fragments, _fragmentCount, _nextFragment - 1);
+        }
 
-        std::unique_ptr<DecoderStrategy> qcodec = JlsCodecFactory<DecoderStrategy>().CreateCodec(_params, _params.custom);
-        std::unique_ptr<ProcessLine> processLine(qcodec->CreateProcess(rawPixels));
-        qcodec->DecodeScan(move(processLine), _rect, _byteStream);
-        SkipBytes(rawPixels, static_cast<size_t>(bytesPerPlane));
+        if (processLine)
+        {
+            qcodec->DecodeScan(move(processLine), _rect, _byteStream);
+        }
+        else
+        {
+            qcodec->DecodeScan(rawPixels, _rect, _byteStream);
+        }
+
+        if (pipeline)
+        {
+            pipeline->Finish();
+        }
+        if (_fragmentCount != 0)
+        {
+            _nextFragment = qcodec->GetNextFragment();
+        }
+        SkipBytes(rawPixels, static_cast<size_t>(bytesDecoded));
+
+        if (_params.height == 0)
+        {
+            ReadDefineNumberOfLines();
+        }
 
-        if (_params.interleaveMode != InterleaveMode::None)
+        ++decodedComponentCount;
+        if (_params.interleaveMode != InterleaveMode::None || decodedComponentCount == selectedComponentCount)
             return;
 
-        componentIndex += 1;
+        ReadStartOfScan(false);
+    }
+}
+
+
+void JpegStreamReader::CheckReducedImages(int selectedComponentCount) const
+{
+    for (const auto& image : _reducedImages)
+    {
+        if (image.scale < 1 || image.scale > 256)
+            throw charls_error(ApiResult::InvalidJlsParameters, "scale needs to be in the range [1, 256]");
+
+        if (!image.destination)
+            throw charls_error(ApiResult::InvalidJlsParameters, "the destination of a reduced image cannot be NULL");
+
+        const size_t byteCount = static_cast<size_t>((_rect.Width + image.scale - 1) / image.scale) * ((_rect.Height + image.scale - 1) / image.scale) *
+            selectedComponentCount * ((_params.bitsPerSample + 7) / 8);
+        if (image.destinationLength < byteCount)
+            throw charls_error(ApiResult::UncompressedBufferTooSmall, "The destination of a reduced image is too small");
+    }
+}
+
+
+void JpegStreamReader::CheckSampleTransform() const
+{
+    if (!_transformSamples)
+        return;
+
+    if (!_reducedImages.empty() || _lineDecoded)
+        throw charls_error(ApiResult::ParameterValueNotSupported, "A sample transform cannot be combined with reduced images or a line callback");
+
+    if (_sampleTransform.outputBitsPerSample < 1 || _sampleTransform.outputBitsPerSample > 16)
+        throw charls_error(ApiResult::InvalidJlsParameters, "outputBitsPerSample needs to be in the range [1, 16]");
+
+    switch (_sampleTransform.type)
+    {
+    case SampleTransform::Window:
+        if (!(_sampleTransform.windowWidth >= 1))
+            throw charls_error(ApiResult::InvalidJlsParameters, "windowWidth needs to be at least 1");
+        break;
+
+    case SampleTransform::Shift:
+        if (_sampleTransform.shift < 0 || _sampleTransform.shift > 15)
+            throw charls_error(ApiResult::InvalidJlsParameters, "shift needs to be in the range [0, 15]");
+        break;
+
+    case SampleTransform::LookupTable:
+        if (!_sampleTransform.lookupTable || _sampleTransform.lookupTableEntryCount == 0)
+            throw charls_error(ApiResult::InvalidJlsParameters, "the lookup table needs at least 1 entry");
+        break;
+
+    default:
+        throw charls_error(ApiResult::InvalidJlsParameters, "type needs to be set to a value of {Window, Shift, LookupTable}");
+    }
+}
+
+
+void JpegStreamReader::CheckPixelLayout(std::size_t destinationLength)
+{
+    if (_params.components > 4)
+        throw charls_error(ApiResult::ParameterValueNotSupported, "A pixel layout can only be applied to images with up to 4 components");
+
+    if (_pixelLayout.interleaved && (_pixelLayout.channelCount < _params.components || _pixelLayout.channelCount > 255))
+        throw charls_error(ApiResult::InvalidJlsParameters, "channelCount needs to be in the range [components, 255]");
+
+    const int32_t channelCount = _pixelLayout.interleaved ? _pixelLayout.channelCount : _params.components;
+    for (int32_t component = 0; component < _params.components; ++component)
+    {
+        const int channel = _pixelLayout.componentChannels[component];
+        if (channel < 0 || channel >= channelCount || std::count(_pixelLayout.componentChannels, _pixelLayout.componentChannels + _params.components, channel) != 1)
+            throw charls_error(ApiResult::InvalidJlsParameters, "componentChannels needs to hold a different channel for every component");
+    }
+
+    if (_pixelLayout.orientation < Orientation::Normal || _pixelLayout.orientation > Orientation::Rotate270)
+        throw charls_error(ApiResult::InvalidJlsParameters, "orientation is not a valid orientation");
+
+    // The destination of a rotated image is height pixels wide and width lines high.
+    const bool rotated = _pixelLayout.orientation == Orientation::Rotate90 || _pixelLayout.orientation == Orientation::Rotate270;
+    const int32_t destinationWidth = rotated ? _rect.Height : _rect.Width;
+    const int32_t destinationHeight = rotated ? _rect.Width : _rect.Height;
+    const size_t bytesPerSample = (_params.bitsPerSample + 7) / 8;
+    const size_t minimumStride = static_cast<size_t>(destinationWidth) * (_pixelLayout.interleaved ? channelCount : 1) * bytesPerSample;
+    if (_pixelLayout.stride == 0)
+    {
+        _pixelLayout.stride = minimumStride;
+    }
+    else if (_pixelLayout.stride < minimumStride || _pixelLayout.stride % bytesPerSample != 0)
+        throw charls_error(ApiResult::InvalidJlsParameters, "stride needs to be 0 or a multiple of the sample size that holds a line");
+
+    const size_t planeCount = _pixelLayout.interleaved ? 1 : _params.components;
+    if (destinationLength < _pixelLayout.stride * destinationHeight * planeCount)
+        throw charls_error(ApiResult::UncompressedBufferTooSmall);
+}
+
+
+std::unique_ptr<ProcessLine> JpegStreamReader::CreateLayoutProcess(DecoderStrategy& codec, uint8_t* rawData, int componentIndex, bool fillPadding) const
+{
+    const int32_t componentsPerLine = _params.interleaveMode == InterleaveMode::None ? 1 : _params.components;
+    const int32_t firstComponent = _params.interleaveMode == InterleaveMode::None ? componentIndex : 0;
+    return _params.bitsPerSample <= 8 ?
+        CreateBufferedProcess<ProcessLineLayout<uint8_t>>(codec, rawData, _pixelLayout, _params.components, _rect.Width, _rect.Height, componentsPerLine, firstComponent, fillPadding) :
+        CreateBufferedProcess<ProcessLineLayout<uint16_t>>(codec, rawData, _pixelLayout, _params.components, _rect.Width, _rect.Height, componentsPerLine, firstComponent, fillPadding);
+}
+
+
+void JpegStreamReader::ReadBandedScans(uint8_t* rawData)
+{
+    // The scans are found with a search for the next marker (without decoding) and decoded together in bands of lines:
+    // the interleaved output lines of a band are still in the cache when the next component is stored in them.
+    std::vector<std::unique_ptr<DecoderStrategy>> codecs;
+    for (int componentIndex = 0;; ++componentIndex)
+    {
+        if (IsComponentSelected(componentIndex))
+        {
+            auto codec = CreateBufferedCodec<DecoderStrategy>(_params);
+            ByteStreamInfo scanData = _byteStream;
+            codec->StartDecodeScan(CreateLayoutProcess(*codec, rawData, componentIndex, codecs.empty()), _rect, scanData);
+            codecs.push_back(move(codec));
+        }
+
+        const JpegMarkerCode markerCode = SkipScanData();
+        if (componentIndex == _params.components - 1)
+            break;
+
+        if (markerCode != JpegMarkerCode::StartOfScan && markerCode != JpegMarkerCode::JpegLSPresetParameters)
+            throw charls_error(ApiResult::InvalidCompressedData, "Expected a SOS or LSE marker after the scan");
+
+        if (markerCode == JpegMarkerCode::JpegLSPresetParameters)
+        {
+            ReadPresetParametersSegment();
+        }
+        ReadStartOfScan(markerCode == JpegMarkerCode::StartOfScan);
+    }
+
+    const int32_t bandHeight = static_cast<int32_t>(std::max<size_t>(1, std::min<size_t>(BandByteCount / _pixelLayout.stride, _rect.Height)));
+    for (int32_t line = 0; line < _rect.Height; line += bandHeight)
+    {
+        const int32_t lineCount = std::min(bandHeight, _rect.Height - line);
+        for (auto& codec : codecs)
+        {
+            codec->DecodeLines(lineCount);
+        }
+    }
+
+    for (auto& codec : codecs)
+    {
+        codec->EndScan();
+    }
+}
+
+
+const MappingTable* JpegStreamReader::GetScanMappingTable() const
+{
+    if (!_applyMappingTable)
+        return nullptr;
+
+    const int tableId = _scanMappingTableIds.empty() ? 0 : _scanMappingTableIds[0];
+    if (_scanMappingTableIds.size() > 1)
+    {
+        if (std::any_of(_scanMappingTableIds.begin(), _scanMappingTableIds.end(), [](int id) { return id != 0; }))
+            throw charls_error(ApiResult::ParameterValueNotSupported, "Mapping tables can only be applied to scans with 1 component");
+    }
+
+    if (tableId == 0)
+        return nullptr;
+
+    const MappingTable* table = GetMappingTable(tableId);
+    if (!table)
+        throw charls_error(ApiResult::InvalidCompressedData, "The scan selects a mapping table that is not defined");
+
+    return table;
+}
+
+
+const MappingTable* JpegStreamReader::GetMappingTable(int tableId) const noexcept
+{
+    const auto table = std::find_if(_mappingTables.begin(), _mappingTables.end(), [=](const MappingTable& t) { return t.tableId == tableId; });
+    return table == _mappingTables.end() ? nullptr : &*table;
+}
+
+
+bool JpegStreamReader::IsComponentSelected(int componentIndex) const noexcept
+{
+    return componentIndex < 32 && (_componentMask >> componentIndex & 1) != 0;
+}
+
+
+int JpegStreamReader::GetSelectedComponentCount() const
+{
+    int count = 0;
+    for (int componentIndex = 0; componentIndex < _params.components; ++componentIndex)
+    {
+        if (IsComponentSelected(componentIndex))
+        {
+            ++count;
+        }
+    }
+
+    if (count == 0)
+        throw charls_error(ApiResult::InvalidJlsParameters, "The component mask doesn't select any component");
+
+    if (count != _params.components && _params.interleaveMode != InterleaveMode::None)
+        throw charls_error(ApiResult::ParameterValueNotSupported, "Components can only be selected for interleave mode None (1 scan per component)");
+
+    return count;
+}
+
+
+JpegMarkerCode JpegStreamReader::SkipScanData()
+{
+    // Bit stuffing guarantees that a 0xFF byte in the scan data is followed by a byte < 0x80:
+    // the first 0xFF byte followed by a byte >= 0x80 starts the next marker, no entropy decoding is needed.
+    for (;;)
+    {
+        if (!_byteStream.rawStream && _byteStream.count > 1)
+        {
+            const uint8_t* const end = _byteStream.rawData + _byteStream.count;
+            const uint8_t* const marker = FindMarker(_byteStream.rawData, end);
+            SkipBytes(_byteStream, static_cast<size_t>(marker == end ? marker - 1 - _byteStream.rawData : marker - _byteStream.rawData));
+        }
+
+        if (ReadByte() != 0xFF)
+            continue;
+
+        uint8_t code = ReadByte();
+        while (code == 0xFF)
+        {
+            code = ReadByte();
+        }
+
+        if (code >= 0x80)
+            return static_cast<JpegMarkerCode>(code);
+    }
+}
+
+
+void JpegStreamReader::CheckParameterCoherent() const
+{
+    if (_params.bitsPerSample < 2 || _params.bitsPerSample > 16)
+        throw charls_error(ApiResult::ParameterValueNotSupported);
+
+    if (_params.width < 1 || static_cast<int64_t>(_params.width) * _params.components * ((_params.bitsPerSample + 7) / 8) > INT32_MAX)
+        throw charls_error(ApiResult::ParameterValueNotSupported, "The size of a line needs to be in the range [1, 2 GiB)");
+
+    if (_params.interleaveMode < InterleaveMode::None || _params.interleaveMode > InterleaveMode::Sample)
+        throw charls_error(ApiResult::InvalidCompressedData);
+
+    switch (_params.components)
+    {
+        case 4:
+            if (_params.interleaveMode == InterleaveMode::Sample)
+                throw charls_error(ApiResult::ParameterValueNotSupported);
+            break;
+
+        case 3:
+            break;
+
+        case 0:
+            throw charls_error(ApiResult::InvalidJlsParameters);
+
+        default:
+            if (_params.interleaveMode != InterleaveMode::None)
+                throw charls_error(ApiResult::ParameterValueNotSupported);
+            break;
     }
 }
 
 
 void JpegStreamReader::ReadNBytes(std::vector<char>& dst, int byteCount)
 {
+    if (_byteStream.rawStream)
+    {
+        const std::size_t offset = dst.size();
+        dst.resize(offset + byteCount);
+        if (_byteStream.rawStream->sgetn(dst.data() + offset, byteCount) != byteCount)
+            throw charls_error(ApiResult::CompressedBufferTooSmall);
+        return;
+    }
+
     for (int i = 0; i < byteCount; ++i)
     {
         dst.push_back(static_cast<char>(ReadByte()));
@@ -160,9 +657,25 @@ void JpegStreamReader::ReadHeader()
         if (paddingToRead < 0)
             throw charls_error(ApiResult::InvalidCompressedData);
 
-        for (int i = 0; i < paddingToRead; ++i)
+        SkipNBytes(paddingToRead);
+    }
+}
+
+
+void JpegStreamReader::SkipNBytes(int byteCount)
+{
+    while (byteCount > 0)
+    {
+        if (!_byteStream.rawStream && _byteStream.count != 0)
+        {
+            const int count = static_cast<int>(std::min<size_t>(_byteStream.count, static_cast<size_t>(byteCount)));
+            SkipBytes(_byteStream, static_cast<size_t>(count));
+            byteCount -= count;
+        }
+        else
         {
             ReadByte();
+            --byteCount;
         }
     }
 }
@@ -204,7 +717,7 @@ int JpegStreamReader::ReadMarkerSegment(JpegMarkerCode markerCode, int32_t segme
             return ReadComment();
 
         case JpegMarkerCode::JpegLSPresetParameters:
-            return ReadPresetParameters();
+            return ReadPresetParameters(segmentSize);
 
         case JpegMarkerCode::ApplicationData0:
         case JpegMarkerCode::ApplicationData1:
@@ -242,7 +755,7 @@ int JpegStreamReader::ReadMarkerSegment(JpegMarkerCode markerCode, int32_t segme
                 throw charls_error(ApiResult::UnsupportedEncoding, message.str());
             }
 
-        // Other tags not supported (among which DNL DRI)
+        // Other tags not supported (among which DRI), DNL is only valid after the first scan.
         default:
             {
                 std::ostringstream message;
@@ -253,7 +766,7 @@ int JpegStreamReader::ReadMarkerSegment(JpegMarkerCode markerCode, int32_t segme
 }
 
 
-int JpegStreamReader::ReadPresetParameters()
+int JpegStreamReader::ReadPresetParameters(int32_t segmentSize)
 {
     const int type = ReadByte();
 
@@ -271,12 +784,11 @@ int JpegStreamReader::ReadPresetParameters()
 
     case 2: // mapping table specification
     case 3: // mapping table continuation
+        return ReadMappingTable(type == 3, segmentSize);
+
     case 4: // X and Y parameters greater than 16 bits are defined.
-        {
-            std::ostringstream message;
-            message << "JPEG-LS preset parameters with type " << static_cast<unsigned int>(type) << " are not supported.";
-            throw charls_error(ApiResult::UnsupportedEncoding, message.str());
-        }
+        return ReadOversizeImageDimension();
+
     default:
         {
             std::ostringstream message;
@@ -287,14 +799,93 @@ int JpegStreamReader::ReadPresetParameters()
 }
 
 
+void JpegStreamReader::ReadPresetParametersSegment()
+{
+    const int32_t segmentSize = ReadUInt16();
+    const int paddingToRead = segmentSize - 2 - ReadPresetParameters(segmentSize - 2);
+    if (paddingToRead < 0)
+        throw charls_error(ApiResult::InvalidCompressedData);
+
+    SkipNBytes(paddingToRead);
+}
+
+
+int JpegStreamReader::ReadOversizeImageDimension()
+{
+    const int dimensionSize = ReadByte();
+    if (dimensionSize < 2 || dimensionSize > 4)
+        throw charls_error(ApiResult::InvalidCompressedData, "Invalid oversize image dimension segment");
+
+    uint32_t dimensions[2]{};
+    for (auto& dimension : dimensions)
+    {
+        for (int i = 0; i < dimensionSize; ++i)
+        {
+            dimension = dimension << 8 | ReadByte();
+        }
+
+        if (dimension > INT32_MAX)
+            throw charls_error(ApiResult::ParameterValueNotSupported, "Image dimensions above 2147483647 are not supported");
+    }
+
+    _params.height = static_cast<int>(dimensions[0]);
+    _params.width = static_cast<int>(dimensions[1]);
+    return 2 + 2 * dimensionSize;
+}
+
+
+int JpegStreamReader::ReadMappingTable(bool continuation, int32_t segmentSize)
+{
+    if (segmentSize < 3)
+        throw charls_error(ApiResult::InvalidCompressedData);
+
+    const int tableId = ReadByte();
+    const int entryWidth = ReadByte();
+    const int byteCount = segmentSize - 3;
+    if (tableId == 0 || entryWidth == 0 || byteCount % entryWidth != 0)
+        throw charls_error(ApiResult::InvalidCompressedData, "Invalid mapping table segment");
+
+    auto table = std::find_if(_mappingTables.begin(), _mappingTables.end(), [=](const MappingTable& t) { return t.tableId == tableId; });
+    if (continuation)
+    {
+        if (table == _mappingTables.end() || table->entryWidth != entryWidth)
+            throw charls_error(ApiResult::InvalidCompressedData, "Mapping table continuation without a matching specification");
+    }
+    else if (table == _mappingTables.end())
+    {
+        _mappingTables.push_back(MappingTable{ tableId, entryWidth, {} });
+        table = _mappingTables.end() - 1;
+    }
+    else
+    {
+        // A new specification replaces the table.
+        table->entryWidth = entryWidth;
+        table->entries.clear();
+    }
+
+    std::vector<char> entries;
+    ReadNBytes(entries, byteCount);
+    table->entries.insert(table->entries.end(), entries.begin(), entries.end());
+    return segmentSize;
+}
+
+
 void JpegStreamReader::ReadStartOfScan(bool firstComponent)
 {
     if (!firstComponent)
     {
-        if (ReadByte() != 0xFF)
-            throw charls_error(ApiResult::MissingJpegMarkerStart);
-        if (static_cast<JpegMarkerCode>(ReadByte()) != JpegMarkerCode::StartOfScan)
-            throw charls_error(ApiResult::InvalidCompressedData);// TODO: throw more specific error code.
+        // Mapping tables (and preset parameters) can be defined between the scans.
+        for (;;)
+        {
+            const JpegMarkerCode markerCode = ReadNextMarkerCode();
+            if (markerCode == JpegMarkerCode::StartOfScan)
+                break;
+
+            if (markerCode != JpegMarkerCode::JpegLSPresetParameters)
+                throw charls_error(ApiResult::InvalidCompressedData, "Expected a SOS or LSE marker after the scan");
+
+            ReadPresetParametersSegment();
+        }
     }
     int length = ReadByte();
     length = length * 256 + ReadByte(); // TODO: do something with 'length' or remove it.
@@ -303,10 +894,11 @@ void JpegStreamReader::ReadStartOfScan(bool firstComponent)
     if (componentCount != 1 && componentCount != _params.components)
         throw charls_error(ApiResult::ParameterValueNotSupported);
 
+    _scanMappingTableIds.clear();
     for (int i = 0; i < componentCount; ++i)
     {
-        ReadByte();
-        ReadByte();
+        ReadByte();                                 // Ci = Component identifier
+        _scanMappingTableIds.push_back(ReadByte()); // Tmi = Mapping table selector
     }
     _params.allowedLossyError = ReadByte();
     _params.interleaveMode = static_cast<InterleaveMode>(ReadByte());
@@ -315,15 +907,34 @@ void JpegStreamReader::ReadStartOfScan(bool firstComponent)
     if (ReadByte() != 0)
         throw charls_error(ApiResult::InvalidCompressedData);// TODO: throw more specific error code.
 
+    // The interleave mode is only known after the SOS: the line count of a DNL segment applies to all components of 1 scan.
+    if (_params.height == 0 && _params.interleaveMode == InterleaveMode::None && _params.components > 1)
+        throw charls_error(ApiResult::ParameterValueNotSupported, "A DNL segment is only supported for images with 1 scan");
+
     if(_params.stride == 0)
     {
         const int width = _rect.Width != 0 ? _rect.Width : _params.width;
         const int components = _params.interleaveMode == InterleaveMode::None ? 1 : _params.components;
-        _params.stride = components * width * ((_params.bitsPerSample + 7) / 8);
+        const int bitsPerSample = _transformSamples ? _sampleTransform.outputBitsPerSample : _params.bitsPerSample;
+        _params.stride = components * width * ((bitsPerSample + 7) / 8);
     }
 }
 
 
+void JpegStreamReader::ReadDefineNumberOfLines()
+{
+    if (ReadNextMarkerCode() != JpegMarkerCode::DefineNumberOfLines)
+        throw charls_error(ApiResult::InvalidCompressedData, "Expected a DNL segment after the scan of an image with 0 lines");
+
+    if (ReadUInt16() != 4)
+        throw charls_error(ApiResult::InvalidCompressedData);
+
+    _params.height = ReadUInt16();
+    if (_params.height == 0)
+        throw charls_error(ApiResult::InvalidCompressedData);
+}
+
+
 int JpegStreamReader::ReadComment() noexcept
 {
     return 0;
@@ -371,6 +982,12 @@ uint8_t JpegStreamReader::ReadByte()
     if (_byteStream.rawStream)
         return static_cast<uint8_t>(_byteStream.rawStream->sbumpc());
 
+    while (_byteStream.count == 0 && _nextFragment < _fragmentCount)
+    {
+        _byteStream = FromByteArrayConst(_fragments[_nextFragment].data, _fragments[_nextFragment].length);
+        ++_nextFragment;
+    }
+
     if (_byteStream.count == 0)
         throw charls_error(ApiResult::CompressedBufferTooSmall);
 
@@ -4,14 +4,17 @@
 #ifndef CHARLS_JPEG_STREAM_READER
 #define CHARLS_JPEG_STREAM_READER
 
-#include "publictypes.h"
+#include "charls.h"
+#include "processlinemapped.h"
 #include <cstdint>
+#include <memory>
 #include <vector>
 
 
 enum class JpegMarkerCode : uint8_t;
 struct JlsParameters;
 class JpegCustomParameters;
+class DecoderStrategy;
 
 
 JpegLSPresetCodingParameters ComputeDefault(int32_t maximumSampleValue, int32_t allowedLossyError) noexcept;
@@ -24,6 +27,7 @@ class JpegStreamReader
 {
 public:
     explicit JpegStreamReader(ByteStreamInfo byteStreamInfo) noexcept;
+    JpegStreamReader(const JlsFragment* fragments, std::size_t fragmentCount) noexcept;
 
     const JlsParameters& GetMetadata() const noexcept
     {
@@ -37,6 +41,12 @@ public:
 
     void Read(ByteStreamInfo rawPixels);
     void ReadHeader();
+    void CheckParameterCoherent() const;
+
+    std::size_t GetBytesRemaining() const noexcept
+    {
+        return _byteStream.count;
+    }
 
     void SetInfo(const JlsParameters& params) noexcept
     {
@@ -48,16 +58,80 @@ public:
         _rect = rect;
     }
 
+    void SetComponentMask(uint32_t componentMask) noexcept
+    {
+        _componentMask = componentMask;
+    }
+
+    // Applies the mapping tables that are selected by the scans: the output holds the table entries instead of the indices.
+    void SetApplyMappingTable(bool applyMappingTable) noexcept
+    {
+        _applyMappingTable = applyMappingTable;
+    }
+
+    // Returns the mapping table that is selected by the first component of the current scan or null.
+    const MappingTable* GetMappingTable() const noexcept
+    {
+        return _scanMappingTableIds.empty() ? nullptr : GetMappingTable(_scanMappingTableIds[0]);
+    }
+
+    // Maps the decoded samples to output samples (window, shift or lookup table) while the lines are stored.
+    void SetSampleTransform(const JlsSampleTransform& transform) noexcept
+    {
+        _sampleTransform = transform;
+        _transformSamples = true;
+    }
+
+    // Stores the decoded pixels in the given layout, scans of interleave mode None are decoded together in bands of lines.
+    void SetPixelLayout(const JlsPixelLayout& layout) noexcept
+    {
+        _pixelLayout = layout;
+        _usePixelLayout = true;
+    }
+
+    // Box filters the decoded lines into reduced resolution images, the full resolution output is optional.
+    void SetReducedImages(const JlsReducedImage* reducedImages, std::size_t reducedImageCount)
+    {
+        _reducedImages.assign(reducedImages, reducedImages + reducedImageCount);
+    }
+
+    void SetLineCallback(JlsLineDecodedCallback lineDecoded, void* context) noexcept
+    {
+        _lineDecoded = lineDecoded;
+        _lineDecodedContext = context;
+    }
+
+    // Converts and stores the decoded lines on a task of the executor while the next lines are decoded.
+    void SetPipelineExecutor(const JlsExecutor& executor) noexcept
+    {
+        _pipelineExecutor = &executor;
+    }
+
     void ReadStartOfScan(bool firstComponent);
+    void ReadDefineNumberOfLines();
     uint8_t ReadByte();
 
 private:
     JpegMarkerCode ReadNextMarkerCode();
-    int ReadPresetParameters();
+    JpegMarkerCode SkipScanData();
+    bool IsComponentSelected(int componentIndex) const noexcept;
+    int GetSelectedComponentCount() const;
+    int ReadPresetParameters(int32_t segmentSize);
+    void ReadPresetParametersSegment();
+    int ReadMappingTable(bool continuation, int32_t segmentSize);
+    int ReadOversizeImageDimension();
+    const MappingTable* GetMappingTable(int tableId) const noexcept;
+    const MappingTable* GetScanMappingTable() const;
+    void CheckReducedImages(int selectedComponentCount) const;
+    void CheckSampleTransform() const;
+    void CheckPixelLayout(std::size_t destinationLength);
+    std::unique_ptr<ProcessLine> CreateLayoutProcess(DecoderStrategy& codec, uint8_t* rawData, int componentIndex, bool fillPadding) const;
+    void ReadBandedScans(uint8_t* rawData);
     static int ReadComment() noexcept;
     int ReadStartOfFrame();
     int ReadUInt16();
     void ReadNBytes(std::vector<char>& dst, int byteCount);
+    void SkipNBytes(int byteCount);
     int ReadMarkerSegment(JpegMarkerCode markerCode, int32_t segmentSize);
 
     void ReadJfif();
@@ -65,8 +139,23 @@ private:
     int TryReadHPColorTransformSegment(int32_t segmentSize);
 
     ByteStreamInfo _byteStream;
+    const JlsFragment* _fragments;
+    std::size_t _fragmentCount;
+    std::size_t _nextFragment;
     JlsParameters _params;
     JlsRect _rect;
+    uint32_t _componentMask;
+    bool _applyMappingTable;
+    bool _transformSamples;
+    JlsSampleTransform _sampleTransform;
+    bool _usePixelLayout;
+    JlsPixelLayout _pixelLayout;
+    std::vector<MappingTable> _mappingTables;
+    std::vector<int> _scanMappingTableIds;
+    std::vector<JlsReducedImage> _reducedImages;
+    JlsLineDecodedCallback _lineDecoded;
+    void* _lineDecodedContext;
+    const JlsExecutor* _pipelineExecutor;
 };
 
 
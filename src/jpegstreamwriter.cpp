@@ -9,6 +9,7 @@
 #include "jpegmarkersegment.h"
 #include "jpegstreamreader.h"
 #include <vector>
+#include <algorithm>
 
 using namespace charls;
 
@@ -41,7 +42,9 @@ bool IsDefault(const JpegLSPresetCodingParameters& custom) noexcept
 JpegStreamWriter::JpegStreamWriter() noexcept
     : _data(),
       _byteOffset(0),
-      _lastCompenentIndex(0)
+      _lastCompenentIndex(0),
+      _mappingTableId(0),
+      _pipelineExecutor(nullptr)
 {
 }
 
@@ -52,24 +55,113 @@ void JpegStreamWriter::AddColorTransform(ColorTransformation transformation)
 }
 
 
+void JpegStreamWriter::AddStartOfFrame(const JlsParameters& params)
+{
+    const bool oversize = params.width > UINT16_MAX || params.height > UINT16_MAX;
+    AddSegment(JpegMarkerSegment::CreateStartOfFrameSegment(params.width > UINT16_MAX ? 0 : params.width,
+        params.height > UINT16_MAX ? 0 : params.height, params.bitsPerSample, params.components));
+
+    if (oversize)
+    {
+        AddSegment(JpegMarkerSegment::CreateOversizeImageDimensionSegment(params.width, params.height));
+    }
+}
+
+
+void JpegStreamWriter::AddMappingTable(const JlsMappingTable& table)
+{
+    // Entries of 2 bytes are passed in native byte order, the byte stream stores them big endian.
+    const auto entries = static_cast<const uint8_t*>(table.entries);
+    std::vector<uint8_t> bytes(entries, entries + static_cast<size_t>(table.entryCount) * table.entryWidth);
+    if (table.entryWidth == 2)
+    {
+        for (int i = 0; i < table.entryCount; ++i)
+        {
+            const uint16_t value = static_cast<const uint16_t*>(table.entries)[i];
+            bytes[2 * i] = static_cast<uint8_t>(value >> 8);
+            bytes[2 * i + 1] = static_cast<uint8_t>(value);
+        }
+    }
+
+    // A marker segment is limited to 65535 bytes: large tables are continued in type 3 segments.
+    const size_t maximumByteCount = (UINT16_MAX - 2 - 3) / table.entryWidth * table.entryWidth;
+    for (size_t offset = 0; offset < bytes.size(); offset += maximumByteCount)
+    {
+        AddSegment(JpegMarkerSegment::CreateMappingTableSegment(table.tableId, table.entryWidth, bytes.data() + offset,
+            std::min(maximumByteCount, bytes.size() - offset), offset != 0));
+    }
+
+    _mappingTableId = table.tableId;
+}
+
+
 size_t JpegStreamWriter::Write(const ByteStreamInfo& info)
+{
+    WriteSegments(info, true, true);
+    return _byteOffset;
+}
+
+
+void JpegStreamWriter::WriteSegments(const ByteStreamInfo& info, bool startOfImage, bool endOfImage)
 {
     _data = info;
+    _byteOffset = 0;
 
-    WriteMarker(JpegMarkerCode::StartOfImage);
+    if (startOfImage)
+    {
+        WriteMarker(JpegMarkerCode::StartOfImage);
+    }
 
     for (size_t i = 0; i < _segments.size(); ++i)
     {
         _segments[i]->Serialize(*this);
     }
+    _segments.clear();
 
-    WriteMarker(JpegMarkerCode::EndOfImage);
-
-    return _byteOffset;
+    if (endOfImage)
+    {
+        WriteMarker(JpegMarkerCode::EndOfImage);
+    }
 }
 
 
 void JpegStreamWriter::AddScan(const ByteStreamInfo& info, const JlsParameters& params)
+{
+    AddScanHeader(params);
+
+    const int componentCount = params.interleaveMode == InterleaveMode::None ? 1 : params.components;
+    AddSegment(std::make_unique<JpegImageDataSegment>(info, params, componentCount));
+}
+
+
+void JpegStreamWriter::AddScan(const ByteStreamInfo& info, const JlsParameters& params, SourceFormat sourceFormat)
+{
+    AddScanHeader(params);
+
+    const int componentCount = params.interleaveMode == InterleaveMode::None ? 1 : params.components;
+    AddSegment(std::make_unique<JpegImageDataSegment>(info, params, componentCount, sourceFormat));
+}
+
+
+void JpegStreamWriter::AddScan(JlsLineRequestedCallback lineRequested, void* context, const JlsParameters& params)
+{
+    AddScanHeader(params);
+
+    const int componentCount = params.interleaveMode == InterleaveMode::None ? 1 : params.components;
+    AddSegment(std::make_unique<JpegImageDataSegment>(lineRequested, context, params, componentCount));
+}
+
+
+void JpegStreamWriter::AddScan(const JlsSourceLayout& layout, int firstComponent, const JlsParameters& params)
+{
+    AddScanHeader(params);
+
+    const int componentCount = params.interleaveMode == InterleaveMode::None ? 1 : params.components;
+    AddSegment(std::make_unique<JpegImageDataSegment>(layout, firstComponent, params, componentCount));
+}
+
+
+void JpegStreamWriter::AddScanHeader(const JlsParameters& params)
 {
     if (!IsDefault(params.custom))
     {
@@ -84,7 +176,5 @@ void JpegStreamWriter::AddScan(const ByteStreamInfo& info, const JlsParameters&
     // Note: it is a common practice to start to count components by index 1.
     _lastCompenentIndex += 1;
     const int componentCount = params.interleaveMode == InterleaveMode::None ? 1 : params.components;
-    AddSegment(JpegMarkerSegment::CreateStartOfScanSegment(_lastCompenentIndex, componentCount, params.allowedLossyError, params.interleaveMode));
-
-    AddSegment(std::make_unique<JpegImageDataSegment>(info, params, componentCount));
+    AddSegment(JpegMarkerSegment::CreateStartOfScanSegment(_lastCompenentIndex, componentCount, params.allowedLossyError, params.interleaveMode, _mappingTableId));
 }
@@ -7,6 +7,7 @@
 
 #include "util.h"
 #include "jpegsegment.h"
+#include "charls.h"
 #include <vector>
 #include <memory>
 
@@ -31,8 +32,29 @@ public:
 
     void AddScan(const ByteStreamInfo& info, const JlsParameters& params);
 
+    // Adds a scan that converts the lines from the source format while they are encoded, params.stride is the stride of the source.
+    void AddScan(const ByteStreamInfo& info, const JlsParameters& params, charls::SourceFormat sourceFormat);
+    void AddScan(JlsLineRequestedCallback lineRequested, void* context, const JlsParameters& params);
+
+    // Adds a scan that reads its components directly from the source layout, firstComponent is the first component of the scan.
+    void AddScan(const JlsSourceLayout& layout, int firstComponent, const JlsParameters& params);
+
+    void AddScanHeader(const JlsParameters& params);
+
+    // Reads and converts the lines to encode on a task of the executor while the previous lines are encoded.
+    void SetPipelineExecutor(const JlsExecutor& executor) noexcept
+    {
+        _pipelineExecutor = &executor;
+    }
+
     void AddColorTransform(charls::ColorTransformation transformation);
 
+    // Adds the frame header, dimensions above 65535 are stored in an oversize image dimension (LSE type 4) segment.
+    void AddStartOfFrame(const JlsParameters& params);
+
+    // Adds the segments with the mapping table and selects the table for the components of all scans that are added next.
+    void AddMappingTable(const JlsMappingTable& table);
+
     std::size_t GetBytesWritten() const noexcept
     {
         return _byteOffset;
@@ -45,6 +67,9 @@ public:
 
     std::size_t Write(const ByteStreamInfo& info);
 
+    // Writes the segments added since the previous call and removes them, allows to write a JPEG-LS stream in parts.
+    void WriteSegments(const ByteStreamInfo& info, bool startOfImage, bool endOfImage);
+
 private:
     uint8_t* GetPos() const noexcept
     {
@@ -53,6 +78,9 @@ private:
 
     ByteStreamInfo OutputStream() const noexcept
     {
+        if (_data.rawStream)
+            return _data;
+
         ByteStreamInfo data = _data;
         data.count -= _byteOffset;
         data.rawData += _byteOffset;
@@ -63,23 +91,35 @@ private:
     {
         if (_data.rawStream)
         {
-            _data.rawStream->sputc(val);
+            if (_data.rawStream->sputc(static_cast<char>(val)) == std::char_traits<char>::eof())
+                throw charls_error(charls::ApiResult::CompressedBufferTooSmall);
         }
         else
         {
             if (_byteOffset >= _data.count)
                 throw charls_error(charls::ApiResult::CompressedBufferTooSmall);
 
-            _data.rawData[_byteOffset++] = val;
+            _data.rawData[_byteOffset] = val;
         }
+        ++_byteOffset;
     }
 
     void WriteBytes(const std::vector<uint8_t>& bytes)
     {
-        for (std::size_t i = 0; i < bytes.size(); ++i)
+        if (_data.rawStream)
+        {
+            const auto count = static_cast<std::streamsize>(bytes.size());
+            if (_data.rawStream->sputn(reinterpret_cast<const char*>(bytes.data()), count) != count)
+                throw charls_error(charls::ApiResult::CompressedBufferTooSmall);
+        }
+        else
         {
-            WriteByte(bytes[i]);
+            if (bytes.size() > _data.count - _byteOffset)
+                throw charls_error(charls::ApiResult::CompressedBufferTooSmall);
+
+            std::copy(bytes.begin(), bytes.end(), _data.rawData + _byteOffset);
         }
+        _byteOffset += bytes.size();
     }
 
     void WriteWord(uint16_t value)
@@ -96,15 +136,14 @@ private:
 
     void Seek(std::size_t byteCount) noexcept
     {
-        if (_data.rawStream)
-            return;
-
         _byteOffset += byteCount;
     }
 
     ByteStreamInfo _data;
     std::size_t _byteOffset;
     int32_t _lastCompenentIndex;
+    int32_t _mappingTableId;
+    const JlsExecutor* _pipelineExecutor;
     std::vector<std::unique_ptr<JpegSegment>> _segments;
 };
 
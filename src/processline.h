@@ -39,7 +39,7 @@ protected:
 };
 
 
-class PostProcesSingleComponent : public ProcessLine
+class PostProcesSingleComponent final : public ProcessLine
 {
 public:
     PostProcesSingleComponent(void* rawData, const JlsParameters& params, size_t bytesPerPixel) noexcept :
@@ -119,9 +119,9 @@ public:
             ByteSwap(static_cast<unsigned char*>(dest), 2 * pixelCount);
         }
 
-        if (_bytesPerLine - pixelCount * _bytesPerPixel > 0)
+        if (_bytesPerLine > pixelCount * _bytesPerPixel)
         {
-            _rawData->pubseekoff(static_cast<std::streamoff>(_bytesPerLine - bytesToRead), std::ios_base::cur);
+            _rawData->pubseekoff(static_cast<std::streamoff>(_bytesPerLine - pixelCount * _bytesPerPixel), std::ios_base::cur);
         }
     }
 
@@ -349,4 +349,82 @@ private:
 };
 
 
+//
+// ProcessTransformedRaw: the conversion of ProcessTransformed for pixels in a byte array, with the interleave mode, the number
+// of components and the BGR order as template parameters. The codec instantiates its line loop with this final class
+// (see JlsCodec::DecodeScan and EncodeScan), which allows the compiler to inline the conversion of every line: there is
+// no virtual call and no branch on the parameters per line.
+//
+template<typename TRANSFORM, charls::InterleaveMode INTERLEAVE_MODE, int COMPONENTS, bool OUTPUT_BGR>
+class ProcessTransformedRaw final : public ProcessLine
+{
+public:
+    ProcessTransformedRaw(uint8_t* rawData, const JlsParameters& params, TRANSFORM transform) :
+        _rawData(rawData),
+        _bytesPerLine(params.stride),
+        _templine(OUTPUT_BGR ? static_cast<size_t>(params.width) * COMPONENTS : 0),
+        _transform(transform),
+        _inverseTransform(transform)
+    {
+    }
+
+    void NewLineRequested(void* dest, int pixelCount, int destStride) override
+    {
+        const void* source = _rawData;
+        if (OUTPUT_BGR)
+        {
+            memcpy(_templine.data(), source, sizeof(size_type) * COMPONENTS * pixelCount);
+            TransformRgbToBgr(_templine.data(), COMPONENTS, pixelCount);
+            source = _templine.data();
+        }
+
+        if (INTERLEAVE_MODE == charls::InterleaveMode::Sample)
+        {
+            TransformLine(static_cast<Triplet<size_type>*>(dest), static_cast<const Triplet<size_type>*>(source), pixelCount, _transform);
+        }
+        else if (COMPONENTS == 3)
+        {
+            TransformTripletToLine(static_cast<const Triplet<size_type>*>(source), pixelCount, static_cast<size_type*>(dest), destStride, _transform);
+        }
+        else
+        {
+            TransformQuadToLine(static_cast<const Quad<size_type>*>(source), pixelCount, static_cast<size_type*>(dest), destStride, _transform);
+        }
+        _rawData += _bytesPerLine;
+    }
+
+    void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride) override
+    {
+        void* rawData = _rawData;
+        if (INTERLEAVE_MODE == charls::InterleaveMode::Sample)
+        {
+            TransformLine(static_cast<Triplet<size_type>*>(rawData), static_cast<const Triplet<size_type>*>(pSrc), pixelCount, _inverseTransform);
+        }
+        else if (COMPONENTS == 3)
+        {
+            TransformLineToTriplet(static_cast<const size_type*>(pSrc), sourceStride, static_cast<Triplet<size_type>*>(rawData), pixelCount, _inverseTransform);
+        }
+        else
+        {
+            TransformLineToQuad(static_cast<const size_type*>(pSrc), sourceStride, static_cast<Quad<size_type>*>(rawData), pixelCount, _inverseTransform);
+        }
+
+        if (OUTPUT_BGR)
+        {
+            TransformRgbToBgr(static_cast<size_type*>(rawData), COMPONENTS, pixelCount);
+        }
+        _rawData += _bytesPerLine;
+    }
+
+private:
+    using size_type = typename TRANSFORM::size_type;
+
+    uint8_t* _rawData;
+    size_t _bytesPerLine;
+    std::vector<size_type> _templine;
+    TRANSFORM _transform;
+    typename TRANSFORM::Inverse _inverseTransform;
+};
+
+
 #endif
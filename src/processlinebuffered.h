@@ -0,0 +1,56 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_BUFFERED
+#define CHARLS_PROCESS_LINE_BUFFERED
+
+#include "processline.h"
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+//
+// ProcessLineBuffered: base class of the line processes that work on a line buffer of their own instead of on the user buffer.
+// The conversion between the internal format and the user format is done by the ProcessLine of the codec, which is created on
+// the line buffer of this class (see CreateBufferedProcess). The codec must be created with stride 0, to let that ProcessLine
+// reuse the line buffer for every line: a decoded line is converted into the buffer before the derived class processes it, a
+// line to encode is converted from the buffer after the derived class has filled it. The line is processed while it is still
+// in the cache, without an intermediate image.
+//
+template<typename SAMPLE>
+class ProcessLineBuffered : public ProcessLine
+{
+public:
+    ByteStreamInfo GetLineBuffer() noexcept
+    {
+        return FromByteArray(_lineBuffer.data(), _lineBuffer.size() * sizeof(SAMPLE));
+    }
+
+    void SetLineProcess(std::unique_ptr<ProcessLine> lineProcess) noexcept
+    {
+        _lineProcess = std::move(lineProcess);
+    }
+
+protected:
+    explicit ProcessLineBuffered(std::size_t sampleCount) :
+        _lineBuffer(sampleCount)
+    {
+    }
+
+    std::vector<SAMPLE> _lineBuffer;
+    std::unique_ptr<ProcessLine> _lineProcess;
+};
+
+
+// Creates a ProcessLineBuffered derived process and the ProcessLine of the codec that converts to or from its line buffer.
+template<typename PROCESS, typename STRATEGY, typename... Args>
+std::unique_ptr<ProcessLine> CreateBufferedProcess(STRATEGY& codec, Args&&... args)
+{
+    auto process = std::make_unique<PROCESS>(std::forward<Args>(args)...);
+    process->SetLineProcess(codec.CreateProcess(process->GetLineBuffer()));
+    return process;
+}
+
+#endif
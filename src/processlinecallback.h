@@ -0,0 +1,48 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_CALLBACK
+#define CHARLS_PROCESS_LINE_CALLBACK
+
+#include "charls.h"
+#include "processlinebuffered.h"
+#include <memory>
+#include <vector>
+
+
+//
+// ProcessLineCallback: passes every decoded line to a user callback or requests every line to encode from a user callback.
+//
+class ProcessLineCallback : public ProcessLineBuffered<uint8_t>
+{
+public:
+    ProcessLineCallback(std::size_t lineByteCount, JlsLineDecodedCallback lineDecoded, JlsLineRequestedCallback lineRequested, void* context) :
+        ProcessLineBuffered<uint8_t>(lineByteCount),
+        _lineDecoded(lineDecoded),
+        _lineRequested(lineRequested),
+        _context(context)
+    {
+    }
+
+    void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride) override
+    {
+        _lineProcess->NewLineDecoded(pSrc, pixelCount, sourceStride);
+        if (_lineDecoded(_context, _lineBuffer.data(), pixelCount, _lineBuffer.size()) != 0)
+            throw charls_error(charls::ApiResult::UnexpectedFailure, "Decoding aborted by the line callback");
+    }
+
+    void NewLineRequested(void* pDest, int pixelCount, int destStride) override
+    {
+        if (_lineRequested(_context, _lineBuffer.data(), pixelCount, _lineBuffer.size()) != 0)
+            throw charls_error(charls::ApiResult::UnexpectedFailure, "Encoding aborted by the line callback");
+        _lineProcess->NewLineRequested(pDest, pixelCount, destStride);
+    }
+
+private:
+    JlsLineDecodedCallback _lineDecoded;
+    JlsLineRequestedCallback _lineRequested;
+    void* _context;
+};
+
+#endif
@@ -0,0 +1,227 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_LAYOUT
+#define CHARLS_PROCESS_LINE_LAYOUT
+
+#include "processlinebuffered.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+
+//
+// ProcessLineLayout: stores the decoded lines of a scan in the pixel layout of the caller (JlsPixelLayout), independent of the
+// interleave mode of the scan: every component is written to its own channel of the interleaved pixels or to its own plane.
+// A scan of interleave mode None writes 1 component, the scans of the other components fill the other channels.
+// The line buffer holds the line pixel interleaved, with the inverse color transformation applied.
+// The orientation of the layout (flip, mirror, rotation) is applied with signed line and pixel steps: every line is stored at
+// its final position while it is decoded, a rotation by 90 or 270 degrees stores a decoded line in a column of the destination.
+//
+template<typename SAMPLE>
+class ProcessLineLayout : public ProcessLineBuffered<SAMPLE>
+{
+public:
+    ProcessLineLayout(uint8_t* rawData, const JlsPixelLayout& layout, int32_t componentCount, int32_t width, int32_t height,
+        int32_t componentsPerLine, int32_t firstComponent, bool fillPadding) :
+        ProcessLineBuffered<SAMPLE>(static_cast<std::size_t>(width) * componentsPerLine),
+        _rawData(rawData),
+        _interleaved(layout.interleaved != 0),
+        _channelCount(layout.channelCount),
+        _width(width),
+        _componentsPerLine(componentsPerLine),
+        _line(0)
+    {
+        const auto stride = static_cast<std::ptrdiff_t>(layout.stride);
+        const auto pixelSize = static_cast<std::ptrdiff_t>(_interleaved ? _channelCount * sizeof(SAMPLE) : sizeof(SAMPLE));
+        const std::ptrdiff_t lastLine = height - 1;
+        const std::ptrdiff_t lastPixel = width - 1;
+        switch (layout.orientation)
+        {
+        case charls::Orientation::Normal:
+            SetSteps(0, stride, pixelSize);
+            break;
+
+        case charls::Orientation::FlipVertical:
+            SetSteps(lastLine * stride, -stride, pixelSize);
+            break;
+
+        case charls::Orientation::MirrorHorizontal:
+            SetSteps(lastPixel * pixelSize, stride, -pixelSize);
+            break;
+
+        case charls::Orientation::Rotate180:
+            SetSteps(lastLine * stride + lastPixel * pixelSize, -stride, -pixelSize);
+            break;
+
+        case charls::Orientation::Rotate90:
+            SetSteps(lastLine * pixelSize, -pixelSize, stride);
+            break;
+
+        case charls::Orientation::Rotate270:
+            SetSteps(lastPixel * stride, pixelSize, -stride);
+            break;
+        }
+        const bool rotated = layout.orientation == charls::Orientation::Rotate90 || layout.orientation == charls::Orientation::Rotate270;
+        _planeSize = layout.stride * (rotated ? width : height);
+
+        for (int32_t component = 0; component < componentsPerLine; ++component)
+        {
+            _channels.push_back(layout.componentChannels[firstComponent + component]);
+        }
+
+        if (fillPadding && _interleaved)
+        {
+            const int* const componentChannelsEnd = layout.componentChannels + componentCount;
+            for (int32_t channel = 0; channel < _channelCount; ++channel)
+            {
+                if (std::find(layout.componentChannels, componentChannelsEnd, channel) == componentChannelsEnd)
+                {
+                    _paddingChannels.push_back(channel);
+                }
+            }
+            _paddingValue = static_cast<SAMPLE>(layout.paddingValue);
+        }
+    }
+
+    void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride) override
+    {
+        _lineProcess->NewLineDecoded(pSrc, pixelCount, sourceStride);
+
+        uint8_t* line = _rawData + _origin + _lineStep * _line;
+        for (int32_t component = 0; component < _componentsPerLine; ++component)
+        {
+            if (_interleaved)
+            {
+                CopyComponent(component, line + _channels[component] * sizeof(SAMPLE));
+            }
+            else
+            {
+                CopyComponent(component, line + _planeSize * _channels[component]);
+            }
+        }
+
+        for (const int32_t channel : _paddingChannels)
+        {
+            uint8_t* destination = line + channel * sizeof(SAMPLE);
+            for (int32_t x = 0; x < _width; ++x)
+            {
+                *reinterpret_cast<SAMPLE*>(destination) = _paddingValue;
+                destination += _pixelStep;
+            }
+        }
+        ++_line;
+    }
+
+    void NewLineRequested(void* /*pDest*/, int /*pixelCount*/, int /*destStride*/) override
+    {
+        throw charls_error(charls::ApiResult::UnexpectedFailure, "A pixel layout can only be applied when decoding");
+    }
+
+private:
+    using ProcessLineBuffered<SAMPLE>::_lineBuffer;
+    using ProcessLineBuffered<SAMPLE>::_lineProcess;
+
+    void SetSteps(std::ptrdiff_t origin, std::ptrdiff_t lineStep, std::ptrdiff_t pixelStep) noexcept
+    {
+        _origin = origin;
+        _lineStep = lineStep;
+        _pixelStep = pixelStep;
+    }
+
+    void CopyComponent(int32_t component, uint8_t* destination) const noexcept
+    {
+        const SAMPLE* source = _lineBuffer.data() + component;
+        for (int32_t x = 0; x < _width; ++x)
+        {
+            *reinterpret_cast<SAMPLE*>(destination) = *source;
+            source += _componentsPerLine;
+            destination += _pixelStep;
+        }
+    }
+
+    uint8_t* _rawData;
+    bool _interleaved;
+    int32_t _channelCount;
+    std::ptrdiff_t _origin{};
+    std::ptrdiff_t _lineStep{};
+    std::ptrdiff_t _pixelStep{};
+    std::size_t _planeSize;
+    int32_t _width;
+    int32_t _componentsPerLine;
+    int32_t _line;
+    std::vector<int32_t> _channels;
+    std::vector<int32_t> _paddingChannels;
+    SAMPLE _paddingValue{};
+};
+
+
+//
+// ProcessLineGather: reads every line to encode directly from the pixel layout of the caller (JlsSourceLayout), independent of the
+// interleave mode of the scan: the components of the scan are gathered from their planes or channels into the line buffer, no
+// intermediate planar or interleaved image is needed. The line buffer holds the line pixel interleaved.
+//
+template<typename SAMPLE>
+class ProcessLineGather : public ProcessLineBuffered<SAMPLE>
+{
+public:
+    ProcessLineGather(const JlsSourceLayout& layout, int32_t width, int32_t componentsPerLine, int32_t firstComponent) :
+        ProcessLineBuffered<SAMPLE>(static_cast<std::size_t>(width) * componentsPerLine),
+        _layout(layout),
+        _width(width),
+        _componentsPerLine(componentsPerLine),
+        _firstComponent(firstComponent),
+        _line(0)
+    {
+    }
+
+    void NewLineRequested(void* pDest, int pixelCount, int destStride) override
+    {
+        for (int32_t i = 0; i < _componentsPerLine; ++i)
+        {
+            const int32_t component = _firstComponent + i;
+            if (_layout.interleaved)
+            {
+                const auto line = static_cast<const uint8_t*>(_layout.planes[0]) + _layout.strides[0] * _line;
+                CopyComponent(reinterpret_cast<const SAMPLE*>(line) + _layout.componentChannels[component], _layout.channelCount, i);
+            }
+            else
+            {
+                const auto line = static_cast<const uint8_t*>(_layout.planes[component]) + _layout.strides[component] * _line;
+                CopyComponent(reinterpret_cast<const SAMPLE*>(line), 1, i);
+            }
+        }
+        ++_line;
+
+        _lineProcess->NewLineRequested(pDest, pixelCount, destStride);
+    }
+
+    void NewLineDecoded(const void* /*pSrc*/, int /*pixelCount*/, int /*sourceStride*/) override
+    {
+        throw charls_error(charls::ApiResult::UnexpectedFailure, "A source layout can only be used when encoding");
+    }
+
+private:
+    using ProcessLineBuffered<SAMPLE>::_lineBuffer;
+    using ProcessLineBuffered<SAMPLE>::_lineProcess;
+
+    void CopyComponent(const SAMPLE* source, int32_t sourceStep, int32_t component) noexcept
+    {
+        SAMPLE* destination = _lineBuffer.data() + component;
+        for (int32_t x = 0; x < _width; ++x)
+        {
+            *destination = *source;
+            source += sourceStep;
+            destination += _componentsPerLine;
+        }
+    }
+
+    JlsSourceLayout _layout;
+    int32_t _width;
+    int32_t _componentsPerLine;
+    int32_t _firstComponent;
+    std::size_t _line;
+};
+
+#endif
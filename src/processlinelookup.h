@@ -0,0 +1,130 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_LOOKUP
+#define CHARLS_PROCESS_LINE_LOOKUP
+
+#include "processlinebuffered.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+
+//
+// ProcessLineLookup: maps every decoded sample with a lookup table while the line is stored in the output, to apply a window,
+// a shift or a user table (JlsSampleTransform) and to store samples of a smaller type. The table is computed once for all
+// possible sample values.
+//
+template<typename SAMPLE, typename OUTPUT>
+class ProcessLineLookup : public ProcessLineBuffered<SAMPLE>
+{
+public:
+    ProcessLineLookup(ByteStreamInfo rawData, std::size_t stride, const JlsSampleTransform& transform, int32_t bitsPerSample,
+        int32_t width, int32_t componentsPerLine) :
+        ProcessLineBuffered<SAMPLE>(static_cast<std::size_t>(width) * componentsPerLine),
+        _rawData(rawData),
+        _outputLine(rawData.rawStream ? _lineBuffer.size() : 0),
+        _bytesPerLine(stride != 0 ? stride : _lineBuffer.size() * sizeof(OUTPUT)),
+        _table(CreateTable(transform, bitsPerSample))
+    {
+    }
+
+    void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride) override
+    {
+        _lineProcess->NewLineDecoded(pSrc, pixelCount, sourceStride);
+
+        const auto byteCount = _lineBuffer.size() * sizeof(OUTPUT);
+        if (_rawData.rawStream)
+        {
+            MapLine(_outputLine.data());
+            if (_rawData.rawStream->sputn(reinterpret_cast<const char*>(_outputLine.data()), static_cast<std::streamsize>(byteCount)) != static_cast<std::streamsize>(byteCount))
+                throw charls_error(charls::ApiResult::UncompressedBufferTooSmall);
+            return;
+        }
+
+        if (_rawData.count < byteCount)
+            throw charls_error(charls::ApiResult::UncompressedBufferTooSmall);
+
+        MapLine(reinterpret_cast<OUTPUT*>(_rawData.rawData));
+        SkipBytes(_rawData, std::min(_bytesPerLine, _rawData.count));
+    }
+
+    void NewLineRequested(void* /*pDest*/, int /*pixelCount*/, int /*destStride*/) override
+    {
+        throw charls_error(charls::ApiResult::UnexpectedFailure, "A sample transform can only be applied when decoding");
+    }
+
+private:
+    using ProcessLineBuffered<SAMPLE>::_lineBuffer;
+    using ProcessLineBuffered<SAMPLE>::_lineProcess;
+
+    void MapLine(OUTPUT* destination) const noexcept
+    {
+        const OUTPUT* table = _table.data();
+        for (const SAMPLE sample : _lineBuffer)
+        {
+            *destination++ = table[sample];
+        }
+    }
+
+    static std::vector<OUTPUT> CreateTable(const JlsSampleTransform& transform, int32_t bitsPerSample)
+    {
+        const int32_t maximumOutput = (1 << transform.outputBitsPerSample) - 1;
+        std::vector<OUTPUT> table(static_cast<std::size_t>(1) << bitsPerSample);
+
+        switch (transform.type)
+        {
+        case charls::SampleTransform::Window:
+        {
+            // DICOM PS3.3, C.11.2.1.2.1 (VOI LUT function LINEAR).
+            const double lower = transform.windowCenter - 0.5 - (transform.windowWidth - 1) / 2;
+            const double upper = transform.windowCenter - 0.5 + (transform.windowWidth - 1) / 2;
+            for (std::size_t value = 0; value < table.size(); ++value)
+            {
+                if (value <= lower)
+                {
+                    table[value] = 0;
+                }
+                else if (value > upper)
+                {
+                    table[value] = static_cast<OUTPUT>(maximumOutput);
+                }
+                else
+                {
+                    const double output = ((value - (transform.windowCenter - 0.5)) / (transform.windowWidth - 1) + 0.5) * maximumOutput;
+                    table[value] = static_cast<OUTPUT>(std::min(std::max(std::lround(output), 0L), static_cast<long>(maximumOutput)));
+                }
+            }
+            break;
+        }
+
+        case charls::SampleTransform::Shift:
+            for (std::size_t value = 0; value < table.size(); ++value)
+            {
+                table[value] = static_cast<OUTPUT>(std::min(static_cast<int32_t>(value >> transform.shift), maximumOutput));
+            }
+            break;
+
+        case charls::SampleTransform::LookupTable:
+        {
+            const OUTPUT* entries = static_cast<const OUTPUT*>(transform.lookupTable);
+            for (std::size_t value = 0; value < table.size(); ++value)
+            {
+                table[value] = entries[std::min(value, transform.lookupTableEntryCount - 1)];
+            }
+            break;
+        }
+        }
+
+        return table;
+    }
+
+    ByteStreamInfo _rawData;
+    std::vector<OUTPUT> _outputLine;
+    std::size_t _bytesPerLine;
+    std::vector<OUTPUT> _table;
+};
+
+#endif
@@ -0,0 +1,138 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_MAPPED
+#define CHARLS_PROCESS_LINE_MAPPED
+
+#include "processline.h"
+#include <vector>
+
+
+//
+// MappingTable: a JPEG-LS mapping table (palette) as it is read from the LSE type 2 and 3 segments.
+// The entries are stored as in the byte stream (big endian for entries of 2 bytes).
+//
+struct MappingTable
+{
+    int tableId;
+    int entryWidth;
+    std::vector<uint8_t> entries;
+
+    int GetEntryCount() const noexcept
+    {
+        return static_cast<int>(entries.size() / entryWidth);
+    }
+
+    // Copies the entries in the format of the API: entries of 2 bytes as native uint16_t values.
+    void CopyEntries(void* destination) const noexcept
+    {
+        const auto bytes = static_cast<uint8_t*>(destination);
+        std::copy(entries.begin(), entries.end(), bytes);
+        if (entryWidth == 2)
+        {
+            for (std::size_t i = 0; i < entries.size(); i += 2)
+            {
+                const auto value = static_cast<uint16_t>(entries[i] << 8 | entries[i + 1]);
+                std::memcpy(bytes + i, &value, sizeof value);
+            }
+        }
+    }
+};
+
+
+//
+// ProcessLineMapped: replaces every decoded sample (an index) by its mapping table entry while the line is stored in the
+// output, the indices are never written. The codec must be created for a single component (interleave mode None).
+//
+template<typename SAMPLE>
+class ProcessLineMapped : public ProcessLine
+{
+public:
+    ProcessLineMapped(ByteStreamInfo rawData, const MappingTable& table, std::size_t bytesPerLine) :
+        _rawData(rawData),
+        _entryWidth(static_cast<std::size_t>(table.entryWidth)),
+        _entryCount(static_cast<std::size_t>(table.GetEntryCount())),
+        _entries(table.entries.size()),
+        _bytesPerLine(bytesPerLine),
+        _line(rawData.rawStream ? bytesPerLine : 0)
+    {
+        table.CopyEntries(_entries.data());
+    }
+
+    void NewLineDecoded(const void* pSrc, int pixelCount, int /*sourceStride*/) override
+    {
+        if (_rawData.rawStream)
+        {
+            MapLine(static_cast<const SAMPLE*>(pSrc), pixelCount, _line.data());
+            const auto count = static_cast<std::streamsize>(static_cast<std::size_t>(pixelCount) * _entryWidth);
+            if (_rawData.rawStream->sputn(reinterpret_cast<const char*>(_line.data()), count) != count)
+                throw charls_error(charls::ApiResult::UncompressedBufferTooSmall);
+            return;
+        }
+
+        if (_rawData.count < _bytesPerLine)
+            throw charls_error(charls::ApiResult::UncompressedBufferTooSmall);
+
+        MapLine(static_cast<const SAMPLE*>(pSrc), pixelCount, _rawData.rawData);
+        SkipBytes(_rawData, _bytesPerLine);
+    }
+
+    void NewLineRequested(void* /*pDest*/, int /*pixelCount*/, int /*destStride*/) override
+    {
+        throw charls_error(charls::ApiResult::UnexpectedFailure, "A mapping table can only be applied when decoding");
+    }
+
+private:
+    void MapLine(const SAMPLE* indices, int pixelCount, uint8_t* destination) const
+    {
+        switch (_entryWidth)
+        {
+        case 1:
+            MapLine<1>(indices, pixelCount, destination);
+            break;
+
+        case 2:
+            MapLine<2>(indices, pixelCount, destination);
+            break;
+
+        case 3:
+            MapLine<3>(indices, pixelCount, destination);
+            break;
+
+        default:
+            for (int i = 0; i < pixelCount; ++i)
+            {
+                std::memcpy(destination + i * _entryWidth, GetEntry(indices[i]), _entryWidth);
+            }
+            break;
+        }
+    }
+
+    // The common entry sizes are copied with a compile time size.
+    template<std::size_t ENTRY_WIDTH>
+    void MapLine(const SAMPLE* indices, int pixelCount, uint8_t* destination) const
+    {
+        for (int i = 0; i < pixelCount; ++i)
+        {
+            std::memcpy(destination + i * ENTRY_WIDTH, GetEntry(indices[i]), ENTRY_WIDTH);
+        }
+    }
+
+    const uint8_t* GetEntry(SAMPLE index) const
+    {
+        if (index >= _entryCount)
+            throw charls_error(charls::ApiResult::InvalidCompressedData, "A sample value is not an index in the mapping table");
+
+        return _entries.data() + index * _entryWidth;
+    }
+
+    ByteStreamInfo _rawData;
+    std::size_t _entryWidth;
+    std::size_t _entryCount;
+    std::vector<uint8_t> _entries;
+    std::size_t _bytesPerLine;
+    std::vector<uint8_t> _line;
+};
+
+#endif
@@ -0,0 +1,272 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#include "processlinepipelined.h"
+#include <cstring>
+
+using namespace charls;
+
+
+ProcessLinePipelined::ProcessLinePipelined(std::unique_ptr<ProcessLine> lineProcess, std::size_t bytesPerPixel, int32_t componentsPerLine,
+    int32_t width, int32_t requestedLineCount, const JlsExecutor& executor) :
+    _lineProcess(std::move(lineProcess)),
+    _bytesPerPixel(bytesPerPixel),
+    _componentsPerLine(componentsPerLine),
+    _width(width),
+    _requestedLineCount(requestedLineCount),
+    _slots(SlotCount),
+    _writeCount(0),
+    _readCount(0),
+    _state(ConsumerState::Pending),
+    _endOfLines(false),
+    _abort(false),
+    _failed(false),
+    _producerThread(std::this_thread::get_id()),
+    _waitCount(0),
+    _taskGroup(executor)
+{
+    // The codec passes lines with a stride of width + 4 pixels.
+    const std::size_t lineByteCount = GetLineByteCount(width, width + 4);
+    for (auto& slot : _slots)
+    {
+        slot.line.resize(lineByteCount);
+    }
+
+    _taskGroup.Submit(RunTask, this);
+}
+
+
+ProcessLinePipelined::~ProcessLinePipelined()
+{
+    // Stops the task when the codec failed, the task group waits for it.
+    _abort = true;
+    Signal();
+}
+
+
+void ProcessLinePipelined::NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride)
+{
+    if (_state == ConsumerState::Inline)
+    {
+        ProcessInline();
+        _lineProcess->NewLineDecoded(pSrc, pixelCount, sourceStride);
+        return;
+    }
+
+    const std::size_t writeCount = _writeCount.load(std::memory_order_relaxed);
+    while (writeCount - _readCount.load(std::memory_order_acquire) == SlotCount)
+    {
+        if (_failed)
+            std::rethrow_exception(_exception);
+
+        // The task didn't start yet: the lines are processed on this thread from now on.
+        auto expected = ConsumerState::Pending;
+        if (_state.compare_exchange_strong(expected, ConsumerState::Inline) || expected == ConsumerState::Inline)
+        {
+            NewLineDecoded(pSrc, pixelCount, sourceStride);
+            return;
+        }
+
+        // The task runs: it frees a slot or fails.
+        Wait([this, writeCount] { return writeCount - _readCount.load(std::memory_order_acquire) != SlotCount || _failed.load(std::memory_order_acquire); });
+    }
+
+    const std::size_t byteCount = GetLineByteCount(pixelCount, sourceStride);
+    Slot& slot = _slots[writeCount % SlotCount];
+    if (byteCount > slot.line.size())
+        throw charls_error(ApiResult::UnexpectedFailure, "The decoded line doesn't fit in the pipeline");
+
+    std::memcpy(slot.line.data(), pSrc, byteCount);
+    slot.pixelCount = pixelCount;
+    slot.stride = sourceStride;
+    _writeCount.store(writeCount + 1, std::memory_order_release);
+    Signal();
+}
+
+
+void ProcessLinePipelined::NewLineRequested(void* pDest, int pixelCount, int destStride)
+{
+    if (_state == ConsumerState::Inline)
+    {
+        _lineProcess->NewLineRequested(pDest, pixelCount, destStride);
+        return;
+    }
+
+    const std::size_t readCount = _readCount.load(std::memory_order_relaxed);
+    while (readCount == _writeCount.load(std::memory_order_acquire))
+    {
+        if (_failed)
+            std::rethrow_exception(_exception);
+
+        // The task didn't start yet: the lines are requested on this thread from now on.
+        auto expected = ConsumerState::Pending;
+        if (_state.compare_exchange_strong(expected, ConsumerState::Inline) || expected == ConsumerState::Inline)
+        {
+            NewLineRequested(pDest, pixelCount, destStride);
+            return;
+        }
+
+        // The task runs: it fills a slot or fails.
+        Wait([this, readCount] { return readCount != _writeCount.load(std::memory_order_acquire) || _failed.load(std::memory_order_acquire); });
+    }
+
+    const Slot& slot = _slots[readCount % SlotCount];
+    if (slot.pixelCount != pixelCount || slot.stride != destStride)
+        throw charls_error(ApiResult::UnexpectedFailure, "The requested line doesn't match the pipeline");
+
+    // Only the pixels of the components are copied, the edge pixels of the line buffer of the codec are left untouched.
+    const std::size_t byteCount = static_cast<std::size_t>(pixelCount) * _bytesPerPixel;
+    for (int32_t component = 0; component < _componentsPerLine; ++component)
+    {
+        const std::size_t offset = static_cast<std::size_t>(component) * destStride * _bytesPerPixel;
+        std::memcpy(static_cast<uint8_t*>(pDest) + offset, slot.line.data() + offset, byteCount);
+    }
+    _readCount.store(readCount + 1, std::memory_order_release);
+    Signal();
+}
+
+
+void ProcessLinePipelined::Finish()
+{
+    _endOfLines.store(true, std::memory_order_release);
+    Signal();
+
+    auto expected = ConsumerState::Pending;
+    if (_requestedLineCount == 0 && _state.compare_exchange_strong(expected, ConsumerState::Inline))
+    {
+        ProcessInline();
+    }
+    _taskGroup.Wait();
+
+    if (_failed)
+        std::rethrow_exception(_exception);
+}
+
+
+void ProcessLinePipelined::RunTask(void* context)
+{
+    auto* pipeline = static_cast<ProcessLinePipelined*>(context);
+
+    // A task that runs on the codec thread (serial executor or a wait that executes queued tasks) would wait for itself.
+    auto expected = ConsumerState::Pending;
+    const ConsumerState state = std::this_thread::get_id() == pipeline->_producerThread ? ConsumerState::Inline : ConsumerState::Running;
+    if (!pipeline->_state.compare_exchange_strong(expected, state) || state == ConsumerState::Inline)
+        return;
+
+    try
+    {
+        if (pipeline->_requestedLineCount == 0)
+        {
+            pipeline->Consume();
+        }
+        else
+        {
+            pipeline->Produce();
+        }
+    }
+    catch (...)
+    {
+        pipeline->_exception = std::current_exception();
+        pipeline->_failed.store(true, std::memory_order_release);
+        pipeline->Signal();
+    }
+}
+
+
+void ProcessLinePipelined::Consume()
+{
+    while (!_abort)
+    {
+        const std::size_t readCount = _readCount.load(std::memory_order_relaxed);
+        while (readCount == _writeCount.load(std::memory_order_acquire))
+        {
+            if (_abort || (_endOfLines.load(std::memory_order_acquire) && readCount == _writeCount.load(std::memory_order_acquire)))
+                return;
+
+            Wait([this, readCount] { return readCount != _writeCount.load(std::memory_order_acquire) || _abort || _endOfLines.load(std::memory_order_acquire); });
+        }
+
+        const Slot& slot = _slots[readCount % SlotCount];
+        _lineProcess->NewLineDecoded(slot.line.data(), slot.pixelCount, slot.stride);
+        _readCount.store(readCount + 1, std::memory_order_release);
+        Signal();
+    }
+}
+
+
+void ProcessLinePipelined::Produce()
+{
+    const int32_t stride = _width + 4;
+    for (int32_t line = 0; line < _requestedLineCount && !_abort; ++line)
+    {
+        const std::size_t writeCount = _writeCount.load(std::memory_order_relaxed);
+        while (writeCount - _readCount.load(std::memory_order_acquire) == SlotCount)
+        {
+            if (_abort)
+                return;
+
+            Wait([this, writeCount] { return writeCount - _readCount.load(std::memory_order_acquire) != SlotCount || _abort; });
+        }
+
+        Slot& slot = _slots[writeCount % SlotCount];
+        _lineProcess->NewLineRequested(slot.line.data(), _width, stride);
+        slot.pixelCount = _width;
+        slot.stride = stride;
+        _writeCount.store(writeCount + 1, std::memory_order_release);
+        Signal();
+    }
+}
+
+
+// Processes the lines in the ring on the decoding thread, only called when the task will not take lines from the ring.
+void ProcessLinePipelined::ProcessInline()
+{
+    const std::size_t writeCount = _writeCount.load(std::memory_order_relaxed);
+    for (std::size_t readCount = _readCount.load(std::memory_order_relaxed); readCount != writeCount; ++readCount)
+    {
+        const Slot& slot = _slots[readCount % SlotCount];
+        _lineProcess->NewLineDecoded(slot.line.data(), slot.pixelCount, slot.stride);
+        _readCount.store(readCount + 1, std::memory_order_relaxed);
+    }
+}
+
+
+// Returns when ready() is true. The other side usually passes a slot on within a few yields, after that the thread blocks.
+template<typename Predicate>
+void ProcessLinePipelined::Wait(Predicate ready)
+{
+    for (int spin = 0; spin < SpinCount; ++spin)
+    {
+        if (ready())
+            return;
+
+        std::this_thread::yield();
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _waitCount.fetch_add(1, std::memory_order_relaxed);
+
+    // Pairs with the fence in Signal: either ready() sees the new state or Signal sees the waiting thread.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    _condition.wait(lock, ready);
+    _waitCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+// Wakes a blocked side after a state change, the lock is only taken when a side is blocked.
+void ProcessLinePipelined::Signal()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (_waitCount.load(std::memory_order_relaxed) == 0)
+        return;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _condition.notify_all();
+}
+
+
+std::size_t ProcessLinePipelined::GetLineByteCount(int pixelCount, int stride) const
+{
+    return (static_cast<std::size_t>(_componentsPerLine - 1) * stride + pixelCount) * _bytesPerPixel;
+}
@@ -0,0 +1,99 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_PIPELINED
+#define CHARLS_PROCESS_LINE_PIPELINED
+
+#include "jlsexecutor.h"
+#include "processline.h"
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+//
+// ProcessLinePipelined: runs the ProcessLine of the codec (color transformation, interleaving, BGR order, stream input and
+// output) on a second thread while the codec decodes or encodes the other lines, lines are passed in a lock-free single
+// producer, single consumer ring of line buffers. A side that has to wait for the other spins briefly and then blocks until
+// a slot is passed on (or the pipeline ends): a stalled side doesn't keep a core busy.
+// Decoding: the decoded lines are copied to the ring, a task on the executor takes them from the ring and passes them to the
+// ProcessLine. Encoding: a task on the executor requests the next lines from the ProcessLine into the ring, the encoder copies
+// them from the ring: the codec thread only models and codes.
+// When the task doesn't start before the codec has to wait for it (or runs on the codec thread, as with a serial executor)
+// the lines are processed on the codec thread: waiting for the task can never deadlock. Finish must be called after the last line.
+//
+class ProcessLinePipelined : public ProcessLine
+{
+public:
+    // bytesPerPixel and componentsPerLine describe the line buffer of the codec: interleave mode Line stores the components
+    // of a line after each other, the ring slots hold all of them. requestedLineCount is the number of lines the encoder
+    // requests, 0 when decoding.
+    ProcessLinePipelined(std::unique_ptr<ProcessLine> lineProcess, std::size_t bytesPerPixel, int32_t componentsPerLine,
+        int32_t width, int32_t requestedLineCount, const JlsExecutor& executor);
+    ~ProcessLinePipelined() override;
+
+    ProcessLinePipelined(const ProcessLinePipelined&) = delete;
+    ProcessLinePipelined(ProcessLinePipelined&&) = delete;
+    ProcessLinePipelined& operator=(const ProcessLinePipelined&) = delete;
+    ProcessLinePipelined& operator=(ProcessLinePipelined&&) = delete;
+
+    void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride) override;
+    void NewLineRequested(void* pDest, int pixelCount, int destStride) override;
+
+    // Waits until all lines are processed, rethrows the exception of the ProcessLine when it failed on the second thread.
+    void Finish();
+
+private:
+    enum class ConsumerState
+    {
+        Pending,
+        Running,
+        Inline
+    };
+
+    struct Slot
+    {
+        std::vector<uint8_t> line;
+        int pixelCount;
+        int stride;
+    };
+
+    static void RunTask(void* context);
+    void Consume();
+    void Produce();
+    void ProcessInline();
+    std::size_t GetLineByteCount(int pixelCount, int stride) const;
+
+    template<typename Predicate>
+    void Wait(Predicate ready);
+    void Signal();
+
+    static constexpr std::size_t SlotCount = 16;
+    static constexpr int SpinCount = 64;
+
+    std::unique_ptr<ProcessLine> _lineProcess;
+    std::size_t _bytesPerPixel;
+    int32_t _componentsPerLine;
+    int32_t _width;
+    int32_t _requestedLineCount;
+    std::vector<Slot> _slots;
+    std::atomic<std::size_t> _writeCount;
+    std::atomic<std::size_t> _readCount;
+    std::atomic<ConsumerState> _state;
+    std::atomic<bool> _endOfLines;
+    std::atomic<bool> _abort;
+    std::atomic<bool> _failed;
+    std::exception_ptr _exception;
+    std::thread::id _producerThread;
+    std::atomic<int> _waitCount;
+    std::mutex _mutex;
+    std::condition_variable _condition;
+    TaskGroup _taskGroup;
+};
+
+#endif
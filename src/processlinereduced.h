@@ -0,0 +1,137 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_REDUCED
+#define CHARLS_PROCESS_LINE_REDUCED
+
+#include "processlinebuffered.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+
+//
+// ProcessLineReduced: box filters every decoded line into one or more reduced resolution images while the line is still
+// in the cache, and optionally stores the line in the full resolution output. Each reduced image keeps 1 line of sums.
+//
+template<typename SAMPLE>
+class ProcessLineReduced : public ProcessLineBuffered<SAMPLE>
+{
+public:
+    ProcessLineReduced(ByteStreamInfo rawData, std::size_t stride, const std::vector<JlsReducedImage>& images,
+        int32_t width, int32_t height, int32_t componentsPerLine, int32_t plane) :
+        ProcessLineBuffered<SAMPLE>(static_cast<std::size_t>(width) * componentsPerLine),
+        _rawData(rawData),
+        _bytesPerLine(stride != 0 ? stride : _lineBuffer.size() * sizeof(SAMPLE)),
+        _width(width),
+        _height(height),
+        _componentsPerLine(componentsPerLine),
+        _line(0)
+    {
+        for (const auto& image : images)
+        {
+            ReducedImage reduced;
+            reduced.scale = image.scale;
+            reduced.width = (width + image.scale - 1) / image.scale;
+            reduced.sums.resize(static_cast<std::size_t>(reduced.width) * componentsPerLine);
+
+            const std::size_t planeSampleCount = reduced.sums.size() * ((height + image.scale - 1) / image.scale);
+            reduced.destination = static_cast<SAMPLE*>(image.destination) + planeSampleCount * plane;
+            _reducedImages.push_back(std::move(reduced));
+        }
+    }
+
+    void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride) override
+    {
+        _lineProcess->NewLineDecoded(pSrc, pixelCount, sourceStride);
+        StoreLine();
+
+        for (auto& reduced : _reducedImages)
+        {
+            AddLine(reduced);
+        }
+        ++_line;
+    }
+
+    void NewLineRequested(void* /*pDest*/, int /*pixelCount*/, int /*destStride*/) override
+    {
+        throw charls_error(charls::ApiResult::UnexpectedFailure, "Reduced images can only be created when decoding");
+    }
+
+private:
+    using ProcessLineBuffered<SAMPLE>::_lineBuffer;
+    using ProcessLineBuffered<SAMPLE>::_lineProcess;
+
+    struct ReducedImage
+    {
+        int32_t scale;
+        int32_t width;
+        std::vector<uint32_t> sums;
+        SAMPLE* destination;
+    };
+
+    void StoreLine()
+    {
+        const auto byteCount = _lineBuffer.size() * sizeof(SAMPLE);
+        if (_rawData.rawStream)
+        {
+            if (_rawData.rawStream->sputn(reinterpret_cast<const char*>(_lineBuffer.data()), static_cast<std::streamsize>(byteCount)) != static_cast<std::streamsize>(byteCount))
+                throw charls_error(charls::ApiResult::UncompressedBufferTooSmall);
+            return;
+        }
+
+        if (!_rawData.rawData)
+            return;
+
+        if (_rawData.count < byteCount)
+            throw charls_error(charls::ApiResult::UncompressedBufferTooSmall);
+
+        std::memcpy(_rawData.rawData, _lineBuffer.data(), byteCount);
+        SkipBytes(_rawData, std::min(_bytesPerLine, _rawData.count));
+    }
+
+    void AddLine(ReducedImage& reduced) noexcept
+    {
+        const SAMPLE* sample = _lineBuffer.data();
+        uint32_t* sum = reduced.sums.data();
+        for (int32_t x = 0; x < _width; x += reduced.scale)
+        {
+            const int32_t blockWidth = std::min(reduced.scale, _width - x);
+            for (int32_t i = 0; i < blockWidth; ++i)
+            {
+                for (int32_t component = 0; component < _componentsPerLine; ++component)
+                {
+                    sum[component] += *sample++;
+                }
+            }
+            sum += _componentsPerLine;
+        }
+
+        const int32_t blockHeight = _line % reduced.scale + 1;
+        if (blockHeight != reduced.scale && _line != _height - 1)
+            return;
+
+        SAMPLE* destination = reduced.destination + static_cast<std::size_t>(_line / reduced.scale) * reduced.sums.size();
+        for (int32_t x = 0; x < reduced.width; ++x)
+        {
+            const auto count = static_cast<uint32_t>(std::min(reduced.scale, _width - x * reduced.scale) * blockHeight);
+            for (int32_t component = 0; component < _componentsPerLine; ++component)
+            {
+                uint32_t& blockSum = reduced.sums[static_cast<std::size_t>(x) * _componentsPerLine + component];
+                *destination++ = static_cast<SAMPLE>((blockSum + count / 2) / count);
+                blockSum = 0;
+            }
+        }
+    }
+
+    ByteStreamInfo _rawData;
+    std::size_t _bytesPerLine;
+    int32_t _width;
+    int32_t _height;
+    int32_t _componentsPerLine;
+    int32_t _line;
+    std::vector<ReducedImage> _reducedImages;
+};
+
+#endif
@@ -0,0 +1,162 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef CHARLS_PROCESS_LINE_UNPACK
+#define CHARLS_PROCESS_LINE_UNPACK
+
+#include "processlinebuffered.h"
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+
+// Returns the size in bytes of a line of sampleCount samples in the given source format (without padding).
+inline std::size_t GetSourceLineByteCount(charls::SourceFormat format, std::size_t sampleCount, int32_t bitsPerSample) noexcept
+{
+    switch (format)
+    {
+    case charls::SourceFormat::Native:
+        return sampleCount * ((bitsPerSample + 7) / 8);
+
+    case charls::SourceFormat::PackedLsb:
+        return (sampleCount * bitsPerSample + 7) / 8;
+
+    default:
+        return sampleCount * 2;
+    }
+}
+
+
+//
+// ProcessLineUnpack: converts every line to encode from a packed, big endian or MSB aligned source format to native samples
+// while the line is requested by the encoder, no separate conversion pass over the image is needed.
+//
+template<typename SAMPLE>
+class ProcessLineUnpack : public ProcessLineBuffered<SAMPLE>
+{
+public:
+    ProcessLineUnpack(ByteStreamInfo rawData, std::size_t stride, charls::SourceFormat format, int32_t bitsPerSample, std::size_t sampleCount) :
+        ProcessLineBuffered<SAMPLE>(sampleCount),
+        _rawData(rawData),
+        _format(format),
+        _bitsPerSample(bitsPerSample),
+        _lineByteCount(GetSourceLineByteCount(format, sampleCount, bitsPerSample)),
+        _stride(stride != 0 ? stride : _lineByteCount)
+    {
+    }
+
+    void NewLineRequested(void* pDest, int pixelCount, int destStride) override
+    {
+        if (_rawData.count < _lineByteCount)
+            throw charls_error(charls::ApiResult::UncompressedBufferTooSmall);
+
+        Unpack(_rawData.rawData);
+        SkipBytes(_rawData, std::min(_stride, _rawData.count));
+
+        _lineProcess->NewLineRequested(pDest, pixelCount, destStride);
+    }
+
+    void NewLineDecoded(const void* /*pSrc*/, int /*pixelCount*/, int /*sourceStride*/) override
+    {
+        throw charls_error(charls::ApiResult::UnexpectedFailure, "A source format can only be used when encoding");
+    }
+
+private:
+    using ProcessLineBuffered<SAMPLE>::_lineBuffer;
+    using ProcessLineBuffered<SAMPLE>::_lineProcess;
+
+    void Unpack(const uint8_t* source) noexcept
+    {
+        SAMPLE* destination = _lineBuffer.data();
+        const std::size_t count = _lineBuffer.size();
+
+        switch (_format)
+        {
+        case charls::SourceFormat::BigEndian16:
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                destination[i] = static_cast<SAMPLE>(source[2 * i] << 8 | source[2 * i + 1]);
+            }
+            break;
+
+        case charls::SourceFormat::MsbAligned16:
+        {
+            const int shift = 16 - _bitsPerSample;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                uint16_t value;
+                std::memcpy(&value, source + 2 * i, sizeof value);
+                destination[i] = static_cast<SAMPLE>(value >> shift);
+            }
+            break;
+        }
+
+        case charls::SourceFormat::MsbAlignedBigEndian16:
+        {
+            const int shift = 16 - _bitsPerSample;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                destination[i] = static_cast<SAMPLE>((source[2 * i] << 8 | source[2 * i + 1]) >> shift);
+            }
+            break;
+        }
+
+        case charls::SourceFormat::PackedLsb:
+            UnpackBits(source, destination, count);
+            break;
+
+        case charls::SourceFormat::Native:
+            std::memcpy(destination, source, count * sizeof(SAMPLE));
+            break;
+        }
+    }
+
+    void UnpackBits(const uint8_t* source, SAMPLE* destination, std::size_t count) const noexcept
+    {
+        std::size_t i = 0;
+
+        // Mono12p: 2 samples in 3 bytes, Mono10p: 4 samples in 5 bytes.
+        if (_bitsPerSample == 12)
+        {
+            for (; i + 2 <= count; i += 2, source += 3)
+            {
+                destination[i] = static_cast<SAMPLE>(source[0] | (source[1] & 0x0F) << 8);
+                destination[i + 1] = static_cast<SAMPLE>(source[1] >> 4 | source[2] << 4);
+            }
+        }
+        else if (_bitsPerSample == 10)
+        {
+            for (; i + 4 <= count; i += 4, source += 5)
+            {
+                destination[i] = static_cast<SAMPLE>(source[0] | (source[1] & 0x03) << 8);
+                destination[i + 1] = static_cast<SAMPLE>(source[1] >> 2 | (source[2] & 0x0F) << 6);
+                destination[i + 2] = static_cast<SAMPLE>(source[2] >> 4 | (source[3] & 0x3F) << 4);
+                destination[i + 3] = static_cast<SAMPLE>(source[3] >> 6 | source[4] << 2);
+            }
+        }
+
+        const uint32_t mask = (1U << _bitsPerSample) - 1;
+        uint32_t bits = 0;
+        int32_t bitCount = 0;
+        for (; i < count; ++i)
+        {
+            while (bitCount < _bitsPerSample)
+            {
+                bits |= static_cast<uint32_t>(*source++) << bitCount;
+                bitCount += 8;
+            }
+            destination[i] = static_cast<SAMPLE>(bits & mask);
+            bits >>= _bitsPerSample;
+            bitCount -= _bitsPerSample;
+        }
+    }
+
+    ByteStreamInfo _rawData;
+    charls::SourceFormat _format;
+    int32_t _bitsPerSample;
+    std::size_t _lineByteCount;
+    std::size_t _stride;
+};
+
+#endif
@@ -92,17 +92,110 @@ namespace charls
         /// </summary>
         HP3 = 3,
     };
+
+    /// <summary>
+    /// Defines how the decoded samples are mapped to the output samples by JpegLsDecodeTransformed.
+    /// </summary>
+    enum class SampleTransform
+    {
+        /// <summary>
+        /// Linear window (window center and width) as the DICOM VOI LUT function LINEAR: values below the window are 0, above the window the maximum output value.
+        /// </summary>
+        Window = 0,
+
+        /// <summary>
+        /// The sample is shifted to the right, values above the maximum output value are clamped.
+        /// </summary>
+        Shift = 1,
+
+        /// <summary>
+        /// The sample is the index in a user lookup table.
+        /// </summary>
+        LookupTable = 2
+    };
+
+    /// <summary>
+    /// Defines the format of the samples that are passed to JpegLsEncodeFormat.
+    /// </summary>
+    enum class SourceFormat
+    {
+        /// <summary>
+        /// Samples of 1 byte (up to 8 bits) or 2 bytes in native byte order, the value in the least significant bits.
+        /// </summary>
+        Native = 0,
+
+        /// <summary>
+        /// Samples of 2 bytes in big endian byte order, the value in the least significant bits.
+        /// </summary>
+        BigEndian16 = 1,
+
+        /// <summary>
+        /// Samples of 2 bytes in native byte order, the value in the most significant bits (for example 12 bits in 16).
+        /// </summary>
+        MsbAligned16 = 2,
+
+        /// <summary>
+        /// Samples of 2 bytes in big endian byte order, the value in the most significant bits.
+        /// </summary>
+        MsbAlignedBigEndian16 = 3,
+
+        /// <summary>
+        /// Samples of bitsPerSample bits without padding, the first sample in the least significant bits of the first byte
+        /// (as Mono10p and Mono12p of the GenICam pixel format naming convention). Every line starts at a byte boundary.
+        /// </summary>
+        PackedLsb = 4
+    };
+
+    /// <summary>
+    /// Defines how the decoded image is oriented in the destination of JpegLsDecodeLayout.
+    /// </summary>
+    enum class Orientation
+    {
+        /// <summary>
+        /// The first line is stored first, every line from left to right.
+        /// </summary>
+        Normal = 0,
+
+        /// <summary>
+        /// The image is flipped vertically: the last line is stored first (as a bottom-up DIB).
+        /// </summary>
+        FlipVertical = 1,
+
+        /// <summary>
+        /// The image is mirrored horizontally: every line is stored from right to left.
+        /// </summary>
+        MirrorHorizontal = 2,
+
+        /// <summary>
+        /// The image is rotated by 180 degrees (flipped vertically and mirrored horizontally).
+        /// </summary>
+        Rotate180 = 3,
+
+        /// <summary>
+        /// The image is rotated by 90 degrees clockwise: the destination is height pixels wide and width lines high.
+        /// </summary>
+        Rotate90 = 4,
+
+        /// <summary>
+        /// The image is rotated by 270 degrees clockwise: the destination is height pixels wide and width lines high.
+        /// </summary>
+        Rotate270 = 5
+    };
 }
 
 using CharlsApiResultType = charls::ApiResult;
 using CharlsInterleaveModeType = charls::InterleaveMode;
 using CharlsColorTransformationType = charls::ColorTransformation;
+using CharlsSampleTransformType = charls::SampleTransform;
+using CharlsSourceFormatType = charls::SourceFormat;
+using CharlsOrientationType = charls::Orientation;
 
 // Defines the size of the char buffer that should be passed to the CharLS API to get the error message text.
 const std::size_t ErrorMessageSize = 256;
 
 #else
 
+#include <stddef.h>
 #include <stdint.h>
 
 enum CharlsApiResult
@@ -139,9 +232,38 @@ enum CharlsColorTransformation
     CHARLS_COLOR_TRANSFORMATION_HP3 = 3,
 };
 
+enum CharlsSampleTransform
+{
+    CHARLS_SAMPLE_TRANSFORM_WINDOW = 0,
+    CHARLS_SAMPLE_TRANSFORM_SHIFT = 1,
+    CHARLS_SAMPLE_TRANSFORM_LOOKUP_TABLE = 2
+};
+
+enum CharlsSourceFormat
+{
+    CHARLS_SOURCE_FORMAT_NATIVE = 0,
+    CHARLS_SOURCE_FORMAT_BIG_ENDIAN_16 = 1,
+    CHARLS_SOURCE_FORMAT_MSB_ALIGNED_16 = 2,
+    CHARLS_SOURCE_FORMAT_MSB_ALIGNED_BIG_ENDIAN_16 = 3,
+    CHARLS_SOURCE_FORMAT_PACKED_LSB = 4
+};
+
+enum CharlsOrientation
+{
+    CHARLS_ORIENTATION_NORMAL = 0,
+    CHARLS_ORIENTATION_FLIP_VERTICAL = 1,
+    CHARLS_ORIENTATION_MIRROR_HORIZONTAL = 2,
+    CHARLS_ORIENTATION_ROTATE_180 = 3,
+    CHARLS_ORIENTATION_ROTATE_90 = 4,
+    CHARLS_ORIENTATION_ROTATE_270 = 5
+};
+
 typedef enum CharlsApiResult CharlsApiResultType;
 typedef enum CharlsInterleaveMode CharlsInterleaveModeType;
 typedef enum CharlsColorTransformation CharlsColorTransformationType;
+typedef enum CharlsSampleTransform CharlsSampleTransformType;
+typedef enum CharlsSourceFormat CharlsSourceFormatType;
+typedef enum CharlsOrientation CharlsOrientationType;
 
 // Defines the size of the char buffer that should be passed to the CharLS API to get the error message text.
 #define CHARLS_ERROR_MESSAGE_SIZE 256
@@ -193,6 +315,166 @@ struct JlsRect
 };
 
 
+/// <summary>
+/// Describes 1 part of a JPEG-LS encoded byte stream that is stored in multiple buffers (for example DICOM fragments).
+/// The parts are decoded as if they were concatenated, a marker segment or the encoded data can cross part boundaries.
+/// </summary>
+struct JlsFragment
+{
+    const void* data;
+    size_t length;
+};
+
+
+/// <summary>
+/// Describes 1 marker segment of a JPEG-LS byte stream, as returned by JpegLsGetSegmentIndex.
+/// </summary>
+struct JlsSegmentInfo
+{
+    /// <summary>The second byte of the marker, for example 0xD8 (SOI), 0xF7 (SOF55), 0xF8 (LSE), 0xDA (SOS), 0xE0-0xEF (APPn) or 0xD9 (EOI).</summary>
+    int markerCode;
+
+    /// <summary>Offset of the marker (its 0xFF byte) from the start of the byte stream.</summary>
+    size_t offset;
+
+    /// <summary>Size of the marker and the marker segment in bytes (2 for SOI and EOI).</summary>
+    size_t length;
+
+    /// <summary>SOS only: size of the entropy coded data that follows the marker segment.</summary>
+    size_t scanDataLength;
+
+    /// <summary>SOF55 and SOS only: the number of components in the frame or scan.</summary>
+    int componentCount;
+
+    /// <summary>SOS only: the allowed lossy error (NEAR) of the scan.</summary>
+    int allowedLossyError;
+
+    /// <summary>SOS only: the interleave mode (ILV) of the scan.</summary>
+    CharlsInterleaveModeType interleaveMode;
+};
+
+
+/// <summary>
+/// Describes a JPEG-LS mapping table (palette): the decoded sample values are indices in the table.
+/// Entries of 2 bytes are uint16_t values (native byte order), entries of other sizes are stored byte by byte (for example RGB).
+/// </summary>
+struct JlsMappingTable
+{
+    /// <summary>The table identifier (TID), 1 - 255.</summary>
+    int tableId;
+
+    /// <summary>The size of 1 table entry in bytes (Wt), 1 - 255.</summary>
+    int entryWidth;
+
+    /// <summary>The number of entries in the table.</summary>
+    int entryCount;
+
+    /// <summary>The entries of the table (entryCount * entryWidth bytes).</summary>
+    const void* entries;
+};
+
+
+/// <summary>
+/// Describes a reduced resolution image (thumbnail or pyramid level) that is computed while an image is decoded.
+/// Every sample is the rounded average of a block of scale x scale samples, the blocks at the right and bottom border can be smaller.
+/// The image has ceil(width / scale) x ceil(height / scale) pixels and the same layout as the decoded image, without padding.
+/// </summary>
+struct JlsReducedImage
+{
+    /// <summary>The reduction factor, 1 - 256: 2 gives a 1/2 image, 4 a 1/4 image, etc.</summary>
+    int scale;
+
+    /// <summary>Byte array that holds the reduced image when decoding is complete.</summary>
+    void* destination;
+
+    /// <summary>Length of the array in bytes.</summary>
+    size_t destinationLength;
+};
+
+
+/// <summary>
+/// Describes how the decoded samples are mapped to output samples with a smaller bit depth, for example to display 12 or 16 bit images.
+/// Output samples of up to 8 bits are stored in 1 byte, larger output samples in 2 bytes (uint16_t).
+/// </summary>
+struct JlsSampleTransform
+{
+    /// <summary>The mapping that is applied to every sample.</summary>
+    CharlsSampleTransformType type;
+
+    /// <summary>The bit depth of the output samples, 1 - 16.</summary>
+    int outputBitsPerSample;
+
+    /// <summary>Window only: the window center.</summary>
+    double windowCenter;
+
+    /// <summary>Window only: the window width, at least 1.</summary>
+    double windowWidth;
+
+    /// <summary>Shift only: the number of bits to shift to the right, 0 - 15.</summary>
+    int shift;
+
+    /// <summary>LookupTable only: the output values for the sample values 0, 1, 2, etc. (uint8_t or uint16_t values, as the output samples).
+    /// Samples after the last entry are mapped to the last entry.</summary>
+    const void* lookupTable;
+
+    /// <summary>LookupTable only: the number of entries of the table, at least 1.</summary>
+    size_t lookupTableEntryCount;
+};
+
+
+/// <summary>
+/// Describes the layout of the decoded pixels in the destination, independent of the interleave mode of the encoded data.
+/// For example RGB pixels encoded with interleave mode None can be stored as interleaved BGRX pixels: interleaved 1, channelCount 4,
+/// componentChannels {2, 1, 0} and paddingValue 255. Supports images with up to 4 components.
+/// </summary>
+struct JlsPixelLayout
+{
+    /// <summary>0: every component is stored in its own plane, 1: the components of a pixel are stored next to each other.</summary>
+    int interleaved;
+
+    /// <summary>Interleaved only: the number of samples of a pixel, the components and the padding channels (for example 4 for RGBA).</summary>
+    int channelCount;
+
+    /// <summary>The channel (interleaved) or the plane (planar) of every component.</summary>
+    int componentChannels[4];
+
+    /// <summary>Interleaved only: the value of the channels that don't hold a component.</summary>
+    int paddingValue;
+
+    /// <summary>The number of bytes from the start of a line to the start of the next line (0 = no padding). The planes are stride * height bytes.</summary>
+    size_t stride;
+
+    /// <summary>The orientation of the image in the destination, lines are stored at their final position while they are decoded.
+    /// With a rotation by 90 or 270 degrees a destination line (and the stride) holds a column of the image.</summary>
+    CharlsOrientationType orientation;
+};
+
+
+/// <summary>
+/// Describes the layout of the pixels that should be encoded, independent of the interleave mode of the encoded data.
+/// The components are read from separate planes (each with its own pointer and stride) or from interleaved pixels with
+/// padding channels, for example from BGRX pixels: interleaved 1, channelCount 4 and componentChannels {2, 1, 0}.
+/// Supports images with up to 4 components.
+/// </summary>
+struct JlsSourceLayout
+{
+    /// <summary>0: every component is read from its own plane, 1: the components of a pixel are next to each other in planes[0].</summary>
+    int interleaved;
+
+    /// <summary>Interleaved only: the number of samples of a pixel, the components and the padding channels.</summary>
+    int channelCount;
+
+    /// <summary>Interleaved only: the channel of every component.</summary>
+    int componentChannels[4];
+
+    /// <summary>The plane of every component (planar) or the interleaved pixels (planes[0]).</summary>
+    const void* planes[4];
+
+    /// <summary>The number of bytes from the start of a line to the start of the next line of every plane (0 = no padding).</summary>
+    size_t strides[4];
+};
+
+
 /// <summary>
 /// Defines the parameters for the JPEG File Interchange Format.
 /// The format is defined in the JPEG File Interchange Format v1.02 document by Eric Hamilton.
@@ -317,6 +599,7 @@ struct ByteStreamInfo
     std::basic_streambuf<char>* rawStream;
     uint8_t* rawData;
     std::size_t count;
+    std::size_t blockSize = 0; // Bytes read from or written to rawStream at a time: 0 selects the default (64 KiB), the minimum is 1 KiB.
 };
 
 
@@ -118,6 +118,7 @@ public:
         _RUNindex(0),
         _previousLine(),
         _currentLine(),
+        _line(0),
         _pquant(nullptr)
     {
         if (Info().interleaveMode == InterleaveMode::None)
@@ -195,7 +196,38 @@ public:
 
     void DoLine(SAMPLE* pdummy);
     void DoLine(Triplet<SAMPLE>* pdummy);
-    void DoScan();
+    void InitScanLines();
+    void DoScanLines(int32_t lineCount);
+    template<typename LINE_PROCESSOR> void DoScanLines(int32_t lineCount, LINE_PROCESSOR& lineProcessor);
+    template<typename LINE_PROCESSOR> void DoScan(LINE_PROCESSOR& lineProcessor);
+    template<typename LINE_PROCESSOR> void DoScanUntilEndOfScan(LINE_PROCESSOR& lineProcessor);
+    template<typename LINE_PROCESSOR> void DecodeScanLines(LINE_PROCESSOR& lineProcessor, const JlsRect& rect, ByteStreamInfo& compressedData);
+
+    template<typename LINE_PROCESSOR>
+    static void OnLineBegin(LINE_PROCESSOR& lineProcessor, void* line, int32_t pixelCount, int32_t pixelStride, EncoderStrategy*)
+    {
+        lineProcessor.NewLineRequested(line, pixelCount, pixelStride);
+    }
+
+    template<typename LINE_PROCESSOR>
+    static void OnLineBegin(LINE_PROCESSOR&, void*, int32_t, int32_t, DecoderStrategy*) noexcept
+    {
+    }
+
+    template<typename LINE_PROCESSOR>
+    static void OnLineEnd(LINE_PROCESSOR& lineProcessor, const void* line, int32_t pixelCount, int32_t pixelStride, DecoderStrategy*)
+    {
+        lineProcessor.NewLineDecoded(line, pixelCount, pixelStride);
+    }
+
+    template<typename LINE_PROCESSOR>
+    static void OnLineEnd(LINE_PROCESSOR&, const void*, int32_t, int32_t, EncoderStrategy*) noexcept
+    {
+    }
+
+    template<typename FUNCTOR> auto WithColorTransform(FUNCTOR functor);
+    template<typename FUNCTOR> void WithRawProcess(uint8_t* rawData, FUNCTOR functor, SAMPLE* pdummy);
+    template<typename FUNCTOR> void WithRawProcess(uint8_t* rawData, FUNCTOR functor, Triplet<SAMPLE>* pdummy);
 
     void InitParams(int32_t t1, int32_t t2, int32_t t3, int32_t nReset);
 
@@ -206,7 +238,14 @@ public:
 
     // Note: depending on the base class EncodeScan OR DecodeScan will be virtual and abstract, cannot use override in all cases.
     size_t EncodeScan(std::unique_ptr<ProcessLine> processLine, ByteStreamInfo& compressedData);
+    size_t EncodeScan(ByteStreamInfo rawPixels, ByteStreamInfo& compressedData);
+    void StartEncodeScan(ByteStreamInfo& compressedData);
+    void EncodeLines(std::unique_ptr<ProcessLine> processLine, int32_t lineCount);
     void DecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData);
+    void DecodeScan(ByteStreamInfo rawPixels, const JlsRect& rect, ByteStreamInfo& compressedData);
+    void StartDecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData);
+    void DecodeLines(int32_t lineCount);
+    bool TryDecodeLine();
 
 #if defined(__clang__)
 #pragma clang diagnostic pop
@@ -228,6 +267,11 @@ protected:
     PIXEL* _previousLine;
     PIXEL* _currentLine;
 
+    // line buffers and run indices of the scan, kept between calls to DoScanLines.
+    std::vector<PIXEL> _lineBuffer;
+    std::vector<int32_t> _runIndices;
+    int32_t _line;
+
     // quantization lookup table
     signed char* _pquant;
     std::vector<signed char> _rgquant;
@@ -711,46 +755,93 @@ void JlsCodec<Traits, Strategy>::DoLine(Triplet<SAMPLE>*)
 // In ILV_NONE mode, DoScan is called for each component
 
 template<typename Traits, typename Strategy>
-void JlsCodec<Traits, Strategy>::DoScan()
+template<typename LINE_PROCESSOR>
+void JlsCodec<Traits, Strategy>::DoScan(LINE_PROCESSOR& lineProcessor)
+{
+    InitScanLines();
+    DoScanLines(Info().height, lineProcessor);
+    Strategy::EndScan();
+}
+
+
+// DoScanUntilEndOfScan: decodes a scan of which the number of lines is not known (defined by a DNL segment after the scan).
+// The lines are decoded until the end of the scan is reached, the rect defines the maximum number of lines.
+template<typename Traits, typename Strategy>
+template<typename LINE_PROCESSOR>
+void JlsCodec<Traits, Strategy>::DoScanUntilEndOfScan(LINE_PROCESSOR& lineProcessor)
+{
+    InitScanLines();
+    while (!Strategy::IsAtEndOfScan())
+    {
+        if (_line == _rect.Y + _rect.Height)
+            throw charls_error(ApiResult::UncompressedBufferTooSmall);
+
+        DoScanLines(1, lineProcessor);
+    }
+    Strategy::EndScan();
+}
+
+
+// InitScanLines: prepares the line buffers to process a scan from its first line.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::InitScanLines()
 {
     const int32_t pixelstride = _width + 4;
     const int components = Info().interleaveMode == charls::InterleaveMode::Line ? Info().components : 1;
 
-    std::vector<PIXEL> vectmp(static_cast<size_t>(2) * components * pixelstride);
-    std::vector<int32_t> rgRUNindex(components);
+    _lineBuffer.assign(static_cast<size_t>(2) * components * pixelstride, PIXEL());
+    _runIndices.assign(components, 0);
+    _line = 0;
+}
+
 
-    for (int32_t line = 0; line < Info().height; ++line)
+// DoScanLines: Encodes or decodes the next lines of a scan with the ProcessLine of the strategy.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DoScanLines(int32_t lineCount)
+{
+    DoScanLines(lineCount, *Strategy::_processLine);
+}
+
+
+// DoScanLines: Encodes or decodes the next lines of a scan. Allows to process a scan in multiple steps.
+// The line loop is instantiated for the type of the line processor: calls to a final ProcessLine class are inlined.
+template<typename Traits, typename Strategy>
+template<typename LINE_PROCESSOR>
+void JlsCodec<Traits, Strategy>::DoScanLines(int32_t lineCount, LINE_PROCESSOR& lineProcessor)
+{
+    const int32_t pixelstride = _width + 4;
+    const int components = Info().interleaveMode == charls::InterleaveMode::Line ? Info().components : 1;
+
+    for (const int32_t endLine = _line + lineCount; _line < endLine; ++_line)
     {
-        _previousLine = &vectmp[1];
-        _currentLine = &vectmp[1 + static_cast<size_t>(components) * pixelstride];
-        if ((line & 1) == 1)
+        _previousLine = &_lineBuffer[1];
+        _currentLine = &_lineBuffer[1 + static_cast<size_t>(components) * pixelstride];
+        if ((_line & 1) == 1)
         {
             std::swap(_previousLine, _currentLine);
         }
 
-        Strategy::OnLineBegin(_width, _currentLine, pixelstride);
+        OnLineBegin(lineProcessor, _currentLine, _width, pixelstride, static_cast<Strategy*>(nullptr));
 
         for (int component = 0; component < components; ++component)
         {
-            _RUNindex = rgRUNindex[component];
+            _RUNindex = _runIndices[component];
 
             // initialize edge pixels used for prediction
             _previousLine[_width] = _previousLine[_width - 1];
             _currentLine[-1] = _previousLine[0];
             DoLine(static_cast<PIXEL*>(nullptr)); // dummy argument for overload resolution
 
-            rgRUNindex[component] = _RUNindex;
+            _runIndices[component] = _RUNindex;
             _previousLine += pixelstride;
             _currentLine += pixelstride;
         }
 
-        if (_rect.Y <= line && line < _rect.Y + _rect.Height)
+        if (_rect.Y <= _line && _line < _rect.Y + _rect.Height)
         {
-            Strategy::OnLineEnd(_rect.Width, _currentLine + _rect.X - (static_cast<size_t>(components) * pixelstride), pixelstride);
+            OnLineEnd(lineProcessor, _currentLine + _rect.X - (static_cast<size_t>(components) * pixelstride), _rect.Width, pixelstride, static_cast<Strategy*>(nullptr));
         }
     }
-
-    Strategy::EndScan();
 }
 
 
@@ -765,16 +856,28 @@ std::unique_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStrea
             std::unique_ptr<ProcessLine>(std::make_unique<PostProcesSingleStream>(info.rawStream, Info(), sizeof(typename Traits::PIXEL)));
     }
 
+    return WithColorTransform([&](auto transform) -> std::unique_ptr<ProcessLine>
+    {
+        return std::make_unique<ProcessTransformed<decltype(transform)>>(info, Info(), transform);
+    });
+}
+
+
+// Calls the functor with the color transformation of the parameters, the transformation type is a template parameter of the functor.
+template<typename Traits, typename Strategy>
+template<typename FUNCTOR>
+auto JlsCodec<Traits, Strategy>::WithColorTransform(FUNCTOR functor)
+{
     if (Info().colorTransformation == ColorTransformation::None)
-        return std::make_unique<ProcessTransformed<TransformNone<typename Traits::SAMPLE>>>(info, Info(), TransformNone<SAMPLE>());
+        return functor(TransformNone<SAMPLE>());
 
     if (Info().bitsPerSample == sizeof(SAMPLE) * 8)
     {
         switch (Info().colorTransformation)
         {
-            case ColorTransformation::HP1: return std::make_unique<ProcessTransformed<TransformHp1<SAMPLE>>>(info, Info(), TransformHp1<SAMPLE>());
-            case ColorTransformation::HP2: return std::make_unique<ProcessTransformed<TransformHp2<SAMPLE>>>(info, Info(), TransformHp2<SAMPLE>());
-            case ColorTransformation::HP3: return std::make_unique<ProcessTransformed<TransformHp3<SAMPLE>>>(info, Info(), TransformHp3<SAMPLE>());
+            case ColorTransformation::HP1: return functor(TransformHp1<SAMPLE>());
+            case ColorTransformation::HP2: return functor(TransformHp2<SAMPLE>());
+            case ColorTransformation::HP3: return functor(TransformHp3<SAMPLE>());
             default:
                 std::ostringstream message;
                 message << "Color transformation " << Info().colorTransformation << " is not supported.";
@@ -787,9 +890,9 @@ std::unique_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStrea
         const int shift = 16 - Info().bitsPerSample;
         switch (Info().colorTransformation)
         {
-            case ColorTransformation::HP1: return std::make_unique<ProcessTransformed<TransformShifted<TransformHp1<uint16_t>>>>(info, Info(), TransformShifted<TransformHp1<uint16_t>>(shift));
-            case ColorTransformation::HP2: return std::make_unique<ProcessTransformed<TransformShifted<TransformHp2<uint16_t>>>>(info, Info(), TransformShifted<TransformHp2<uint16_t>>(shift));
-            case ColorTransformation::HP3: return std::make_unique<ProcessTransformed<TransformShifted<TransformHp3<uint16_t>>>>(info, Info(), TransformShifted<TransformHp3<uint16_t>>(shift));
+            case ColorTransformation::HP1: return functor(TransformShifted<TransformHp1<uint16_t>>(shift));
+            case ColorTransformation::HP2: return functor(TransformShifted<TransformHp2<uint16_t>>(shift));
+            case ColorTransformation::HP3: return functor(TransformShifted<TransformHp3<uint16_t>>(shift));
             default:
                 std::ostringstream message;
                 message << "Color transformation " << Info().colorTransformation << " is not supported.";
@@ -801,6 +904,63 @@ std::unique_ptr<ProcessLine> JlsCodec<Traits, Strategy>::CreateProcess(ByteStrea
 }
 
 
+// Calls the functor with the final ProcessLine for pixels in a byte array that CreateProcess would create for a single component
+// or line interleaved scan. Combinations without a final class use ProcessTransformed (as a ProcessLine).
+template<typename Traits, typename Strategy>
+template<typename FUNCTOR>
+void JlsCodec<Traits, Strategy>::WithRawProcess(uint8_t* rawData, FUNCTOR functor, SAMPLE*)
+{
+    if (!IsInterleaved())
+    {
+        PostProcesSingleComponent processLine(rawData, Info(), sizeof(SAMPLE));
+        functor(processLine);
+        return;
+    }
+
+    WithColorTransform([&](auto transform)
+    {
+        using TRANSFORM = decltype(transform);
+        if (Info().outputBgr)
+        {
+            ProcessTransformed<TRANSFORM> processLine(FromByteArray(rawData, 0), Info(), transform);
+            functor(static_cast<ProcessLine&>(processLine));
+        }
+        else if (Info().components == 3)
+        {
+            ProcessTransformedRaw<TRANSFORM, InterleaveMode::Line, 3, false> processLine(rawData, Info(), transform);
+            functor(processLine);
+        }
+        else
+        {
+            ProcessTransformedRaw<TRANSFORM, InterleaveMode::Line, 4, false> processLine(rawData, Info(), transform);
+            functor(processLine);
+        }
+    });
+}
+
+
+// Calls the functor with the final ProcessLine for pixels in a byte array that CreateProcess would create for a sample interleaved scan.
+template<typename Traits, typename Strategy>
+template<typename FUNCTOR>
+void JlsCodec<Traits, Strategy>::WithRawProcess(uint8_t* rawData, FUNCTOR functor, Triplet<SAMPLE>*)
+{
+    WithColorTransform([&](auto transform)
+    {
+        using TRANSFORM = decltype(transform);
+        if (Info().outputBgr)
+        {
+            ProcessTransformedRaw<TRANSFORM, InterleaveMode::Sample, 3, true> processLine(rawData, Info(), transform);
+            functor(processLine);
+        }
+        else
+        {
+            ProcessTransformedRaw<TRANSFORM, InterleaveMode::Sample, 3, false> processLine(rawData, Info(), transform);
+            functor(processLine);
+        }
+    });
+}
+
+
 // Setup codec for encoding and calls DoScan
 WARNING_SUPPRESS(26433)
 template<typename Traits, typename Strategy>
@@ -809,24 +969,156 @@ size_t JlsCodec<Traits, Strategy>::EncodeScan(std::unique_ptr<ProcessLine> proce
     Strategy::_processLine = std::move(processLine);
 
     Strategy::Init(compressedData);
-    DoScan();
+    DoScan(*Strategy::_processLine);
 
     return Strategy::GetLength();
 }
 
 
+// Encodes a scan from a byte array with the line loop instantiated for the ProcessLine type of CreateProcess.
+template<typename Traits, typename Strategy>
+size_t JlsCodec<Traits, Strategy>::EncodeScan(ByteStreamInfo rawPixels, ByteStreamInfo& compressedData)
+{
+    if (!rawPixels.rawData)
+        return EncodeScan(CreateProcess(rawPixels), compressedData);
+
+    Strategy::Init(compressedData);
+    WithRawProcess(rawPixels.rawData, [this](auto& processLine) { this->DoScan(processLine); }, static_cast<PIXEL*>(nullptr));
+
+    return Strategy::GetLength();
+}
+
+
+// Setup codec for encoding a scan in steps with EncodeLines. The encoded bytes are retrieved with TakeEncodedBytes.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::StartEncodeScan(ByteStreamInfo& compressedData)
+{
+    Strategy::Init(compressedData);
+    InitScanLines();
+}
+
+
+// EncodeLines: encodes the next lines of the scan, processLine provides the pixels of these lines.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::EncodeLines(std::unique_ptr<ProcessLine> processLine, int32_t lineCount)
+{
+    Strategy::_processLine = std::move(processLine);
+    DoScanLines(lineCount);
+}
+
+
 // Setup codec for decoding and calls DoScan
 template<typename Traits, typename Strategy>
 void JlsCodec<Traits, Strategy>::DecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData)
 {
     Strategy::_processLine = std::move(processLine);
+    DecodeScanLines(*Strategy::_processLine, rect, compressedData);
+}
+
+
+// Decodes a scan to a byte array with the line loop instantiated for the ProcessLine type of CreateProcess.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DecodeScan(ByteStreamInfo rawPixels, const JlsRect& rect, ByteStreamInfo& compressedData)
+{
+    if (!rawPixels.rawData)
+    {
+        DecodeScan(CreateProcess(rawPixels), rect, compressedData);
+        return;
+    }
+
+    WithRawProcess(rawPixels.rawData, [&](auto& processLine) { this->DecodeScanLines(processLine, rect, compressedData); }, static_cast<PIXEL*>(nullptr));
+}
+
+
+template<typename Traits, typename Strategy>
+template<typename LINE_PROCESSOR>
+void JlsCodec<Traits, Strategy>::DecodeScanLines(LINE_PROCESSOR& lineProcessor, const JlsRect& rect, ByteStreamInfo& compressedData)
+{
+    _rect = rect;
+
+    Strategy::Init(compressedData);
+    if (Info().height == 0)
+    {
+        DoScanUntilEndOfScan(lineProcessor);
+    }
+    else
+    {
+        DoScan(lineProcessor);
+    }
 
-    const uint8_t* compressedBytes = compressedData.rawData;
+    if (compressedData.rawData)
+    {
+        compressedData = Strategy::GetRemainingBytes();
+    }
+    else
+    {
+        Strategy::PutBackBytesAfterScan();
+    }
+}
+
+
+// Setup codec for decoding a scan in steps with DecodeLines. The caller is responsible to call EndScan.
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::StartDecodeScan(std::unique_ptr<ProcessLine> processLine, const JlsRect& rect, ByteStreamInfo& compressedData)
+{
+    Strategy::_processLine = std::move(processLine);
     _rect = rect;
 
     Strategy::Init(compressedData);
-    DoScan();
-    SkipBytes(compressedData, Strategy::GetCurBytePos() - compressedBytes);
+    InitScanLines();
+}
+
+
+template<typename Traits, typename Strategy>
+void JlsCodec<Traits, Strategy>::DecodeLines(int32_t lineCount)
+{
+    DoScanLines(lineCount);
+}
+
+
+// TryDecodeLine: decodes the next line speculatively. When the line needs bytes that are not buffered yet, the line is not
+// passed to the ProcessLine and the contexts and bit reader are restored: the line is decoded again when more bytes are added.
+// The line buffer doesn't need to be restored, decoding the line again overwrites it.
+template<typename Traits, typename Strategy>
+bool JlsCodec<Traits, Strategy>::TryDecodeLine()
+{
+    struct CheckedLineProcess
+    {
+        JlsCodec& codec;
+
+        void NewLineDecoded(const void* pSrc, int pixelCount, int sourceStride)
+        {
+            if (codec.IsReadPastBufferedBytes())
+                throw charls_error(charls::ApiResult::CompressedBufferTooSmall);
+
+            codec._processLine->NewLineDecoded(pSrc, pixelCount, sourceStride);
+        }
+    };
+
+    const auto readerState = Strategy::GetReaderState();
+    JlsContext contexts[365];
+    std::copy(std::begin(_contexts), std::end(_contexts), contexts);
+    CContextRunMode contextRunmode[2] = { _contextRunmode[0], _contextRunmode[1] };
+    const std::vector<int32_t> runIndices = _runIndices;
+
+    try
+    {
+        CheckedLineProcess lineProcess{*this};
+        DoScanLines(1, lineProcess);
+        return true;
+    }
+    catch (const charls_error&)
+    {
+        // An error while decoding past the buffered bytes is an under-run, the other errors are real.
+        if (!Strategy::IsReadPastBufferedBytes() && !Strategy::IsAtEndOfBufferedBytes())
+            throw;
+
+        Strategy::SetReaderState(readerState);
+        std::copy(std::begin(contexts), std::end(contexts), _contexts);
+        std::copy(std::begin(contextRunmode), std::end(contextRunmode), _contextRunmode);
+        _runIndices = runIndices;
+        return false;
+    }
 }
 WARNING_UNSUPPRESS()
 
@@ -8,6 +8,7 @@
 
 #include "publictypes.h"
 #include <vector>
+#include <algorithm>
 #include <system_error>
 
 // ReSharper disable once CppUnusedIncludeDirective
@@ -190,6 +191,21 @@ private:
 };
 
 
+// Worst case size of 1 encoded line: every sample is coded with LIMIT bits (ISO/IEC 14495-1, A.5.3) and after every
+// 0xFF byte only 7 bits are used (A.1). The extra bytes cover the run length remainder and the padding at the end of a scan.
+inline std::size_t MaximumEncodedLineByteCount(const JlsParameters& params) noexcept
+{
+    const int32_t limit = 2 * (params.bitsPerSample + std::max(8, params.bitsPerSample));
+    const std::size_t sampleCount = static_cast<std::size_t>(params.width) * (params.interleaveMode == charls::InterleaveMode::None ? 1 : params.components);
+    return (sampleCount * limit + 6) / 7 + sizeof(std::size_t);
+}
+
+
+// The number of bytes that are transferred at a time from and to a stream with the requested block size of the stream
+// (ByteStreamInfo::blockSize, JlsStreamCallbacks::blockSize): 0 selects the default of 64 KiB, the minimum is 1 KiB.
+std::size_t GetStreamBlockSize(std::size_t blockSize) noexcept;
+
+
 inline void SkipBytes(ByteStreamInfo& streamInfo, std::size_t count) noexcept
 {
     if (!streamInfo.rawData)
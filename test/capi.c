@@ -0,0 +1,59 @@
+/*
+ Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+*/
+
+#include "capi.h"
+#include "../src/charls.h"
+#include <stdlib.h>
+#include <string.h>
+
+
+int TestCApi(void)
+{
+    enum { Width = 33, Height = 21, Components = 3 };
+    unsigned char pixels[Width * Height * Components];
+    unsigned char decoded[sizeof pixels];
+    struct JlsParameters params;
+    struct JlsFragment fragments[2];
+    size_t maximumSize = 0;
+    size_t bytesWritten = 0;
+    unsigned char* encoded;
+    char errorMessage[256];
+    int result = 1;
+    size_t i;
+
+    for (i = 0; i < sizeof pixels; ++i)
+    {
+        pixels[i] = (unsigned char)(i * 7 % 251);
+    }
+
+    memset(&params, 0, sizeof params);
+    params.width = Width;
+    params.height = Height;
+    params.bitsPerSample = 8;
+    params.components = Components;
+    params.interleaveMode = CHARLS_IM_SAMPLE;
+
+    if (JpegLsGetMaximumEncodedSize(&params, &maximumSize, errorMessage) != CHARLS_API_RESULT_OK)
+        return 1;
+
+    encoded = (unsigned char*)malloc(maximumSize);
+    if (!encoded)
+        return 1;
+
+    if (JpegLsEncode(encoded, maximumSize, &bytesWritten, pixels, sizeof pixels, &params, errorMessage) == CHARLS_API_RESULT_OK)
+    {
+        fragments[0].data = encoded;
+        fragments[0].length = bytesWritten / 2;
+        fragments[1].data = encoded + bytesWritten / 2;
+        fragments[1].length = bytesWritten - bytesWritten / 2;
+        if (JpegLsDecodeFragments(decoded, sizeof decoded, fragments, 2, NULL, errorMessage) == CHARLS_API_RESULT_OK &&
+            memcmp(decoded, pixels, sizeof pixels) == 0)
+        {
+            result = 0;
+        }
+    }
+
+    free(encoded);
+    return result;
+}
@@ -0,0 +1,21 @@
+//
+// Copyright CharLS Team, all rights reserved. See the accompanying "License.txt" for licensed use.
+//
+
+#ifndef TEST_C_API
+#define TEST_C_API
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+// Implemented in a C translation unit: the public headers must remain valid C.
+// Returns 0 when an image encoded and decoded with the C API round trips.
+int TestCApi(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
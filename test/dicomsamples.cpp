@@ -7,6 +7,7 @@
 #include "../src/charls.h"
 #include <iostream>
 #include <vector>
+#include <algorithm>
 
 
 #define COUNT(x) (sizeof(x)/sizeof((x)[0]))
@@ -48,22 +49,22 @@ void TestDicomSampleImage(const char* name)
 
     const int offset = findstring(data, pixeldataStart, COUNT(pixeldataStart));
 
-    data.erase(data.begin(), data.begin() + offset - 4);
-
-    // remove the DICOM fragment headers (in the concerned images they occur every 64k)
-    for (unsigned int i =  0; i < data.size(); i+= 64 * 1024)
+    // skip the DICOM fragment headers (in the concerned images they occur every 64k), the fragments are decoded in place.
+    const size_t fragmentSize = 64 * 1024;
+    std::vector<JlsFragment> fragments;
+    for (size_t i = offset + 4; i < data.size(); i += fragmentSize + 8)
     {
-        data.erase(data.begin() + i, data.begin() + i + 8);
+        fragments.push_back({ &data[i], std::min(fragmentSize, data.size() - i) });
     }
 
     JlsParameters params{};
-    auto error = JpegLsReadHeader(data.data(), data.size(), &params, nullptr);
+    auto error = JpegLsReadHeaderFragments(fragments.data(), fragments.size(), &params, nullptr);
     Assert::IsTrue(error == charls::ApiResult::OK);
 
     std::vector<uint8_t> dataUnc;
     dataUnc.resize(static_cast<size_t>(params.stride) * params.height);
 
-    error = JpegLsDecode(dataUnc.data(), dataUnc.size(), &data[0], data.size(), nullptr, nullptr);
+    error = JpegLsDecodeFragments(dataUnc.data(), dataUnc.size(), fragments.data(), fragments.size(), nullptr, nullptr);
     Assert::IsTrue(error == charls::ApiResult::OK);
     std::cout << ".";
 }
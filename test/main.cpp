@@ -8,16 +8,20 @@
 #include "../src/defaulttraits.h"
 #include "../src/losslesstraits.h"
 #include "../src/processline.h"
+#include "../src/callbackstreambuf.h"
 
 #include "bitstreamdamage.h"
 #include "compliance.h"
 #include "performance.h"
 #include "dicomsamples.h"
+#include "capi.h"
 
 #include <sstream>
 #include <fstream>
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 
 using namespace charls;
 
@@ -222,87 +226,2148 @@ void TestBgr()
 }
 
 
+int CollectLine(void* context, const void* line, int /*pixelCount*/, size_t stride)
+{
+    auto* lines = static_cast<std::vector<uint8_t>*>(context);
+    lines->insert(lines->end(), static_cast<const uint8_t*>(line), static_cast<const uint8_t*>(line) + stride);
+    return 0;
+}
+
+
+// Swaps the first and third component of every pixel (the pixels of interleave mode Line and Sample are interleaved).
+std::vector<uint8_t> SwapRedBlue(const std::vector<uint8_t>& pixels, const JlsParameters& params)
+{
+    const size_t bytesPerSample = params.bitsPerSample <= 8 ? 1 : 2;
+    const size_t pixelSize = bytesPerSample * params.components;
+    std::vector<uint8_t> swapped = pixels;
+    for (size_t pixel = 0; pixel < swapped.size(); pixel += pixelSize)
+    {
+        for (size_t byte = 0; byte < bytesPerSample; ++byte)
+        {
+            std::swap(swapped[pixel + byte], swapped[pixel + 2 * bytesPerSample + byte]);
+        }
+    }
+    return swapped;
+}
+
+
+// Byte arrays are encoded and decoded with a line loop instantiated for the final ProcessLine class, the line callback uses
+// ProcessTransformed: both need to give the same result for every interleave mode, color transformation and BGR order.
+void TestInlinedLineProcessing()
+{
+    for (const int bitsPerSample : {8, 12})
+    {
+        for (const int components : {3, 4})
+        {
+            for (const InterleaveMode interleaveMode : {InterleaveMode::Line, InterleaveMode::Sample})
+            {
+                for (const ColorTransformation colorTransformation : {ColorTransformation::None, ColorTransformation::HP1, ColorTransformation::HP2, ColorTransformation::HP3})
+                {
+                    if (components == 4 && (interleaveMode == InterleaveMode::Sample || colorTransformation != ColorTransformation::None))
+                        continue;
+
+                    // Note: the shifted HP2 and HP3 transformations of samples with less than 16 bits don't round trip (as before).
+                    if (bitsPerSample == 12 && (colorTransformation == ColorTransformation::HP2 || colorTransformation == ColorTransformation::HP3))
+                        continue;
+
+                    JlsParameters params{};
+                    params.width = 23;
+                    params.height = 17;
+                    params.bitsPerSample = bitsPerSample;
+                    params.components = components;
+                    params.interleaveMode = interleaveMode;
+                    params.colorTransformation = colorTransformation;
+                    const size_t sampleCount = static_cast<size_t>(23) * 17 * components;
+                    const std::vector<uint8_t> pixels = bitsPerSample == 8 ? MakeSomeNoise(sampleCount, 8, 31) : MakeSomeNoise16bit(sampleCount, 12, 31);
+
+                    std::vector<uint8_t> compressed(pixels.size() * 2 + 1024);
+                    size_t compressedLength = 0;
+                    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, pixels.data(), pixels.size(), &params, nullptr) == ApiResult::OK);
+
+                    std::vector<uint8_t> decoded(pixels.size());
+                    Assert::IsTrue(JpegLsDecode(decoded.data(), decoded.size(), compressed.data(), compressedLength, nullptr, nullptr) == ApiResult::OK);
+                    Assert::IsTrue(decoded == pixels);
+
+                    std::vector<uint8_t> lines;
+                    Assert::IsTrue(JpegLsDecodeWithCallback(compressed.data(), compressedLength, nullptr, CollectLine, &lines, nullptr) == ApiResult::OK);
+                    Assert::IsTrue(lines == pixels);
+
+                    if (components == 4)
+                        continue;
+
+                    // BGR pixels: the order is swapped while the lines are encoded and decoded.
+                    JlsParameters bgrParams{};
+                    bgrParams.outputBgr = static_cast<char>(true);
+                    Assert::IsTrue(JpegLsDecode(decoded.data(), decoded.size(), compressed.data(), compressedLength, &bgrParams, nullptr) == ApiResult::OK);
+                    Assert::IsTrue(decoded == SwapRedBlue(pixels, params));
+
+                    params.outputBgr = static_cast<char>(true);
+                    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, decoded.data(), decoded.size(), &params, nullptr) == ApiResult::OK);
+                    Assert::IsTrue(JpegLsDecode(decoded.data(), decoded.size(), compressed.data(), compressedLength, nullptr, nullptr) == ApiResult::OK);
+                    Assert::IsTrue(decoded == pixels);
+                }
+            }
+        }
+    }
+}
+
+
 void TestTooSmallOutputBuffer()
 {
-    std::vector<uint8_t> rgbyteCompressed;
-    if (!ReadFile("test/lena8b.jls", &rgbyteCompressed, 0))
+    std::vector<uint8_t> rgbyteCompressed;
+    if (!ReadFile("test/lena8b.jls", &rgbyteCompressed, 0))
+        return;
+
+    std::vector<uint8_t> rgbyteOut(512 * 511);
+    const auto error = JpegLsDecode(&rgbyteOut[0], rgbyteOut.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), nullptr, nullptr);
+
+    Assert::IsTrue(error == ApiResult::UncompressedBufferTooSmall);
+}
+
+
+////void TestBadImage()
+////{
+////    std::vector<uint8_t> rgbyteCompressed;
+////    if (!ReadFile("test/BadCompressedStream.jls", &rgbyteCompressed, 0))
+////        return;
+////
+////    std::vector<uint8_t> rgbyteOut(2500 * 3000 * 2);
+////    auto error = JpegLsDecode(&rgbyteOut[0], rgbyteOut.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), nullptr, nullptr);
+////
+////    Assert::IsTrue(error == ApiResult::UncompressedBufferTooSmall);
+////}
+
+
+void TestDecodeBitStreamWithNoMarkerStart()
+{
+    const uint8_t encodedData[2] = { 0x33, 0x33 };
+    uint8_t output[1000];
+
+    const auto error = JpegLsDecode(output, 1000, encodedData, 2, nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::MissingJpegMarkerStart);
+}
+
+
+void TestDecodeBitStreamWithUnsupportedEncoding()
+{
+    const uint8_t encodedData[6] = { 0xFF, 0xD8, // Start Of Image (JPEG_SOI)
+                            0xFF, 0xC3, // Start Of Frame (lossless, Huffman) (JPEG_SOF_3)
+                            0x00, 0x00  // Length of data of the marker
+                          };
+    uint8_t output[1000];
+
+    const auto error = JpegLsDecode(output, 1000, encodedData, 6, nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::UnsupportedEncoding);
+}
+
+
+void TestDecodeBitStreamWithUnknownJpegMarker()
+{
+    const uint8_t encodedData[6] = { 0xFF, 0xD8, // Start Of Image (JPEG_SOI)
+        0xFF, 0x01, // Undefined marker
+        0x00, 0x00  // Length of data of the marker
+    };
+    uint8_t output[1000];
+
+    const auto error = JpegLsDecode(output, 1000, encodedData, 6, nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::UnknownJpegMarker);
+}
+
+
+void TestDecodeRect()
+{
+    std::vector<uint8_t> rgbyteCompressed;
+    JlsParameters params{};
+    if (!ScanFile("test/lena8b.jls", &rgbyteCompressed, &params))
+        return;
+
+    std::vector<uint8_t> rgbyteOutFull(static_cast<size_t>(params.width) * params.height*params.components);
+    auto error = JpegLsDecode(&rgbyteOutFull[0], rgbyteOutFull.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+
+    const JlsRect rect = { 128, 128, 256, 1 };
+    std::vector<uint8_t> rgbyteOut(static_cast<size_t>(rect.Width) * rect.Height);
+    rgbyteOut.push_back(0x1f);
+    error = JpegLsDecodeRect(&rgbyteOut[0], rgbyteOut.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), rect, nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+
+    Assert::IsTrue(memcmp(&rgbyteOutFull[rect.X + static_cast<size_t>(rect.Y) * 512], &rgbyteOut[0], static_cast<size_t>(rect.Width) * rect.Height) == 0);
+    Assert::IsTrue(rgbyteOut[static_cast<size_t>(rect.Width) * rect.Height] == 0x1f);
+}
+
+
+void TestPushDecoder(const char* file, size_t chunkSize)
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile(file, &compressed, &params))
+        return;
+
+    const size_t decodedSize = static_cast<size_t>(params.width) * params.height * params.components * ((params.bitsPerSample + 7) / 8);
+    std::vector<uint8_t> expected(decodedSize);
+    auto error = JpegLsDecode(expected.data(), expected.size(), compressed.data(), compressed.size(), nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+
+    Assert::IsTrue(JpegLsPushDecoderCreate(nullptr, nullptr, nullptr) == ApiResult::InvalidJlsParameters);
+
+    JlsPushDecoder* decoder = nullptr;
+    Assert::IsTrue(JpegLsPushDecoderCreate(nullptr, &decoder, nullptr) == ApiResult::OK);
+    Assert::IsTrue(decoder != nullptr);
+
+    JlsParameters pushParams{};
+    Assert::IsTrue(JpegLsPushDecoderReadHeader(decoder, &pushParams, nullptr) == ApiResult::CompressedBufferTooSmall);
+
+    std::vector<uint8_t> decoded(decodedSize);
+    size_t decodedLineCount = 0;
+    for (size_t offset = 0; offset < compressed.size(); offset += chunkSize)
+    {
+        error = JpegLsPushDecoderAddBytes(decoder, &compressed[offset], std::min(chunkSize, compressed.size() - offset), &decodedLineCount, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+
+        if (pushParams.width == 0 && JpegLsPushDecoderReadHeader(decoder, &pushParams, nullptr) == ApiResult::OK)
+        {
+            Assert::IsTrue(pushParams.width == params.width && pushParams.height == params.height);
+            error = JpegLsPushDecoderSetDestination(decoder, decoded.data(), decoded.size(), nullptr);
+            Assert::IsTrue(error == ApiResult::OK);
+        }
+    }
+
+    JpegLsPushDecoderDestroy(decoder);
+
+    const size_t scanCount = params.interleaveMode == InterleaveMode::None ? params.components : 1;
+    Assert::IsTrue(decodedLineCount == params.height * scanCount);
+    Assert::IsTrue(decoded == expected);
+}
+
+
+// The lines of a smooth image are encoded in far fewer bytes than the worst case size of an encoded line: every line must
+// be decoded as soon as its bytes have been added, not when a worst case line is buffered.
+void TestPushDecoderLatency()
+{
+    JlsParameters params{};
+    params.width = 256;
+    params.height = 64;
+    params.bitsPerSample = 16;
+    params.components = 3;
+    params.interleaveMode = InterleaveMode::Sample;
+
+    std::vector<uint16_t> pixels(static_cast<size_t>(params.width) * params.height * params.components);
+    for (size_t i = 0; i < pixels.size(); ++i)
+    {
+        pixels[i] = static_cast<uint16_t>(1000 + i / params.components / params.width);
+    }
+
+    std::vector<uint8_t> compressed(pixels.size() * 4 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, pixels.data(), pixels.size() * 2, &params, nullptr) == ApiResult::OK);
+
+    JlsPushDecoder* decoder = nullptr;
+    Assert::IsTrue(JpegLsPushDecoderCreate(nullptr, &decoder, nullptr) == ApiResult::OK);
+    std::vector<uint16_t> decoded(pixels.size());
+    size_t decodedLineCount = 0;
+    Assert::IsTrue(JpegLsPushDecoderSetDestination(decoder, decoded.data(), decoded.size() * 2, nullptr) == ApiResult::OK);
+
+    // Everything except the EOI marker: the end of the scan has not been received yet.
+    for (size_t offset = 0; offset < compressedLength - 2; ++offset)
+    {
+        Assert::IsTrue(JpegLsPushDecoderAddBytes(decoder, &compressed[offset], 1, &decodedLineCount, nullptr) == ApiResult::OK);
+    }
+    Assert::IsTrue(decodedLineCount + 1 >= static_cast<size_t>(params.height));
+
+    Assert::IsTrue(JpegLsPushDecoderAddBytes(decoder, &compressed[compressedLength - 2], 2, &decodedLineCount, nullptr) == ApiResult::OK);
+    JpegLsPushDecoderDestroy(decoder);
+    Assert::IsTrue(decodedLineCount == static_cast<size_t>(params.height));
+    Assert::IsTrue(decoded == pixels);
+}
+
+
+void TestPushDecoder()
+{
+    TestPushDecoder("test/lena8b.jls", 1);
+    TestPushDecoder("test/lena8b.jls", 4000);
+    TestPushDecoder("test/conformance/T8C0E0.JLS", 97);
+    TestPushDecoder("test/conformance/T8C2E3.JLS", 1021);
+    TestPushDecoder("test/conformance/T16E3.JLS", 333);
+    TestPushDecoderLatency();
+}
+
+
+void TestPushEncoder(const std::vector<uint8_t>& pixels, const JlsParameters& params, size_t linesPerCall)
+{
+    std::vector<uint8_t> expected(pixels.size() * 2 + 1024);
+    size_t expectedLength = 0;
+    auto error = JpegLsEncode(expected.data(), expected.size(), &expectedLength, pixels.data(), pixels.size(), &params, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+    expected.resize(expectedLength);
+
+    JlsPushEncoder* encoder = nullptr;
+    error = JpegLsPushEncoderCreate(&params, &encoder, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+
+    const size_t lineLength = pixels.size() / params.height / (params.interleaveMode == InterleaveMode::None ? params.components : 1);
+    std::vector<uint8_t> encoded;
+    uint8_t chunk[61];
+    size_t bytesWritten = 0;
+    for (size_t offset = 0; offset < pixels.size(); offset += linesPerCall * lineLength)
+    {
+        const size_t sourceLength = std::min(linesPerCall * lineLength, pixels.size() - offset);
+        error = JpegLsPushEncoderEncodeLines(encoder, &pixels[offset], sourceLength, chunk, sizeof(chunk), &bytesWritten, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        encoded.insert(encoded.end(), chunk, chunk + bytesWritten);
+
+        while (bytesWritten == sizeof(chunk))
+        {
+            error = JpegLsPushEncoderEncodeLines(encoder, nullptr, 0, chunk, sizeof(chunk), &bytesWritten, nullptr);
+            Assert::IsTrue(error == ApiResult::OK);
+            encoded.insert(encoded.end(), chunk, chunk + bytesWritten);
+        }
+    }
+
+    JpegLsPushEncoderDestroy(encoder);
+
+    Assert::IsTrue(encoded == expected);
+}
+
+
+void TestPushEncoder()
+{
+    JlsParameters params{};
+    params.width = 512;
+    params.height = 512;
+    params.bitsPerSample = 8;
+    params.components = 1;
+    TestPushEncoder(MakeSomeNoise(512 * 512, 8, 21344), params, 1);
+
+    params.bitsPerSample = 12;
+    TestPushEncoder(MakeSomeNoise16bit(512 * 512, 12, 21344), params, 7);
+
+    std::vector<uint8_t> pixels;
+    if (!ReadFile("test/conformance/TEST8.PPM", &pixels, 15))
+        return;
+
+    params.width = 256;
+    params.height = 256;
+    params.bitsPerSample = 8;
+    params.components = 3;
+    params.interleaveMode = InterleaveMode::Sample;
+    TestPushEncoder(pixels, params, 1);
+
+    params.interleaveMode = InterleaveMode::Line;
+    TestPushEncoder(pixels, params, 3);
+
+    params.interleaveMode = InterleaveMode::None;
+    TestPushEncoder(pixels, params, 100);
+}
+
+
+void TestDefineNumberOfLines()
+{
+    const int width = 300;
+    const int lineCount = 97;
+    const std::vector<uint8_t> pixels = MakeSomeNoise(static_cast<size_t>(width) * lineCount, 8, 21344);
+
+    JlsParameters params{};
+    params.width = width;
+    params.height = 0;
+    params.bitsPerSample = 8;
+    params.components = 1;
+
+    JlsPushEncoder* encoder = nullptr;
+    auto error = JpegLsPushEncoderCreate(&params, &encoder, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+
+    std::vector<uint8_t> encoded(pixels.size() * 2);
+    size_t encodedLength = 0;
+    size_t bytesWritten = 0;
+    for (size_t offset = 0; offset < pixels.size(); offset += 10 * width)
+    {
+        const size_t sourceLength = std::min(static_cast<size_t>(10) * width, pixels.size() - offset);
+        error = JpegLsPushEncoderEncodeLines(encoder, &pixels[offset], sourceLength, &encoded[encodedLength], encoded.size() - encodedLength, &bytesWritten, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        encodedLength += bytesWritten;
+    }
+    error = JpegLsPushEncoderFinish(encoder, &encoded[encodedLength], encoded.size() - encodedLength, &bytesWritten, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+    encodedLength += bytesWritten;
+    encoded.resize(encodedLength);
+    JpegLsPushEncoderDestroy(encoder);
+
+    error = JpegLsReadHeader(encoded.data(), encoded.size(), &params, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+    Assert::IsTrue(params.height == 0);
+
+    std::vector<uint8_t> decoded(pixels.size());
+    error = JpegLsDecode(decoded.data(), decoded.size(), encoded.data(), encoded.size(), nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+    Assert::IsTrue(decoded == pixels);
+
+    error = JpegLsDecode(decoded.data(), decoded.size() - width, encoded.data(), encoded.size(), nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::UncompressedBufferTooSmall);
+
+    JlsPushDecoder* decoder = nullptr;
+    error = JpegLsPushDecoderCreate(nullptr, &decoder, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+    std::fill(decoded.begin(), decoded.end(), static_cast<uint8_t>(0));
+    size_t decodedLineCount = 0;
+    for (size_t offset = 0; offset < encoded.size(); offset += 37)
+    {
+        error = JpegLsPushDecoderAddBytes(decoder, &encoded[offset], std::min(static_cast<size_t>(37), encoded.size() - offset), &decodedLineCount, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        if (offset == 0)
+        {
+            error = JpegLsPushDecoderSetDestination(decoder, decoded.data(), decoded.size(), nullptr);
+            Assert::IsTrue(error == ApiResult::OK);
+        }
+    }
+
+    error = JpegLsPushDecoderReadHeader(decoder, &params, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+    JpegLsPushDecoderDestroy(decoder);
+
+    Assert::IsTrue(params.height == lineCount);
+    Assert::IsTrue(decodedLineCount == lineCount);
+    Assert::IsTrue(decoded == pixels);
+
+    // The lines of all components are coded in 1 scan with interleave mode line or sample.
+    for (const auto interleaveMode : { InterleaveMode::Line, InterleaveMode::Sample })
+    {
+        const std::vector<uint8_t> colorPixels = MakeSomeNoise(static_cast<size_t>(31) * 23 * 3, 8, 21345);
+
+        JlsParameters colorParams{};
+        colorParams.width = 31;
+        colorParams.height = 0;
+        colorParams.bitsPerSample = 8;
+        colorParams.components = 3;
+        colorParams.interleaveMode = interleaveMode;
+
+        JlsPushEncoder* colorEncoder = nullptr;
+        error = JpegLsPushEncoderCreate(&colorParams, &colorEncoder, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+
+        std::vector<uint8_t> colorEncoded(colorPixels.size() * 2);
+        size_t colorEncodedLength = 0;
+        error = JpegLsPushEncoderEncodeLines(colorEncoder, colorPixels.data(), colorPixels.size(), colorEncoded.data(), colorEncoded.size(), &colorEncodedLength, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        error = JpegLsPushEncoderFinish(colorEncoder, &colorEncoded[colorEncodedLength], colorEncoded.size() - colorEncodedLength, &bytesWritten, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        colorEncoded.resize(colorEncodedLength + bytesWritten);
+        JpegLsPushEncoderDestroy(colorEncoder);
+
+        std::vector<uint8_t> colorDecoded(colorPixels.size());
+        error = JpegLsDecode(colorDecoded.data(), colorDecoded.size(), colorEncoded.data(), colorEncoded.size(), nullptr, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        Assert::IsTrue(colorDecoded == colorPixels);
+    }
+}
+
+
+int AppendDecodedLine(void* context, const void* line, int /*pixelCount*/, size_t stride)
+{
+    auto decoded = static_cast<std::vector<uint8_t>*>(context);
+    decoded->insert(decoded->end(), static_cast<const uint8_t*>(line), static_cast<const uint8_t*>(line) + stride);
+    return 0;
+}
+
+
+int AbortDecoding(void* /*context*/, const void* /*line*/, int /*pixelCount*/, size_t /*stride*/)
+{
+    return 1;
+}
+
+
+struct LineSource
+{
+    const uint8_t* pixels;
+    size_t lineCount;
+};
+
+
+int CopyRequestedLine(void* context, void* line, int /*pixelCount*/, size_t stride)
+{
+    auto source = static_cast<LineSource*>(context);
+    memcpy(line, source->pixels + source->lineCount * stride, stride);
+    ++source->lineCount;
+    return 0;
+}
+
+
+void TestLineCallbacks()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C2E3.JLS", &compressed, &params))
+        return;
+
+    std::vector<uint8_t> expected(static_cast<size_t>(params.width) * params.height * params.components);
+    auto error = JpegLsDecode(expected.data(), expected.size(), compressed.data(), compressed.size(), nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+
+    std::vector<uint8_t> decoded;
+    error = JpegLsDecodeWithCallback(compressed.data(), compressed.size(), nullptr, AppendDecodedLine, &decoded, nullptr);
+    Assert::IsTrue(error == ApiResult::OK);
+    Assert::IsTrue(decoded == expected);
+
+    error = JpegLsDecodeWithCallback(compressed.data(), compressed.size(), nullptr, AbortDecoding, nullptr, nullptr);
+    Assert::IsTrue(error == ApiResult::UnexpectedFailure);
+
+    std::vector<uint8_t> pixels;
+    if (!ReadFile("test/conformance/TEST8.PPM", &pixels, 15))
+        return;
+
+    params = JlsParameters();
+    params.width = 256;
+    params.height = 256;
+    params.bitsPerSample = 8;
+    params.components = 3;
+
+    for (const auto interleaveMode : { InterleaveMode::None, InterleaveMode::Line, InterleaveMode::Sample })
+    {
+        params.interleaveMode = interleaveMode;
+
+        std::vector<uint8_t> expectedEncoded(pixels.size());
+        size_t expectedLength = 0;
+        error = JpegLsEncode(expectedEncoded.data(), expectedEncoded.size(), &expectedLength, pixels.data(), pixels.size(), &params, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+
+        std::vector<uint8_t> encoded(pixels.size());
+        size_t encodedLength = 0;
+        LineSource source{pixels.data(), 0};
+        error = JpegLsEncodeWithCallback(encoded.data(), encoded.size(), &encodedLength, &params, CopyRequestedLine, &source, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        Assert::IsTrue(encodedLength == expectedLength);
+        Assert::IsTrue(memcmp(encoded.data(), expectedEncoded.data(), encodedLength) == 0);
+    }
+}
+
+
+void CountCompletedBatch(void* context)
+{
+    ++*static_cast<int*>(context);
+}
+
+
+void TestBatch()
+{
+    const char* files[] = { "test/lena8b.jls", "test/conformance/T8C0E0.JLS", "test/conformance/T8C1E3.JLS", "test/conformance/T16E0.JLS", "test/conformance/T8NDE3.JLS" };
+    const size_t jobCount = 4 * (sizeof(files) / sizeof(files[0]));
+
+    std::vector<std::vector<uint8_t>> compressed(jobCount);
+    std::vector<std::vector<uint8_t>> expected(jobCount);
+    std::vector<std::vector<uint8_t>> decoded(jobCount);
+    std::vector<JlsDecodeJob> jobs(jobCount);
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        JlsParameters params{};
+        if (!ScanFile(files[i % (sizeof(files) / sizeof(files[0]))], &compressed[i], &params))
+            return;
+
+        const size_t size = static_cast<size_t>(params.width) * params.height * params.components * ((params.bitsPerSample + 7) / 8);
+        expected[i].resize(size);
+        const auto error = JpegLsDecode(expected[i].data(), size, compressed[i].data(), compressed[i].size(), nullptr, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+
+        decoded[i].resize(size);
+        jobs[i] = { compressed[i].data(), compressed[i].size(), decoded[i].data(), size, nullptr, ApiResult::UnexpectedFailure };
+    }
+
+    int completedCount = 0;
+    JlsBatch* batch = JpegLsDecodeBatchAsync(jobs.data(), jobs.size(), 3, nullptr, CountCompletedBatch, &completedCount);
+    Assert::IsTrue(batch != nullptr);
+    JpegLsBatchWait(batch);
+    JpegLsBatchDestroy(batch);
+
+    Assert::IsTrue(completedCount == 1);
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        Assert::IsTrue(jobs[i].result == ApiResult::OK);
+        Assert::IsTrue(decoded[i] == expected[i]);
+    }
+
+    std::vector<JlsParameters> params(jobCount);
+    std::vector<std::vector<uint8_t>> encoded(jobCount);
+    std::vector<JlsEncodeJob> encodeJobs(jobCount);
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        JpegLsReadHeader(compressed[i].data(), compressed[i].size(), &params[i], nullptr);
+        params[i].stride = 0;
+        encoded[i].resize(expected[i].size() + 1024);
+        encodeJobs[i] = { encoded[i].data(), encoded[i].size(), expected[i].data(), expected[i].size(), &params[i], 0, ApiResult::UnexpectedFailure };
+    }
+
+    batch = JpegLsEncodeBatchAsync(encodeJobs.data(), encodeJobs.size(), 0, nullptr, nullptr, nullptr);
+    JpegLsBatchDestroy(batch);
+
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        Assert::IsTrue(encodeJobs[i].result == ApiResult::OK);
+
+        std::vector<uint8_t> roundTrip(expected[i].size());
+        const auto error = JpegLsDecode(roundTrip.data(), roundTrip.size(), encoded[i].data(), encodeJobs[i].bytesWritten, nullptr, nullptr);
+        Assert::IsTrue(error == ApiResult::OK);
+        Assert::IsTrue(params[i].allowedLossyError != 0 || roundTrip == expected[i]);
+    }
+}
+
+
+void TestDecodeFragments(const char* file, size_t fragmentSize)
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile(file, &compressed, &params))
+        return;
+
+    const size_t size = static_cast<size_t>(params.width) * params.height * params.components * ((params.bitsPerSample + 7) / 8);
+    std::vector<uint8_t> expected(size);
+    Assert::IsTrue(JpegLsDecode(expected.data(), size, compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    // Every fragment is a separate allocation, with an empty fragment now and then.
+    std::vector<std::vector<uint8_t>> buffers;
+    std::vector<JlsFragment> fragments;
+    for (size_t i = 0; i < compressed.size(); i += fragmentSize)
+    {
+        buffers.emplace_back(compressed.begin() + i, compressed.begin() + std::min(i + fragmentSize, compressed.size()));
+        if (buffers.size() % 5 == 0)
+        {
+            fragments.push_back({ nullptr, 0 });
+        }
+    }
+    for (const auto& buffer : buffers)
+    {
+        fragments.push_back({ buffer.data(), buffer.size() });
+    }
+
+    JlsParameters fragmentParams{};
+    Assert::IsTrue(JpegLsReadHeaderFragments(fragments.data(), fragments.size(), &fragmentParams, nullptr) == ApiResult::OK);
+    Assert::IsTrue(fragmentParams.width == params.width && fragmentParams.height == params.height);
+
+    std::vector<uint8_t> decoded(size);
+    Assert::IsTrue(JpegLsDecodeFragments(decoded.data(), size, fragments.data(), fragments.size(), nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(decoded == expected);
+}
+
+
+void TestDecodeFragments()
+{
+    const size_t fragmentSizes[] = { 1, 3, 64, 65, 257, 4096, 65536 };
+    for (const auto fragmentSize : fragmentSizes)
+    {
+        TestDecodeFragments("test/lena8b.jls", fragmentSize);
+        TestDecodeFragments("test/conformance/T8C0E0.JLS", fragmentSize);
+        TestDecodeFragments("test/conformance/T8C2E3.JLS", fragmentSize);
+        TestDecodeFragments("test/conformance/T16E0.JLS", fragmentSize);
+    }
+}
+
+
+struct ChunkChain
+{
+    size_t chunkSize;
+    std::vector<std::vector<uint8_t>> chunks;
+};
+
+
+void* AllocateChunk(void* context, size_t* chunkLength)
+{
+    const auto chain = static_cast<ChunkChain*>(context);
+    chain->chunks.emplace_back(chain->chunkSize);
+    *chunkLength = chain->chunkSize;
+    return chain->chunks.back().data();
+}
+
+
+void TestEncodeToChunks(int bitsPerSample, int components, InterleaveMode interleaveMode)
+{
+    JlsParameters params{};
+    params.width = 97;
+    params.height = 61;
+    params.bitsPerSample = bitsPerSample;
+    params.components = components;
+    params.interleaveMode = interleaveMode;
+
+    // Noise is the worst case input: the encoded size must stay within the bound.
+    const size_t rawSize = static_cast<size_t>(params.width) * params.height * components * ((bitsPerSample + 7) / 8);
+    const std::vector<uint8_t> rawData = bitsPerSample > 8 ? MakeSomeNoise16bit(rawSize / 2, bitsPerSample, 21) : MakeSomeNoise(rawSize, bitsPerSample, 21);
+
+    size_t maximumSize = 0;
+    Assert::IsTrue(JpegLsGetMaximumEncodedSize(&params, &maximumSize, nullptr) == ApiResult::OK);
+
+    std::vector<uint8_t> expected(maximumSize);
+    size_t expectedLength = 0;
+    Assert::IsTrue(JpegLsEncode(expected.data(), expected.size(), &expectedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    Assert::IsTrue(expectedLength <= maximumSize);
+    expected.resize(expectedLength);
+
+    ChunkChain chain{ 1000, {} };
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsEncodeToChunks(AllocateChunk, &chain, &bytesWritten, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    Assert::IsTrue(bytesWritten == expectedLength);
+    Assert::IsTrue(chain.chunks.size() == (expectedLength + chain.chunkSize - 1) / chain.chunkSize);
+
+    std::vector<uint8_t> encoded;
+    for (const auto& chunk : chain.chunks)
+    {
+        encoded.insert(encoded.end(), chunk.begin(), chunk.end());
+    }
+    encoded.resize(bytesWritten);
+    Assert::IsTrue(encoded == expected);
+}
+
+
+void TestEncodeToChunks()
+{
+    TestEncodeToChunks(8, 1, InterleaveMode::None);
+    TestEncodeToChunks(2, 1, InterleaveMode::None);
+    TestEncodeToChunks(12, 1, InterleaveMode::None);
+    TestEncodeToChunks(16, 1, InterleaveMode::None);
+    TestEncodeToChunks(8, 3, InterleaveMode::None);
+    TestEncodeToChunks(8, 3, InterleaveMode::Line);
+    TestEncodeToChunks(8, 3, InterleaveMode::Sample);
+    TestEncodeToChunks(16, 4, InterleaveMode::Line);
+
+    // An allocator that stops providing chunks aborts the encoding.
+    JlsParameters params{};
+    params.width = 64;
+    params.height = 64;
+    params.bitsPerSample = 8;
+    params.components = 1;
+    const std::vector<uint8_t> rawData = MakeSomeNoise(64 * 64, 8, 3);
+    size_t bytesWritten = 0;
+    const auto error = JpegLsEncodeToChunks([](void*, size_t*) -> void* { return nullptr; }, nullptr, &bytesWritten, rawData.data(), rawData.size(), &params, nullptr);
+    Assert::IsTrue(error == ApiResult::CompressedBufferTooSmall);
+}
+
+
+std::vector<uint8_t> ReadCompleteFile(const char* path)
+{
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+
+void TestMappedFiles(const char* file)
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile(file, &compressed, &params))
+        return;
+
+    const size_t size = static_cast<size_t>(params.width) * params.height * params.components * ((params.bitsPerSample + 7) / 8);
+    std::vector<uint8_t> pixels(size);
+    Assert::IsTrue(JpegLsDecode(pixels.data(), size, compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    const char* rawPath = "charlstest_mapped.raw";
+    const char* encodedPath = "charlstest_mapped.jls";
+    const char* decodedPath = "charlstest_mapped_decoded.raw";
+    {
+        std::ofstream rawFile(rawPath, std::ios::binary);
+        rawFile.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(size));
+    }
+
+    params.stride = 0;
+    std::vector<uint8_t> expected(size * 2 + 1024);
+    size_t expectedLength = 0;
+    Assert::IsTrue(JpegLsEncode(expected.data(), expected.size(), &expectedLength, pixels.data(), size, &params, nullptr) == ApiResult::OK);
+    expected.resize(expectedLength);
+
+    // The encoded file is created with the worst case size and must be truncated to the encoded size.
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsEncodeFile(encodedPath, rawPath, &params, &bytesWritten, nullptr) == ApiResult::OK);
+    Assert::IsTrue(bytesWritten == expectedLength);
+    Assert::IsTrue(ReadCompleteFile(encodedPath) == expected);
+
+    Assert::IsTrue(JpegLsDecodeFile(decodedPath, encodedPath, nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(ReadCompleteFile(decodedPath) == pixels);
+
+    // A failed decode must leave an existing destination untouched and no temporary file behind.
+    {
+        std::ofstream truncatedFile(encodedPath, std::ios::binary | std::ios::trunc);
+        truncatedFile.write(reinterpret_cast<const char*>(expected.data()), static_cast<std::streamsize>(expected.size() / 2));
+    }
+    Assert::IsTrue(JpegLsDecodeFile(decodedPath, encodedPath, nullptr, nullptr) != ApiResult::OK);
+    Assert::IsTrue(ReadCompleteFile(decodedPath) == pixels);
+    Assert::IsTrue(!std::ifstream(std::string(decodedPath) + ".partial").good());
+
+    std::remove(rawPath);
+    std::remove(encodedPath);
+    std::remove(decodedPath);
+}
+
+
+void TestMappedFiles()
+{
+    TestMappedFiles("test/lena8b.jls");
+    TestMappedFiles("test/conformance/T8C0E0.JLS");
+    TestMappedFiles("test/conformance/T16E0.JLS");
+
+    Assert::IsTrue(JpegLsDecodeFile("charlstest_mapped.raw", "test/does_not_exist.jls", nullptr, nullptr) == ApiResult::UnspecifiedFailure);
+}
+
+
+struct MemoryStream
+{
+    std::vector<uint8_t> data;
+    size_t position;
+    size_t maximumReadCount;
+};
+
+
+size_t ReadMemoryStream(void* context, void* buffer, size_t count)
+{
+    const auto stream = static_cast<MemoryStream*>(context);
+    count = std::min(std::min(count, stream->maximumReadCount), stream->data.size() - stream->position);
+    std::copy(stream->data.begin() + stream->position, stream->data.begin() + stream->position + count, static_cast<uint8_t*>(buffer));
+    stream->position += count;
+    return count;
+}
+
+
+size_t WriteMemoryStream(void* context, const void* buffer, size_t count)
+{
+    const auto stream = static_cast<MemoryStream*>(context);
+    const auto bytes = static_cast<const uint8_t*>(buffer);
+    stream->data.insert(stream->data.end(), bytes, bytes + count);
+    return count;
+}
+
+
+void TestCallbackStream(const char* file, size_t blockSize)
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile(file, &compressed, &params))
+        return;
+
+    const size_t size = static_cast<size_t>(params.width) * params.height * params.components * ((params.bitsPerSample + 7) / 8);
+    std::vector<uint8_t> expected(size);
+    Assert::IsTrue(JpegLsDecode(expected.data(), size, compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    // Short reads and no skip function: the bytes read beyond a scan must be put back from the kept block.
+    MemoryStream source{ compressed, 0, 700 };
+    MemoryStream destination{ {}, 0, 0 };
+    const JlsStreamCallbacks sourceCallbacks{ &source, ReadMemoryStream, nullptr, nullptr, blockSize };
+    const JlsStreamCallbacks destinationCallbacks{ &destination, nullptr, WriteMemoryStream, nullptr, blockSize };
+
+    JlsParameters header{};
+    Assert::IsTrue(JpegLsReadHeaderCallbackStream(&sourceCallbacks, &header, nullptr) == ApiResult::OK);
+    Assert::IsTrue(header.width == params.width && header.height == params.height && header.components == params.components);
+
+    // Only the header up to and including the start of scan segment is consumed.
+    size_t startOfScan = 0;
+    while (compressed[startOfScan] != 0xFF || compressed[startOfScan + 1] != 0xDA)
+    {
+        ++startOfScan;
+    }
+    Assert::IsTrue(source.position == startOfScan + 2 + (compressed[startOfScan + 2] << 8) + compressed[startOfScan + 3]);
+
+    source.position = 0;
+    Assert::IsTrue(JpegLsDecodeCallbackStream(&destinationCallbacks, &sourceCallbacks, nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(destination.data == expected);
+
+    if (params.bitsPerSample > 8)
+        return;
+
+    params.stride = 0;
+    std::vector<uint8_t> encoded(size * 2 + 1024);
+    size_t encodedLength = 0;
+    Assert::IsTrue(JpegLsEncode(encoded.data(), encoded.size(), &encodedLength, expected.data(), size, &params, nullptr) == ApiResult::OK);
+    encoded.resize(encodedLength);
+
+    MemoryStream pixels{ expected, 0, size };
+    MemoryStream output{ {}, 0, 0 };
+    const JlsStreamCallbacks pixelCallbacks{ &pixels, ReadMemoryStream, nullptr, nullptr, blockSize };
+    const JlsStreamCallbacks outputCallbacks{ &output, nullptr, WriteMemoryStream, nullptr, blockSize };
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsEncodeCallbackStream(&outputCallbacks, &bytesWritten, &pixelCallbacks, &params, nullptr) == ApiResult::OK);
+    Assert::IsTrue(bytesWritten == encodedLength);
+    Assert::IsTrue(output.data == encoded);
+}
+
+
+void TestCallbackStream()
+{
+    TestCallbackStream("test/lena8b.jls", 1024);
+    TestCallbackStream("test/conformance/T8C0E0.JLS", 1024);
+    TestCallbackStream("test/conformance/T8C1E3.JLS", 1024);
+    TestCallbackStream("test/conformance/T16E3.JLS", 1024);
+    TestCallbackStream("test/conformance/T8C2E3.JLS", 0);
+
+    // A destination that fails to write aborts the decoding.
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/lena8b.jls", &compressed, &params))
+        return;
+
+    MemoryStream source{ compressed, 0, compressed.size() };
+    const JlsStreamCallbacks sourceCallbacks{ &source, ReadMemoryStream, nullptr, nullptr, 0 };
+    const JlsStreamCallbacks failingCallbacks{ nullptr, nullptr, [](void*, const void*, size_t) -> size_t { return 0; }, nullptr, 0 };
+    Assert::IsTrue(JpegLsDecodeCallbackStream(&failingCallbacks, &sourceCallbacks, nullptr, nullptr) == ApiResult::UnspecifiedFailure);
+
+    // A seek that cannot be done must leave the read position unchanged.
+    source.position = 0;
+    const JlsStreamCallbacks failingSkipCallbacks{ &source, ReadMemoryStream, nullptr, [](void*, long long) -> int { return -1; }, 0 };
+    CallbackStreamBuf stream(failingSkipCallbacks, 16);
+    for (int i = 0; i < 10; ++i)
+    {
+        stream.sbumpc();
+    }
+    const auto failed = std::streambuf::pos_type(std::streambuf::off_type(-1));
+    Assert::IsTrue(stream.pubseekoff(-11, std::ios_base::cur, std::ios_base::in) == failed);
+    Assert::IsTrue(stream.sgetc() == compressed[10]);
+    Assert::IsTrue(stream.pubseekoff(100, std::ios_base::cur, std::ios_base::in) == failed);
+    Assert::IsTrue(stream.sgetc() == compressed[10]);
+    Assert::IsTrue(stream.pubseekoff(-10, std::ios_base::cur, std::ios_base::in) != failed);
+    Assert::IsTrue(stream.sgetc() == compressed[0]);
+}
+
+
+void TestDecodeComponents(const std::vector<uint8_t>& compressed, const JlsParameters& params)
+{
+    const size_t planeSize = static_cast<size_t>(params.width) * params.height * ((params.bitsPerSample + 7) / 8);
+    std::vector<uint8_t> expected(planeSize * params.components);
+    Assert::IsTrue(JpegLsDecode(expected.data(), expected.size(), compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    for (unsigned int mask = 1; mask < 1u << params.components; ++mask)
+    {
+        std::vector<uint8_t> selected;
+        for (int component = 0; component < params.components; ++component)
+        {
+            if (mask & 1u << component)
+            {
+                selected.insert(selected.end(), expected.begin() + planeSize * component, expected.begin() + planeSize * (component + 1));
+            }
+        }
+
+        // The destination only needs to hold the selected components.
+        std::vector<uint8_t> decoded(selected.size());
+        Assert::IsTrue(JpegLsDecodeComponents(decoded.data(), decoded.size(), compressed.data(), compressed.size(), mask, nullptr, nullptr) == ApiResult::OK);
+        Assert::IsTrue(decoded == selected);
+    }
+}
+
+
+void TestDecodeComponents()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C0E0.JLS", &compressed, &params))
+        return;
+
+    TestDecodeComponents(compressed, params);
+
+    // Noise gives scans with many 0xFF bytes (followed by a stuffed bit).
+    params = JlsParameters();
+    params.width = 83;
+    params.height = 51;
+    params.bitsPerSample = 12;
+    params.components = 4;
+    const std::vector<uint8_t> rawData = MakeSomeNoise16bit(static_cast<size_t>(83) * 51 * 4, 12, 5);
+    compressed.resize(rawData.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    compressed.resize(compressedLength);
+    TestDecodeComponents(compressed, params);
+
+    std::vector<uint8_t> decoded(rawData.size());
+    Assert::IsTrue(JpegLsDecodeComponents(decoded.data(), decoded.size(), compressed.data(), compressed.size(), 0, nullptr, nullptr) == ApiResult::InvalidJlsParameters);
+    Assert::IsTrue(JpegLsDecodeComponents(decoded.data(), rawData.size() / 4 - 1, compressed.data(), compressed.size(), 2, nullptr, nullptr) == ApiResult::UncompressedBufferTooSmall);
+
+    // Components of an interleaved scan cannot be selected.
+    if (!ScanFile("test/conformance/T8C1E3.JLS", &compressed, &params))
+        return;
+    decoded.resize(static_cast<size_t>(params.width) * params.height * params.components);
+    Assert::IsTrue(JpegLsDecodeComponents(decoded.data(), decoded.size(), compressed.data(), compressed.size(), 7, nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(JpegLsDecodeComponents(decoded.data(), decoded.size(), compressed.data(), compressed.size(), 1, nullptr, nullptr) == ApiResult::ParameterValueNotSupported);
+}
+
+
+std::vector<JlsSegmentInfo> GetSegmentIndex(const std::vector<uint8_t>& compressed)
+{
+    size_t segmentCount = 0;
+    Assert::IsTrue(JpegLsGetSegmentIndex(compressed.data(), compressed.size(), nullptr, 0, &segmentCount, nullptr) == ApiResult::OK);
+
+    std::vector<JlsSegmentInfo> segments(segmentCount);
+    Assert::IsTrue(JpegLsGetSegmentIndex(compressed.data(), compressed.size(), segments.data(), segments.size(), &segmentCount, nullptr) == ApiResult::OK);
+    Assert::IsTrue(segmentCount == segments.size());
+
+    // The segments and the scan data must cover the complete byte stream.
+    size_t offset = 0;
+    for (const auto& segment : segments)
+    {
+        Assert::IsTrue(segment.offset == offset);
+        offset += segment.length + segment.scanDataLength;
+    }
+    Assert::IsTrue(offset == compressed.size());
+    Assert::IsTrue(segments.front().markerCode == 0xD8 && segments.back().markerCode == 0xD9);
+    return segments;
+}
+
+
+std::vector<JlsSegmentInfo> GetScans(const std::vector<JlsSegmentInfo>& segments)
+{
+    std::vector<JlsSegmentInfo> scans;
+    std::copy_if(segments.begin(), segments.end(), std::back_inserter(scans), [](const JlsSegmentInfo& segment) { return segment.markerCode == 0xDA; });
+    return scans;
+}
+
+
+void TestSegmentIndex()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C0E0.JLS", &compressed, &params))
+        return;
+
+    auto scans = GetScans(GetSegmentIndex(compressed));
+    Assert::IsTrue(scans.size() == 3);
+    for (const auto& scan : scans)
+    {
+        Assert::IsTrue(scan.componentCount == 1 && scan.allowedLossyError == 0 && scan.interleaveMode == InterleaveMode::None);
+        Assert::IsTrue(scan.scanDataLength > 0);
+    }
+
+    if (!ScanFile("test/conformance/T8C1E3.JLS", &compressed, &params))
+        return;
+
+    scans = GetScans(GetSegmentIndex(compressed));
+    Assert::IsTrue(scans.size() == 1);
+    Assert::IsTrue(scans[0].componentCount == 3 && scans[0].allowedLossyError == 3 && scans[0].interleaveMode == InterleaveMode::Line);
+
+    // Noise gives scan data with many 0xFF bytes (followed by a stuffed bit) that must not be taken as markers.
+    params = JlsParameters();
+    params.width = 211;
+    params.height = 97;
+    params.bitsPerSample = 8;
+    params.components = 3;
+    const std::vector<uint8_t> rawData = MakeSomeNoise(static_cast<size_t>(211) * 97 * 3, 8, 9);
+    compressed.resize(rawData.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    compressed.resize(compressedLength);
+    Assert::IsTrue(GetScans(GetSegmentIndex(compressed)).size() == 3);
+
+    // The segments that fit are returned, together with the total count.
+    JlsSegmentInfo firstSegments[2];
+    size_t segmentCount = 0;
+    Assert::IsTrue(JpegLsGetSegmentIndex(compressed.data(), compressed.size(), firstSegments, 2, &segmentCount, nullptr) == ApiResult::OK);
+    Assert::IsTrue(segmentCount > 2 && firstSegments[1].markerCode == 0xF7 && firstSegments[1].componentCount == 3);
+
+    Assert::IsTrue(JpegLsGetSegmentIndex(compressed.data(), compressed.size() - 1, nullptr, 0, &segmentCount, nullptr) == ApiResult::CompressedBufferTooSmall);
+}
+
+
+void TestMappingTable(int bitsPerSample, int entryWidth, int entryCount, int components, InterleaveMode interleaveMode)
+{
+    JlsParameters params{};
+    params.width = 73;
+    params.height = 45;
+    params.bitsPerSample = bitsPerSample;
+    params.components = components;
+    params.interleaveMode = interleaveMode;
+
+    const size_t sampleCount = static_cast<size_t>(params.width) * params.height * components;
+    const std::vector<uint8_t> indices = bitsPerSample > 8 ? MakeSomeNoise16bit(sampleCount, bitsPerSample, 7) : MakeSomeNoise(sampleCount, bitsPerSample, 7);
+
+    std::vector<uint8_t> entries(static_cast<size_t>(entryCount) * entryWidth);
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        entries[i] = static_cast<uint8_t>(i * 7 + i / 251);
+    }
+    const JlsMappingTable mappingTable{ 5, entryWidth, entryCount, entries.data() };
+
+    // The maximum size includes the segments of the table.
+    size_t maximumSize = 0;
+    Assert::IsTrue(JpegLsGetMaximumEncodedMappedSize(&params, &mappingTable, &maximumSize, nullptr) == ApiResult::OK);
+    std::vector<uint8_t> encoded(maximumSize);
+    size_t encodedLength = 0;
+    Assert::IsTrue(JpegLsEncodeMapped(encoded.data(), encoded.size(), &encodedLength, indices.data(), indices.size(), &params, &mappingTable, nullptr) == ApiResult::OK);
+    encoded.resize(encodedLength);
+
+    // The decoders that don't apply the table return the indices.
+    std::vector<uint8_t> decoded(indices.size());
+    Assert::IsTrue(JpegLsDecode(decoded.data(), decoded.size(), encoded.data(), encoded.size(), nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(decoded == indices);
+
+    JlsMappingTable readTable{};
+    std::vector<uint8_t> readEntries(entries.size());
+    Assert::IsTrue(JpegLsReadMappingTable(encoded.data(), encoded.size(), &readTable, nullptr, 0, nullptr) == ApiResult::OK);
+    Assert::IsTrue(readTable.tableId == 5 && readTable.entryWidth == entryWidth && readTable.entryCount == entryCount && !readTable.entries);
+    Assert::IsTrue(JpegLsReadMappingTable(encoded.data(), encoded.size(), &readTable, readEntries.data(), readEntries.size(), nullptr) == ApiResult::OK);
+    Assert::IsTrue(readEntries == entries);
+
+    std::vector<uint8_t> expected;
+    for (size_t i = 0; i < sampleCount; ++i)
+    {
+        const size_t index = bitsPerSample > 8 ? reinterpret_cast<const uint16_t*>(indices.data())[i] : indices[i];
+        expected.insert(expected.end(), entries.begin() + index * entryWidth, entries.begin() + (index + 1) * entryWidth);
+    }
+
+    std::vector<uint8_t> mapped(expected.size());
+    const auto result = JpegLsDecodeMapped(mapped.data(), mapped.size(), encoded.data(), encoded.size(), nullptr, nullptr);
+    if (interleaveMode != InterleaveMode::None && components > 1)
+    {
+        Assert::IsTrue(result == ApiResult::ParameterValueNotSupported);
+        return;
+    }
+    Assert::IsTrue(result == ApiResult::OK);
+    Assert::IsTrue(mapped == expected);
+
+    Assert::IsTrue(JpegLsDecodeMapped(mapped.data(), mapped.size() - 1, encoded.data(), encoded.size(), nullptr, nullptr) == ApiResult::UncompressedBufferTooSmall);
+}
+
+
+void TestMappingTable()
+{
+    TestMappingTable(8, 3, 256, 1, InterleaveMode::None);
+    TestMappingTable(4, 1, 16, 1, InterleaveMode::None);
+    TestMappingTable(8, 2, 256, 3, InterleaveMode::None);
+    TestMappingTable(8, 5, 256, 2, InterleaveMode::None);
+    TestMappingTable(8, 3, 256, 3, InterleaveMode::Line);
+
+    // A table that doesn't fit in 1 segment is continued in LSE type 3 segments.
+    TestMappingTable(12, 2, 40000, 1, InterleaveMode::None);
+
+    // Indices outside the table are invalid.
+    JlsParameters params{};
+    params.width = 16;
+    params.height = 16;
+    params.bitsPerSample = 8;
+    params.components = 1;
+    const std::vector<uint8_t> indices(256, 200);
+    const uint8_t entries[4]{};
+    const JlsMappingTable mappingTable{ 1, 1, 4, entries };
+    std::vector<uint8_t> encoded(1024);
+    size_t encodedLength = 0;
+    Assert::IsTrue(JpegLsEncodeMapped(encoded.data(), encoded.size(), &encodedLength, indices.data(), indices.size(), &params, &mappingTable, nullptr) == ApiResult::OK);
+    std::vector<uint8_t> mapped(256);
+    Assert::IsTrue(JpegLsDecodeMapped(mapped.data(), mapped.size(), encoded.data(), encodedLength, nullptr, nullptr) == ApiResult::InvalidCompressedData);
+}
+
+
+void TestOversizeImage(int width, int height, int components, InterleaveMode interleaveMode)
+{
+    JlsParameters params{};
+    params.width = width;
+    params.height = height;
+    params.bitsPerSample = 8;
+    params.components = components;
+    params.interleaveMode = interleaveMode;
+
+    const std::vector<uint8_t> rawData = MakeSomeNoise(static_cast<size_t>(width) * height * components, 6, 11);
+
+    size_t maximumSize = 0;
+    Assert::IsTrue(JpegLsGetMaximumEncodedSize(&params, &maximumSize, nullptr) == ApiResult::OK);
+    std::vector<uint8_t> encoded(maximumSize);
+    size_t encodedLength = 0;
+    Assert::IsTrue(JpegLsEncode(encoded.data(), encoded.size(), &encodedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    encoded.resize(encodedLength);
+
+    // The dimensions are stored in an LSE type 4 segment after the frame header.
+    size_t segmentCount = 0;
+    JlsSegmentInfo segments[3];
+    Assert::IsTrue(JpegLsGetSegmentIndex(encoded.data(), encoded.size(), segments, 3, &segmentCount, nullptr) == ApiResult::OK);
+    Assert::IsTrue(segments[1].markerCode == 0xF7 && segments[2].markerCode == 0xF8);
+    Assert::IsTrue(encoded[segments[2].offset + 4] == 4);
+
+    JlsParameters header{};
+    Assert::IsTrue(JpegLsReadHeader(encoded.data(), encoded.size(), &header, nullptr) == ApiResult::OK);
+    Assert::IsTrue(header.width == width && header.height == height);
+
+    std::vector<uint8_t> decoded(rawData.size());
+    Assert::IsTrue(JpegLsDecode(decoded.data(), decoded.size(), encoded.data(), encoded.size(), nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(decoded == rawData);
+}
+
+
+void TestOversizeImage()
+{
+    TestOversizeImage(70000, 3, 1, InterleaveMode::None);
+    TestOversizeImage(2, 70000, 3, InterleaveMode::Sample);
+    TestOversizeImage(65536, 16, 3, InterleaveMode::Line);
+    TestOversizeImage(20000000, 1, 1, InterleaveMode::None);
+}
+
+
+std::vector<uint8_t> Transcode(const std::vector<uint8_t>& compressed, const JlsParameters& params)
+{
+    std::vector<uint8_t> transcoded(compressed.size() * 2 + 1024);
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsTranscode(transcoded.data(), transcoded.size(), &bytesWritten, compressed.data(), compressed.size(), &params, nullptr) == ApiResult::OK);
+    transcoded.resize(bytesWritten);
+    return transcoded;
+}
+
+
+std::vector<uint8_t> DecodeTranscoded(const std::vector<uint8_t>& compressed, size_t byteCount, InterleaveMode interleaveMode)
+{
+    JlsParameters params{};
+    Assert::IsTrue(JpegLsReadHeader(compressed.data(), compressed.size(), &params, nullptr) == ApiResult::OK);
+    Assert::IsTrue(params.interleaveMode == interleaveMode);
+
+    std::vector<uint8_t> decoded(byteCount);
+    Assert::IsTrue(JpegLsDecode(decoded.data(), decoded.size(), compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+    return decoded;
+}
+
+
+// Converts pixel interleaved samples to planes (the layout of interleave mode None).
+std::vector<uint8_t> ToPlanes(const std::vector<uint8_t>& pixels, int components, size_t bytesPerSample)
+{
+    const size_t pixelCount = pixels.size() / components / bytesPerSample;
+    std::vector<uint8_t> planes(pixels.size());
+    for (size_t pixel = 0; pixel < pixelCount; ++pixel)
+    {
+        for (int component = 0; component < components; ++component)
+        {
+            std::copy_n(pixels.begin() + (pixel * components + component) * bytesPerSample, bytesPerSample,
+                planes.begin() + (component * pixelCount + pixel) * bytesPerSample);
+        }
+    }
+    return planes;
+}
+
+
+void TestTranscode()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C1E0.JLS", &compressed, &params))
+        return;
+
+    std::vector<uint8_t> expected(static_cast<size_t>(params.width) * params.height * params.components);
+    Assert::IsTrue(JpegLsDecode(expected.data(), expected.size(), compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    JlsParameters transcodeParams{};
+    transcodeParams.interleaveMode = InterleaveMode::Sample;
+    Assert::IsTrue(DecodeTranscoded(Transcode(compressed, transcodeParams), expected.size(), InterleaveMode::Sample) == expected);
+
+    transcodeParams.colorTransformation = ColorTransformation::HP1;
+    Assert::IsTrue(DecodeTranscoded(Transcode(compressed, transcodeParams), expected.size(), InterleaveMode::Sample) == expected);
+
+    // Interleaved to planes and back.
+    transcodeParams = JlsParameters();
+    transcodeParams.interleaveMode = InterleaveMode::None;
+    const std::vector<uint8_t> planar = Transcode(compressed, transcodeParams);
+    Assert::IsTrue(DecodeTranscoded(planar, expected.size(), InterleaveMode::None) == ToPlanes(expected, 3, 1));
+    transcodeParams.interleaveMode = InterleaveMode::Line;
+    Assert::IsTrue(DecodeTranscoded(Transcode(planar, transcodeParams), expected.size(), InterleaveMode::Line) == expected);
+
+    // Lossless to near-lossless.
+    transcodeParams.allowedLossyError = 3;
+    const std::vector<uint8_t> nearLossless = Transcode(compressed, transcodeParams);
+    Assert::IsTrue(nearLossless.size() < compressed.size());
+    const std::vector<uint8_t> decoded = DecodeTranscoded(nearLossless, expected.size(), InterleaveMode::Line);
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        Assert::IsTrue(std::abs(decoded[i] - expected[i]) <= 3);
+    }
+
+    // 16 bit samples.
+    params = JlsParameters();
+    params.width = 67;
+    params.height = 23;
+    params.bitsPerSample = 12;
+    params.components = 4;
+    params.interleaveMode = InterleaveMode::Line;
+    const std::vector<uint8_t> rawData = MakeSomeNoise16bit(static_cast<size_t>(67) * 23 * 4, 12, 7);
+    compressed.resize(rawData.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    compressed.resize(compressedLength);
+
+    transcodeParams = JlsParameters();
+    const std::vector<uint8_t> planar16 = Transcode(compressed, transcodeParams);
+    Assert::IsTrue(DecodeTranscoded(planar16, rawData.size(), InterleaveMode::None) == ToPlanes(rawData, 4, 2));
+    transcodeParams.interleaveMode = InterleaveMode::Line;
+    Assert::IsTrue(DecodeTranscoded(Transcode(planar16, transcodeParams), rawData.size(), InterleaveMode::Line) == rawData);
+
+    std::vector<uint8_t> transcoded(100);
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsTranscode(transcoded.data(), transcoded.size(), &bytesWritten, compressed.data(), compressed.size(), &transcodeParams, nullptr) == ApiResult::CompressedBufferTooSmall);
+}
+
+
+// Reference box filter for a decoded image in the output layout of JpegLsDecode.
+template<typename SAMPLE>
+std::vector<uint8_t> ReduceImage(const std::vector<uint8_t>& pixels, const JlsParameters& params, int scale)
+{
+    const int planeCount = params.interleaveMode == InterleaveMode::None ? params.components : 1;
+    const int componentsPerLine = params.components / planeCount;
+    const int reducedWidth = (params.width + scale - 1) / scale;
+    const int reducedHeight = (params.height + scale - 1) / scale;
+    const auto* samples = reinterpret_cast<const SAMPLE*>(pixels.data());
+
+    std::vector<uint8_t> reduced(static_cast<size_t>(reducedWidth) * reducedHeight * params.components * sizeof(SAMPLE));
+    auto* reducedSamples = reinterpret_cast<SAMPLE*>(reduced.data());
+    for (int plane = 0; plane < planeCount; ++plane)
+    {
+        for (int y = 0; y < reducedHeight; ++y)
+        {
+            for (int x = 0; x < reducedWidth; ++x)
+            {
+                for (int component = 0; component < componentsPerLine; ++component)
+                {
+                    uint32_t sum = 0;
+                    uint32_t count = 0;
+                    for (int i = y * scale; i < std::min((y + 1) * scale, params.height); ++i)
+                    {
+                        for (int j = x * scale; j < std::min((x + 1) * scale, params.width); ++j)
+                        {
+                            sum += samples[((static_cast<size_t>(plane) * params.height + i) * params.width + j) * componentsPerLine + component];
+                            ++count;
+                        }
+                    }
+                    *reducedSamples++ = static_cast<SAMPLE>((sum + count / 2) / count);
+                }
+            }
+        }
+    }
+    return reduced;
+}
+
+
+void TestDecodeReduced(const std::vector<uint8_t>& compressed, const std::vector<int>& scales, bool fullImage)
+{
+    JlsParameters params{};
+    Assert::IsTrue(JpegLsReadHeader(compressed.data(), compressed.size(), &params, nullptr) == ApiResult::OK);
+    const size_t bytesPerSample = (params.bitsPerSample + 7) / 8;
+    std::vector<uint8_t> expected(static_cast<size_t>(params.width) * params.height * params.components * bytesPerSample);
+    Assert::IsTrue(JpegLsDecode(expected.data(), expected.size(), compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    std::vector<std::vector<uint8_t>> reducedImages;
+    std::vector<JlsReducedImage> descriptions;
+    for (const int scale : scales)
+    {
+        reducedImages.push_back(bytesPerSample == 1 ? ReduceImage<uint8_t>(expected, params, scale) : ReduceImage<uint16_t>(expected, params, scale));
+    }
+    std::vector<std::vector<uint8_t>> decodedImages(reducedImages.size());
+    for (size_t i = 0; i < scales.size(); ++i)
+    {
+        decodedImages[i].resize(reducedImages[i].size());
+        descriptions.push_back({scales[i], decodedImages[i].data(), decodedImages[i].size()});
+    }
+
+    std::vector<uint8_t> decoded(fullImage ? expected.size() : 0);
+    Assert::IsTrue(JpegLsDecodeReduced(fullImage ? decoded.data() : nullptr, decoded.size(), compressed.data(), compressed.size(),
+        descriptions.data(), descriptions.size(), nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(!fullImage || decoded == expected);
+    Assert::IsTrue(decodedImages == reducedImages);
+
+    descriptions[0].destinationLength -= 1;
+    Assert::IsTrue(JpegLsDecodeReduced(nullptr, 0, compressed.data(), compressed.size(), descriptions.data(), descriptions.size(), nullptr, nullptr) == ApiResult::UncompressedBufferTooSmall);
+}
+
+
+void TestDecodeReduced()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C1E0.JLS", &compressed, &params))
+        return;
+    TestDecodeReduced(compressed, {2, 4, 8}, true);
+
+    if (!ScanFile("test/conformance/T8C0E0.JLS", &compressed, &params))
+        return;
+    TestDecodeReduced(compressed, {3, 1}, false);
+
+    params = JlsParameters();
+    params.width = 37;
+    params.height = 19;
+    params.bitsPerSample = 12;
+    params.components = 1;
+    const std::vector<uint8_t> rawData = MakeSomeNoise16bit(static_cast<size_t>(37) * 19, 12, 9);
+    compressed.resize(rawData.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    compressed.resize(compressedLength);
+    TestDecodeReduced(compressed, {4, 256}, true);
+}
+
+
+void TestDecodeTransformed()
+{
+    JlsParameters params{};
+    params.width = 41;
+    params.height = 17;
+    params.bitsPerSample = 12;
+    params.components = 1;
+    const std::vector<uint8_t> rawData = MakeSomeNoise16bit(static_cast<size_t>(41) * 17, 12, 11);
+    std::vector<uint8_t> compressed(rawData.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    compressed.resize(compressedLength);
+
+    std::vector<uint16_t> samples(rawData.size() / 2);
+    memcpy(samples.data(), rawData.data(), rawData.size());
+
+    // Window of 1000 values around 2000 to 8 bits.
+    JlsSampleTransform transform{};
+    transform.type = SampleTransform::Window;
+    transform.outputBitsPerSample = 8;
+    transform.windowCenter = 2000;
+    transform.windowWidth = 1000;
+    std::vector<uint8_t> decoded(samples.size());
+    Assert::IsTrue(JpegLsDecodeTransformed(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &transform, nullptr, nullptr) == ApiResult::OK);
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        const double expected = samples[i] <= 1500 ? 0 : samples[i] > 2499 ? 255 : ((samples[i] - 1999.5) / 999 + 0.5) * 255;
+        Assert::IsTrue(std::abs(decoded[i] - expected) <= 0.5);
+    }
+    Assert::IsTrue(JpegLsDecodeTransformed(decoded.data(), decoded.size() - 1, compressed.data(), compressed.size(), &transform, nullptr, nullptr) == ApiResult::UncompressedBufferTooSmall);
+
+    transform.type = SampleTransform::Shift;
+    transform.shift = 4;
+    Assert::IsTrue(JpegLsDecodeTransformed(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &transform, nullptr, nullptr) == ApiResult::OK);
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        Assert::IsTrue(decoded[i] == samples[i] >> 4);
+    }
+
+    // 10 bit output with a lookup table that is shorter than the sample range.
+    std::vector<uint16_t> table(3000);
+    for (size_t i = 0; i < table.size(); ++i)
+    {
+        table[i] = static_cast<uint16_t>(i / 3);
+    }
+    transform.type = SampleTransform::LookupTable;
+    transform.outputBitsPerSample = 10;
+    transform.lookupTable = table.data();
+    transform.lookupTableEntryCount = table.size();
+    std::vector<uint16_t> decoded16(samples.size());
+    Assert::IsTrue(JpegLsDecodeTransformed(decoded16.data(), decoded16.size() * 2, compressed.data(), compressed.size(), &transform, nullptr, nullptr) == ApiResult::OK);
+    for (size_t i = 0; i < samples.size(); ++i)
+    {
+        Assert::IsTrue(decoded16[i] == table[std::min<size_t>(samples[i], table.size() - 1)]);
+    }
+
+    // Interleaved 8 bit color image.
+    if (!ScanFile("test/conformance/T8C1E0.JLS", &compressed, &params))
+        return;
+    std::vector<uint8_t> expected(static_cast<size_t>(params.width) * params.height * params.components);
+    Assert::IsTrue(JpegLsDecode(expected.data(), expected.size(), compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+    transform = JlsSampleTransform();
+    transform.type = SampleTransform::Shift;
+    transform.outputBitsPerSample = 4;
+    transform.shift = 4;
+    decoded.resize(expected.size());
+    Assert::IsTrue(JpegLsDecodeTransformed(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &transform, nullptr, nullptr) == ApiResult::OK);
+    for (size_t i = 0; i < expected.size(); ++i)
+    {
+        Assert::IsTrue(decoded[i] == expected[i] >> 4);
+    }
+
+    transform.shift = 16;
+    Assert::IsTrue(JpegLsDecodeTransformed(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &transform, nullptr, nullptr) == ApiResult::InvalidJlsParameters);
+}
+
+
+// Returns the height of the destination of a pixel layout, the width of the image when it is rotated by 90 or 270 degrees.
+int GetLayoutHeight(const JlsParameters& params, const JlsPixelLayout& layout)
+{
+    return layout.orientation == Orientation::Rotate90 || layout.orientation == Orientation::Rotate270 ? params.width : params.height;
+}
+
+
+// Reference implementation: rearranges the output of JpegLsDecode to a pixel layout.
+template<typename SAMPLE>
+void ApplyPixelLayout(const std::vector<uint8_t>& pixels, const JlsParameters& params, const JlsPixelLayout& layout, std::vector<uint8_t>& destination)
+{
+    const auto* samples = reinterpret_cast<const SAMPLE*>(pixels.data());
+    const int height = GetLayoutHeight(params, layout);
+    for (int component = 0; component < params.components; ++component)
+    {
+        for (int y = 0; y < params.height; ++y)
+        {
+            for (int x = 0; x < params.width; ++x)
+            {
+                const SAMPLE sample = params.interleaveMode == InterleaveMode::None ?
+                    samples[(static_cast<size_t>(component) * params.height + y) * params.width + x] :
+                    samples[(static_cast<size_t>(y) * params.width + x) * params.components + component];
+
+                size_t row = y;
+                size_t column = x;
+                switch (layout.orientation)
+                {
+                case Orientation::Normal: break;
+                case Orientation::FlipVertical: row = params.height - 1 - y; break;
+                case Orientation::MirrorHorizontal: column = params.width - 1 - x; break;
+                case Orientation::Rotate180: row = params.height - 1 - y; column = params.width - 1 - x; break;
+                case Orientation::Rotate90: row = x; column = params.height - 1 - y; break;
+                case Orientation::Rotate270: row = params.width - 1 - x; column = y; break;
+                }
+
+                const size_t offset = layout.interleaved ?
+                    row * layout.stride + (column * layout.channelCount + layout.componentChannels[component]) * sizeof(SAMPLE) :
+                    (static_cast<size_t>(layout.componentChannels[component]) * height + row) * layout.stride + column * sizeof(SAMPLE);
+                memcpy(destination.data() + offset, &sample, sizeof(SAMPLE));
+                for (int channel = params.components; layout.interleaved && component == 0 && channel < layout.channelCount; ++channel)
+                {
+                    const auto padding = static_cast<SAMPLE>(layout.paddingValue);
+                    memcpy(destination.data() + row * layout.stride + (column * layout.channelCount + channel) * sizeof(SAMPLE), &padding, sizeof(SAMPLE));
+                }
+            }
+        }
+    }
+}
+
+
+void TestDecodeLayout(const std::vector<uint8_t>& compressed, const JlsPixelLayout& layout)
+{
+    JlsParameters params{};
+    Assert::IsTrue(JpegLsReadHeader(compressed.data(), compressed.size(), &params, nullptr) == ApiResult::OK);
+    const size_t bytesPerSample = (params.bitsPerSample + 7) / 8;
+    std::vector<uint8_t> pixels(static_cast<size_t>(params.width) * params.height * params.components * bytesPerSample);
+    Assert::IsTrue(JpegLsDecode(pixels.data(), pixels.size(), compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    // The bytes after the pixels of a line must not be changed.
+    const size_t size = layout.stride * GetLayoutHeight(params, layout) * (layout.interleaved ? 1 : params.components);
+    std::vector<uint8_t> expected(size, 0x5A);
+    if (bytesPerSample == 1)
+    {
+        ApplyPixelLayout<uint8_t>(pixels, params, layout, expected);
+    }
+    else
+    {
+        ApplyPixelLayout<uint16_t>(pixels, params, layout, expected);
+    }
+
+    std::vector<uint8_t> decoded(size, 0x5A);
+    Assert::IsTrue(JpegLsDecodeLayout(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &layout, nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(decoded == expected);
+    Assert::IsTrue(JpegLsDecodeLayout(decoded.data(), decoded.size() - 1, compressed.data(), compressed.size(), &layout, nullptr, nullptr) == ApiResult::UncompressedBufferTooSmall);
+}
+
+
+void TestDecodeLayout()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C0E0.JLS", &compressed, &params))
+        return;
+
+    // Interleave mode None to BGRX with padding at the end of the lines.
+    JlsPixelLayout layout{};
+    layout.interleaved = 1;
+    layout.channelCount = 4;
+    layout.componentChannels[0] = 2;
+    layout.componentChannels[1] = 1;
+    layout.componentChannels[2] = 0;
+    layout.paddingValue = 255;
+    layout.stride = static_cast<size_t>(params.width) * 4 + 8;
+    TestDecodeLayout(compressed, layout);
+
+    layout.componentChannels[2] = 1;
+    std::vector<uint8_t> decoded(layout.stride * params.height);
+    Assert::IsTrue(JpegLsDecodeLayout(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &layout, nullptr, nullptr) == ApiResult::InvalidJlsParameters);
+
+    // Interleave mode Line to planes in another order.
+    if (!ScanFile("test/conformance/T8C1E0.JLS", &compressed, &params))
+        return;
+    layout = JlsPixelLayout();
+    layout.componentChannels[0] = 2;
+    layout.componentChannels[1] = 0;
+    layout.componentChannels[2] = 1;
+    layout.stride = params.width;
+    TestDecodeLayout(compressed, layout);
+
+    // Interleave mode Sample to RGBA.
+    if (!ScanFile("test/conformance/T8C2E0.JLS", &compressed, &params))
+        return;
+    layout = JlsPixelLayout();
+    layout.interleaved = 1;
+    layout.channelCount = 4;
+    layout.componentChannels[0] = 0;
+    layout.componentChannels[1] = 1;
+    layout.componentChannels[2] = 2;
+    layout.paddingValue = 128;
+    layout.stride = static_cast<size_t>(params.width) * 4;
+    TestDecodeLayout(compressed, layout);
+
+    // 16 bit samples with 4 components in interleave mode None, the image is higher than a band.
+    params = JlsParameters();
+    params.width = 29;
+    params.height = 700;
+    params.bitsPerSample = 12;
+    params.components = 4;
+    const std::vector<uint8_t> rawData = MakeSomeNoise16bit(static_cast<size_t>(29) * 700 * 4, 12, 13);
+    compressed.resize(rawData.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    compressed.resize(compressedLength);
+    layout = JlsPixelLayout();
+    layout.interleaved = 1;
+    layout.channelCount = 4;
+    layout.componentChannels[0] = 3;
+    layout.componentChannels[1] = 2;
+    layout.componentChannels[2] = 1;
+    layout.componentChannels[3] = 0;
+    layout.stride = static_cast<size_t>(params.width) * 8;
+    TestDecodeLayout(compressed, layout);
+}
+
+
+void TestDecodeOriented()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C0E0.JLS", &compressed, &params))
         return;
 
-    std::vector<uint8_t> rgbyteOut(512 * 511);
-    const auto error = JpegLsDecode(&rgbyteOut[0], rgbyteOut.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), nullptr, nullptr);
+    for (const Orientation orientation : {Orientation::Normal, Orientation::FlipVertical, Orientation::MirrorHorizontal,
+        Orientation::Rotate180, Orientation::Rotate90, Orientation::Rotate270})
+    {
+        const bool rotated = orientation == Orientation::Rotate90 || orientation == Orientation::Rotate270;
+
+        // Interleave mode None to BGRX (decoded in bands), a line of the destination holds a column of the image when rotated.
+        JlsPixelLayout layout{};
+        layout.interleaved = 1;
+        layout.channelCount = 4;
+        layout.componentChannels[0] = 2;
+        layout.componentChannels[1] = 1;
+        layout.componentChannels[2] = 0;
+        layout.paddingValue = 255;
+        layout.stride = static_cast<size_t>(rotated ? params.height : params.width) * 4 + 8;
+        layout.orientation = orientation;
+        TestDecodeLayout(compressed, layout);
+
+        // Planes, without padding at the end of the lines.
+        layout = JlsPixelLayout();
+        layout.componentChannels[1] = 1;
+        layout.componentChannels[2] = 2;
+        layout.orientation = orientation;
+        layout.stride = rotated ? params.height : params.width;
+        TestDecodeLayout(compressed, layout);
+    }
 
-    Assert::IsTrue(error == ApiResult::UncompressedBufferTooSmall);
+    // 16 bit samples in interleave mode Sample, with an image that is not square.
+    params = JlsParameters();
+    params.width = 37;
+    params.height = 21;
+    params.bitsPerSample = 12;
+    params.components = 3;
+    params.interleaveMode = InterleaveMode::Sample;
+    const std::vector<uint8_t> rawData = MakeSomeNoise16bit(static_cast<size_t>(37) * 21 * 3, 12, 14);
+    compressed.resize(rawData.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, rawData.data(), rawData.size(), &params, nullptr) == ApiResult::OK);
+    compressed.resize(compressedLength);
+
+    JlsPixelLayout layout{};
+    layout.interleaved = 1;
+    layout.channelCount = 3;
+    layout.componentChannels[1] = 1;
+    layout.componentChannels[2] = 2;
+    for (const Orientation orientation : {Orientation::FlipVertical, Orientation::Rotate180, Orientation::Rotate90, Orientation::Rotate270})
+    {
+        const bool rotated = orientation == Orientation::Rotate90 || orientation == Orientation::Rotate270;
+        layout.orientation = orientation;
+        layout.stride = static_cast<size_t>(rotated ? params.height : params.width) * 6;
+        TestDecodeLayout(compressed, layout);
+    }
+
+    layout.orientation = static_cast<Orientation>(6);
+    std::vector<uint8_t> decoded(rawData.size());
+    Assert::IsTrue(JpegLsDecodeLayout(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &layout, nullptr, nullptr) == ApiResult::InvalidJlsParameters);
 }
 
 
-////void TestBadImage()
-////{
-////    std::vector<uint8_t> rgbyteCompressed;
-////    if (!ReadFile("test/BadCompressedStream.jls", &rgbyteCompressed, 0))
-////        return;
-////
-////    std::vector<uint8_t> rgbyteOut(2500 * 3000 * 2);
-////    auto error = JpegLsDecode(&rgbyteOut[0], rgbyteOut.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), nullptr, nullptr);
-////
-////    Assert::IsTrue(error == ApiResult::UncompressedBufferTooSmall);
-////}
+// Encodes the pixels of a pixel layout (in every interleave mode) and checks that they are decoded to the same layout.
+void TestEncodeLayout(const std::vector<uint8_t>& pixels, const JlsPixelLayout& pixelLayout, JlsParameters params)
+{
+    JlsSourceLayout layout{};
+    layout.interleaved = pixelLayout.interleaved;
+    layout.channelCount = pixelLayout.channelCount;
+    for (int component = 0; component < params.components; ++component)
+    {
+        layout.componentChannels[component] = pixelLayout.componentChannels[component];
+        const size_t planeOffset = pixelLayout.interleaved ? 0 : pixelLayout.stride * params.height * pixelLayout.componentChannels[component];
+        layout.planes[component] = pixels.data() + planeOffset;
+        layout.strides[component] = pixelLayout.stride;
+    }
 
+    for (const InterleaveMode interleaveMode : {InterleaveMode::None, InterleaveMode::Line, InterleaveMode::Sample})
+    {
+        if (interleaveMode == InterleaveMode::Sample && params.components == 4)
+            continue;
 
-void TestDecodeBitStreamWithNoMarkerStart()
+        params.interleaveMode = interleaveMode;
+        std::vector<uint8_t> compressed(pixels.size() * 2 + 1024);
+        size_t bytesWritten = 0;
+        Assert::IsTrue(JpegLsEncodeLayout(compressed.data(), compressed.size(), &bytesWritten, &layout, &params, nullptr) == ApiResult::OK);
+        compressed.resize(bytesWritten);
+
+        std::vector<uint8_t> decoded(pixels.size(), 0x5A);
+        Assert::IsTrue(JpegLsDecodeLayout(decoded.data(), decoded.size(), compressed.data(), compressed.size(), &pixelLayout, nullptr, nullptr) == ApiResult::OK);
+        Assert::IsTrue(decoded == pixels);
+    }
+}
+
+
+// Converts native samples to a source format, every line of the source starts at a byte boundary.
+std::vector<uint8_t> ToSourceFormat(const std::vector<uint8_t>& rawData, const JlsParameters& params, SourceFormat format)
 {
-    const uint8_t encodedData[2] = { 0x33, 0x33 };
-    uint8_t output[1000];
+    const int bytesPerSample = params.bitsPerSample <= 8 ? 1 : 2;
+    const size_t samplesPerLine = static_cast<size_t>(params.width) * (params.interleaveMode == InterleaveMode::None ? 1 : params.components);
+    const size_t lineCount = rawData.size() / bytesPerSample / samplesPerLine;
 
-    const auto error = JpegLsDecode(output, 1000, encodedData, 2, nullptr, nullptr);
-    Assert::IsTrue(error == ApiResult::MissingJpegMarkerStart);
+    std::vector<uint8_t> source;
+    for (size_t line = 0; line < lineCount; ++line)
+    {
+        uint32_t bits = 0;
+        int bitCount = 0;
+        for (size_t i = 0; i < samplesPerLine; ++i)
+        {
+            const size_t index = line * samplesPerLine + i;
+            const uint32_t sample = bytesPerSample == 1 ? rawData[index] : static_cast<uint32_t>(rawData[2 * index] | rawData[2 * index + 1] << 8);
+            switch (format)
+            {
+            case SourceFormat::BigEndian16:
+                source.push_back(static_cast<uint8_t>(sample >> 8));
+                source.push_back(static_cast<uint8_t>(sample));
+                break;
+
+            case SourceFormat::MsbAligned16:
+            case SourceFormat::MsbAlignedBigEndian16:
+            {
+                const uint32_t aligned = sample << (16 - params.bitsPerSample);
+                source.push_back(static_cast<uint8_t>(format == SourceFormat::MsbAligned16 ? aligned : aligned >> 8));
+                source.push_back(static_cast<uint8_t>(format == SourceFormat::MsbAligned16 ? aligned >> 8 : aligned));
+                break;
+            }
+
+            default:
+                bits |= sample << bitCount;
+                bitCount += params.bitsPerSample;
+                for (; bitCount >= 8; bitCount -= 8, bits >>= 8)
+                {
+                    source.push_back(static_cast<uint8_t>(bits));
+                }
+                break;
+            }
+        }
+
+        if (bitCount > 0)
+        {
+            source.push_back(static_cast<uint8_t>(bits));
+        }
+    }
+
+    return source;
 }
 
 
-void TestDecodeBitStreamWithUnsupportedEncoding()
+// Encodes the samples from a source format and checks that the native samples are decoded.
+void TestEncodeFormat(const std::vector<uint8_t>& rawData, JlsParameters params, SourceFormat format)
 {
-    const uint8_t encodedData[6] = { 0xFF, 0xD8, // Start Of Image (JPEG_SOI)
-                            0xFF, 0xC3, // Start Of Frame (lossless, Huffman) (JPEG_SOF_3)
-                            0x00, 0x00  // Length of data of the marker
-                          };
-    uint8_t output[1000];
+    const std::vector<uint8_t> source = ToSourceFormat(rawData, params, format);
 
-    const auto error = JpegLsDecode(output, 1000, encodedData, 6, nullptr, nullptr);
-    Assert::IsTrue(error == ApiResult::UnsupportedEncoding);
+    std::vector<uint8_t> compressed(rawData.size() * 2 + 1024);
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsEncodeFormat(compressed.data(), compressed.size(), &bytesWritten, source.data(), source.size(), format, &params, nullptr) == ApiResult::OK);
+
+    std::vector<uint8_t> decoded(rawData.size());
+    Assert::IsTrue(JpegLsDecode(decoded.data(), decoded.size(), compressed.data(), bytesWritten, nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(decoded == rawData);
+
+    // A source that is 1 byte too small is rejected.
+    Assert::IsTrue(JpegLsEncodeFormat(compressed.data(), compressed.size(), &bytesWritten, source.data(), source.size() - 1, format, &params, nullptr) == ApiResult::UncompressedBufferTooSmall);
 }
 
 
-void TestDecodeBitStreamWithUnknownJpegMarker()
+void TestEncodeFormat()
 {
-    const uint8_t encodedData[6] = { 0xFF, 0xD8, // Start Of Image (JPEG_SOI)
-        0xFF, 0x01, // Undefined marker
-        0x00, 0x00  // Length of data of the marker
-    };
-    uint8_t output[1000];
+    JlsParameters params{};
+    params.width = 31;
+    params.height = 19;
+    params.bitsPerSample = 12;
+    params.components = 1;
+    const std::vector<uint8_t> rawData12 = MakeSomeNoise16bit(static_cast<size_t>(31) * 19, 12, 27);
+    for (const SourceFormat format : {SourceFormat::BigEndian16, SourceFormat::MsbAligned16, SourceFormat::MsbAlignedBigEndian16, SourceFormat::PackedLsb})
+    {
+        TestEncodeFormat(rawData12, params, format);
+    }
 
-    const auto error = JpegLsDecode(output, 1000, encodedData, 6, nullptr, nullptr);
-    Assert::IsTrue(error == ApiResult::UnknownJpegMarker);
+    // Mono10p with a width that leaves a partial group of 4 samples.
+    params.width = 33;
+    params.bitsPerSample = 10;
+    TestEncodeFormat(MakeSomeNoise16bit(static_cast<size_t>(33) * 19, 10, 28), params, SourceFormat::PackedLsb);
+
+    // Packed samples of 5 bits in an interleaved image.
+    params.width = 27;
+    params.bitsPerSample = 5;
+    params.components = 3;
+    params.interleaveMode = InterleaveMode::Sample;
+    TestEncodeFormat(MakeSomeNoise(static_cast<size_t>(27) * 19 * 3, 5, 29), params, SourceFormat::PackedLsb);
+
+    // 3 components in interleave mode None, each plane in big endian order.
+    params.width = 20;
+    params.bitsPerSample = 16;
+    params.interleaveMode = InterleaveMode::None;
+    TestEncodeFormat(MakeSomeNoise16bit(static_cast<size_t>(20) * 19 * 3, 12, 30), params, SourceFormat::BigEndian16);
+
+    // A 16 bit source format needs samples of more than 8 bits.
+    params.bitsPerSample = 8;
+    std::vector<uint8_t> buffer(static_cast<size_t>(20) * 19 * 3 * 4);
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsEncodeFormat(buffer.data(), buffer.size(), &bytesWritten, buffer.data(), buffer.size(), SourceFormat::BigEndian16, &params, nullptr) == ApiResult::InvalidJlsParameters);
 }
 
 
-void TestDecodeRect()
+void TestEncodeLayout()
 {
-    std::vector<uint8_t> rgbyteCompressed;
+    std::vector<uint8_t> compressed;
     JlsParameters params{};
-    if (!ScanFile("test/lena8b.jls", &rgbyteCompressed, &params))
+    if (!ScanFile("test/conformance/T8C0E0.JLS", &compressed, &params))
         return;
+    std::vector<uint8_t> pixels(static_cast<size_t>(params.width) * params.height * params.components);
+    Assert::IsTrue(JpegLsDecode(pixels.data(), pixels.size(), compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    // BGRX pixels with padding at the end of the lines.
+    JlsPixelLayout pixelLayout{};
+    pixelLayout.interleaved = 1;
+    pixelLayout.channelCount = 4;
+    pixelLayout.componentChannels[0] = 2;
+    pixelLayout.componentChannels[1] = 1;
+    pixelLayout.componentChannels[2] = 0;
+    pixelLayout.paddingValue = 255;
+    pixelLayout.stride = static_cast<size_t>(params.width) * 4 + 8;
+    std::vector<uint8_t> bgrx(pixelLayout.stride * params.height, 0x5A);
+    ApplyPixelLayout<uint8_t>(pixels, params, pixelLayout, bgrx);
+    TestEncodeLayout(bgrx, pixelLayout, params);
+
+    // Planes in another order, with padding.
+    pixelLayout = JlsPixelLayout();
+    pixelLayout.componentChannels[0] = 1;
+    pixelLayout.componentChannels[1] = 2;
+    pixelLayout.componentChannels[2] = 0;
+    pixelLayout.stride = static_cast<size_t>(params.width) + 3;
+    std::vector<uint8_t> planes(pixelLayout.stride * params.height * 3, 0x5A);
+    ApplyPixelLayout<uint8_t>(pixels, params, pixelLayout, planes);
+    TestEncodeLayout(planes, pixelLayout, params);
+
+    // 16 bit samples with 4 components.
+    params = JlsParameters();
+    params.width = 31;
+    params.height = 43;
+    params.bitsPerSample = 12;
+    params.components = 4;
+    const std::vector<uint8_t> rawData = MakeSomeNoise16bit(static_cast<size_t>(31) * 43 * 4, 12, 17);
+    pixelLayout = JlsPixelLayout();
+    pixelLayout.interleaved = 1;
+    pixelLayout.channelCount = 4;
+    pixelLayout.componentChannels[0] = 3;
+    pixelLayout.componentChannels[1] = 0;
+    pixelLayout.componentChannels[2] = 2;
+    pixelLayout.componentChannels[3] = 1;
+    pixelLayout.stride = static_cast<size_t>(params.width) * 8;
+    std::vector<uint8_t> interleaved(rawData.size());
+    params.interleaveMode = InterleaveMode::None;
+    ApplyPixelLayout<uint16_t>(rawData, params, pixelLayout, interleaved);
+    TestEncodeLayout(interleaved, pixelLayout, params);
+
+    JlsSourceLayout layout{};
+    layout.interleaved = 1;
+    layout.channelCount = 3;
+    layout.planes[0] = interleaved.data();
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsEncodeLayout(compressed.data(), compressed.size(), &bytesWritten, &layout, &params, nullptr) == ApiResult::InvalidJlsParameters);
+}
 
-    std::vector<uint8_t> rgbyteOutFull(static_cast<size_t>(params.width) * params.height*params.components);
-    auto error = JpegLsDecode(&rgbyteOutFull[0], rgbyteOutFull.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), nullptr, nullptr);
-    Assert::IsTrue(error == ApiResult::OK);
 
-    const JlsRect rect = { 128, 128, 256, 1 };
-    std::vector<uint8_t> rgbyteOut(static_cast<size_t>(rect.Width) * rect.Height);
-    rgbyteOut.push_back(0x1f);
-    error = JpegLsDecodeRect(&rgbyteOut[0], rgbyteOut.size(), &rgbyteCompressed[0], rgbyteCompressed.size(), rect, nullptr, nullptr);
-    Assert::IsTrue(error == ApiResult::OK);
+struct CountingExecutor
+{
+    const JlsExecutor* inner;
+    std::atomic<int> submitCount;
+};
 
-    Assert::IsTrue(memcmp(&rgbyteOutFull[rect.X + static_cast<size_t>(rect.Y) * 512], &rgbyteOut[0], static_cast<size_t>(rect.Width) * rect.Height) == 0);
-    Assert::IsTrue(rgbyteOut[static_cast<size_t>(rect.Width) * rect.Height] == 0x1f);
+
+void* CountingCreateGroup(void* context)
+{
+    const auto executor = static_cast<CountingExecutor*>(context)->inner;
+    return executor->createGroup(executor->context);
+}
+
+
+void CountingSubmit(void* context, void* group, JlsTaskFunction task, void* taskContext)
+{
+    const auto counting = static_cast<CountingExecutor*>(context);
+    ++counting->submitCount;
+    counting->inner->submit(counting->inner->context, group, task, taskContext);
+}
+
+
+void CountingWait(void* context, void* group)
+{
+    const auto executor = static_cast<CountingExecutor*>(context)->inner;
+    executor->wait(executor->context, group);
+}
+
+
+void TestExecutor()
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile("test/conformance/T8C1E3.JLS", &compressed, &params))
+        return;
+
+    const size_t size = static_cast<size_t>(params.width) * params.height * params.components;
+    std::vector<uint8_t> expected(size);
+    Assert::IsTrue(JpegLsDecode(expected.data(), size, compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    const size_t jobCount = 6;
+    std::vector<std::vector<uint8_t>> decoded(jobCount, std::vector<uint8_t>(size));
+    std::vector<JlsDecodeJob> jobs(jobCount);
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        jobs[i] = { compressed.data(), compressed.size(), decoded[i].data(), size, nullptr, ApiResult::UnexpectedFailure };
+    }
+
+    // The serial executor runs all jobs on the calling thread: the batch is completed when the function returns.
+    int completedCount = 0;
+    JlsBatch* batch = JpegLsDecodeBatchAsync(jobs.data(), jobs.size(), 2, JpegLsGetSerialExecutor(), CountCompletedBatch, &completedCount);
+    Assert::IsTrue(completedCount == 1);
+    JpegLsBatchDestroy(batch);
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        Assert::IsTrue(jobs[i].result == ApiResult::OK);
+        Assert::IsTrue(decoded[i] == expected);
+        jobs[i].result = ApiResult::UnexpectedFailure;
+    }
+
+    // An application executor registered globally is used when NULL is passed.
+    JlsExecutor* threadExecutor = JpegLsCreateThreadExecutor(2);
+    Assert::IsTrue(threadExecutor != nullptr);
+    CountingExecutor counting;
+    counting.inner = threadExecutor;
+    counting.submitCount = 0;
+    const JlsExecutor countingExecutor{ &counting, CountingCreateGroup, CountingSubmit, CountingWait };
+
+    JpegLsSetExecutor(&countingExecutor);
+    batch = JpegLsDecodeBatchAsync(jobs.data(), jobs.size(), 3, nullptr, CountCompletedBatch, &completedCount);
+    JpegLsBatchDestroy(batch);
+    JpegLsSetExecutor(nullptr);
+    JpegLsDestroyThreadExecutor(threadExecutor);
+
+    Assert::IsTrue(completedCount == 2);
+    Assert::IsTrue(counting.submitCount == 3);
+    for (size_t i = 0; i < jobCount; ++i)
+    {
+        Assert::IsTrue(jobs[i].result == ApiResult::OK);
+        Assert::IsTrue(decoded[i] == expected);
+    }
+}
+
+
+// Executor that runs every task on a thread of its own, which has started before submit returns: a pipelined task is
+// running before the codec has filled the ring.
+void* ThreadPerTaskCreateGroup(void* /*context*/)
+{
+    return new std::vector<std::thread>();
+}
+
+
+void ThreadPerTaskSubmit(void* /*context*/, void* group, JlsTaskFunction task, void* taskContext)
+{
+    std::atomic<bool> started(false);
+    static_cast<std::vector<std::thread>*>(group)->emplace_back([&started, task, taskContext]
+    {
+        started = true;
+        task(taskContext);
+    });
+
+    while (!started)
+    {
+        std::this_thread::yield();
+    }
+}
+
+
+void ThreadPerTaskWait(void* /*context*/, void* group)
+{
+    const auto threads = static_cast<std::vector<std::thread>*>(group);
+    for (auto& thread : *threads)
+    {
+        thread.join();
+    }
+    delete threads;
+}
+
+
+// Stream that accepts or provides a number of bytes and then fails, it records the thread of the failed write or read.
+class FailingStreamBuf : public std::streambuf
+{
+public:
+    explicit FailingStreamBuf(std::streamsize byteCount) :
+        _remaining(byteCount)
+    {
+    }
+
+    std::thread::id GetFailedThread() const
+    {
+        return _failedThread;
+    }
+
+protected:
+    std::streamsize xsputn(const char* /*s*/, std::streamsize count) override
+    {
+        if (count > _remaining)
+        {
+            _failedThread = std::this_thread::get_id();
+            return 0;
+        }
+
+        _remaining -= count;
+        return count;
+    }
+
+    std::streamsize xsgetn(char* s, std::streamsize count) override
+    {
+        if (count > _remaining)
+        {
+            _failedThread = std::this_thread::get_id();
+            return 0;
+        }
+
+        std::fill(s, s + count, '\0');
+        _remaining -= count;
+        return count;
+    }
+
+private:
+    std::streamsize _remaining;
+    std::thread::id _failedThread;
+};
+
+
+// The lines are post-processed by a task of the executor while the next lines are decoded: the result must be the same
+// as JpegLsDecode, also when the executor runs the task on the decoding thread (serial executor).
+void TestDecodePipelined()
+{
+    JlsExecutor* threadExecutor = JpegLsCreateThreadExecutor(1);
+    Assert::IsTrue(threadExecutor != nullptr);
+
+    struct
+    {
+        int bitsPerSample;
+        int components;
+        InterleaveMode interleaveMode;
+        ColorTransformation colorTransformation;
+    } const images[] = {
+        { 12, 3, InterleaveMode::Line, ColorTransformation::HP1 },
+        { 8, 3, InterleaveMode::Sample, ColorTransformation::HP2 },
+        { 8, 1, InterleaveMode::None, ColorTransformation::None },
+        { 8, 4, InterleaveMode::Line, ColorTransformation::None } };
+
+    for (const auto& image : images)
+    {
+        JlsParameters params{};
+        params.width = 211;
+        params.height = 97;
+        params.bitsPerSample = image.bitsPerSample;
+        params.components = image.components;
+        params.interleaveMode = image.interleaveMode;
+        params.colorTransformation = image.colorTransformation;
+        const size_t sampleCount = static_cast<size_t>(params.width) * params.height * params.components;
+        const std::vector<uint8_t> pixels = params.bitsPerSample == 8 ? MakeSomeNoise(sampleCount, 8, 7) : MakeSomeNoise16bit(sampleCount, 12, 7);
+
+        std::vector<uint8_t> compressed(pixels.size() * 2 + 1024);
+        size_t compressedLength = 0;
+        Assert::IsTrue(JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, pixels.data(), pixels.size(), &params, nullptr) == ApiResult::OK);
+
+        std::vector<uint8_t> expected(pixels.size());
+        Assert::IsTrue(JpegLsDecode(expected.data(), expected.size(), compressed.data(), compressedLength, nullptr, nullptr) == ApiResult::OK);
+
+        for (const JlsExecutor* executor : { static_cast<const JlsExecutor*>(nullptr), JpegLsGetSerialExecutor(), static_cast<const JlsExecutor*>(threadExecutor) })
+        {
+            std::vector<uint8_t> decoded(pixels.size());
+            Assert::IsTrue(JpegLsDecodePipelined(decoded.data(), decoded.size(), compressed.data(), compressedLength, nullptr, executor, nullptr) == ApiResult::OK);
+            Assert::IsTrue(decoded == expected);
+
+            // The stream output is done by the task.
+            std::stringbuf compressedStream(std::string(compressed.begin(), compressed.begin() + compressedLength), std::ios_base::in);
+            std::stringbuf decodedStream(std::ios_base::out);
+            Assert::IsTrue(JpegLsDecodeStreamPipelined({&decodedStream, nullptr, 0}, {&compressedStream, nullptr, 0}, nullptr, executor, nullptr) == ApiResult::OK);
+            const std::string decodedBytes = decodedStream.str();
+            Assert::IsTrue(std::equal(expected.begin(), expected.end(), decodedBytes.begin(), decodedBytes.end(), [](uint8_t a, char b) { return a == static_cast<uint8_t>(b); }));
+        }
+
+        // The error of the output on the second thread is returned by the decoding thread.
+        const JlsExecutor threadPerTaskExecutor{ nullptr, ThreadPerTaskCreateGroup, ThreadPerTaskSubmit, ThreadPerTaskWait };
+        std::stringbuf compressedStream(std::string(compressed.begin(), compressed.begin() + compressedLength), std::ios_base::in);
+        FailingStreamBuf failingStream(static_cast<std::streamsize>(expected.size() / 2));
+        Assert::IsTrue(JpegLsDecodeStreamPipelined({&failingStream, nullptr, 0}, {&compressedStream, nullptr, 0}, nullptr, &threadPerTaskExecutor, nullptr) == ApiResult::UncompressedBufferTooSmall);
+        Assert::IsTrue(failingStream.GetFailedThread() != std::thread::id() && failingStream.GetFailedThread() != std::this_thread::get_id());
+    }
+
+    JpegLsDestroyThreadExecutor(threadExecutor);
+}
+
+
+// The lines are read and converted by a task of the executor while the previous lines are encoded: the encoded bytes must be
+// the same as the bytes of JpegLsEncode, also when the executor runs the task on the encoding thread (serial executor).
+void TestEncodePipelined()
+{
+    JlsExecutor* threadExecutor = JpegLsCreateThreadExecutor(1);
+    Assert::IsTrue(threadExecutor != nullptr);
+
+    struct
+    {
+        int bitsPerSample;
+        int components;
+        InterleaveMode interleaveMode;
+        ColorTransformation colorTransformation;
+    } const images[] = {
+        { 12, 3, InterleaveMode::Line, ColorTransformation::HP1 },
+        { 8, 3, InterleaveMode::Sample, ColorTransformation::HP2 },
+        { 8, 3, InterleaveMode::None, ColorTransformation::None },
+        { 12, 4, InterleaveMode::Line, ColorTransformation::None } };
+
+    for (const auto& image : images)
+    {
+        JlsParameters params{};
+        params.width = 211;
+        params.height = 97;
+        params.bitsPerSample = image.bitsPerSample;
+        params.components = image.components;
+        params.interleaveMode = image.interleaveMode;
+        params.colorTransformation = image.colorTransformation;
+        const size_t sampleCount = static_cast<size_t>(params.width) * params.height * params.components;
+        const std::vector<uint8_t> pixels = params.bitsPerSample == 8 ? MakeSomeNoise(sampleCount, 8, 5) : MakeSomeNoise16bit(sampleCount, 12, 5);
+
+        std::vector<uint8_t> expected(pixels.size() * 2 + 1024);
+        size_t expectedLength = 0;
+        Assert::IsTrue(JpegLsEncode(expected.data(), expected.size(), &expectedLength, pixels.data(), pixels.size(), &params, nullptr) == ApiResult::OK);
+        expected.resize(expectedLength);
+
+        for (const JlsExecutor* executor : { static_cast<const JlsExecutor*>(nullptr), JpegLsGetSerialExecutor(), static_cast<const JlsExecutor*>(threadExecutor) })
+        {
+            std::vector<uint8_t> compressed(pixels.size() * 2 + 1024);
+            size_t compressedLength = 0;
+            Assert::IsTrue(JpegLsEncodePipelined(compressed.data(), compressed.size(), &compressedLength, pixels.data(), pixels.size(), &params, executor, nullptr) == ApiResult::OK);
+            compressed.resize(compressedLength);
+            Assert::IsTrue(compressed == expected);
+
+            // The stream input is done by the task.
+            std::stringbuf pixelStream(std::string(pixels.begin(), pixels.end()), std::ios_base::in);
+            std::stringbuf encodedStream(std::ios_base::out);
+            Assert::IsTrue(JpegLsEncodeStreamPipelined({&encodedStream, nullptr, 0}, compressedLength, {&pixelStream, nullptr, 0}, params, executor, nullptr) == ApiResult::OK);
+            const std::string encodedBytes = encodedStream.str();
+            Assert::IsTrue(std::equal(expected.begin(), expected.end(), encodedBytes.begin(), encodedBytes.end(), [](uint8_t a, char b) { return a == static_cast<uint8_t>(b); }));
+
+            // The task is stopped when the encoder fails.
+            compressed.resize(expectedLength / 4);
+            Assert::IsTrue(JpegLsEncodePipelined(compressed.data(), compressed.size(), &compressedLength, pixels.data(), pixels.size(), &params, executor, nullptr) == ApiResult::CompressedBufferTooSmall);
+        }
+
+        // The error of the input on the second thread is returned by the encoding thread.
+        const JlsExecutor threadPerTaskExecutor{ nullptr, ThreadPerTaskCreateGroup, ThreadPerTaskSubmit, ThreadPerTaskWait };
+        std::stringbuf encodedStream(std::ios_base::out);
+        FailingStreamBuf failingStream(static_cast<std::streamsize>(pixels.size() / 2));
+        size_t bytesWritten = 0;
+        Assert::IsTrue(JpegLsEncodeStreamPipelined({&encodedStream, nullptr, 0}, bytesWritten, {&failingStream, nullptr, 0}, params, &threadPerTaskExecutor, nullptr) == ApiResult::UncompressedBufferTooSmall);
+        Assert::IsTrue(failingStream.GetFailedThread() != std::thread::id() && failingStream.GetFailedThread() != std::this_thread::get_id());
+    }
+
+    JpegLsDestroyThreadExecutor(threadExecutor);
 }
 
 
@@ -480,7 +2545,7 @@ bool ComparePnm(std::istream& pnmFile1, std::istream& pnmFile2)
     }
     const auto bytesPerSample = header1[3] > 255 ? 2 : 1;
 
-    const size_t byteCount = width * height * bytesPerSample;
+    const size_t byteCount = static_cast<size_t>(width) * height * bytesPerSample;
     std::vector<uint8_t> bytes1(byteCount);
     std::vector<uint8_t> bytes2(byteCount);
 
@@ -556,6 +2621,74 @@ ApiResult DecodeRaw(const char* strNameEncoded, const char* strNameOutput)
 }
 
 
+// A stream that cannot seek, like a pipe or a socket.
+class NonSeekableStringBuf : public std::stringbuf
+{
+public:
+    explicit NonSeekableStringBuf(const std::string& bytes) :
+        std::stringbuf(bytes, std::ios_base::in)
+    {
+    }
+
+protected:
+    pos_type seekoff(off_type /*offset*/, std::ios_base::seekdir /*direction*/, std::ios_base::openmode /*which*/) override
+    {
+        return pos_type(off_type(-1));
+    }
+};
+
+
+void TestStreamBlocks(const char* file, size_t blockSize)
+{
+    std::vector<uint8_t> compressed;
+    JlsParameters params{};
+    if (!ScanFile(file, &compressed, &params))
+        return;
+
+    const size_t size = static_cast<size_t>(params.width) * params.height * params.components * ((params.bitsPerSample + 7) / 8);
+    std::vector<uint8_t> expected(size);
+    Assert::IsTrue(JpegLsDecode(expected.data(), size, compressed.data(), compressed.size(), nullptr, nullptr) == ApiResult::OK);
+
+    // The bytes after every scan are put back in the stream: multiple scans can be decoded, and the stream ends after the last scan.
+    std::stringbuf compressedStream(std::string(compressed.begin(), compressed.end()), std::ios_base::in);
+    std::vector<uint8_t> decoded(size);
+    Assert::IsTrue(JpegLsDecodeStream(FromByteArray(decoded.data(), size), {&compressedStream, nullptr, 0, blockSize}, nullptr, nullptr) == ApiResult::OK);
+    Assert::IsTrue(decoded == expected);
+    Assert::IsTrue(compressedStream.in_avail() <= 2);
+
+    // The bytes read after the scan cannot be put back in a stream that cannot seek, the markers after the scan would be lost.
+    NonSeekableStringBuf nonSeekableStream(std::string(compressed.begin(), compressed.end()));
+    Assert::IsTrue(JpegLsDecodeStream(FromByteArray(decoded.data(), size), {&nonSeekableStream, nullptr, 0, blockSize}, nullptr, nullptr) == ApiResult::ParameterValueNotSupported);
+
+    JlsParameters encodeParams{};
+    JpegLsReadHeader(compressed.data(), compressed.size(), &encodeParams, nullptr);
+    encodeParams.stride = 0;
+    std::vector<uint8_t> encoded(size * 2 + 1024);
+    size_t expectedLength = 0;
+    Assert::IsTrue(JpegLsEncode(encoded.data(), encoded.size(), &expectedLength, expected.data(), size, &encodeParams, nullptr) == ApiResult::OK);
+
+    std::stringbuf encodedStream;
+    size_t bytesWritten = 0;
+    Assert::IsTrue(JpegLsEncodeStream({&encodedStream, nullptr, 0, blockSize}, bytesWritten, FromByteArray(expected.data(), size), encodeParams, nullptr) == ApiResult::OK);
+    Assert::IsTrue(bytesWritten == expectedLength);
+    Assert::IsTrue(encodedStream.str() == std::string(encoded.begin(), encoded.begin() + expectedLength));
+}
+
+
+void TestStreamBlocks()
+{
+    const size_t blockSizes[] = { 1024, 4000, 0 };
+    for (const auto blockSize : blockSizes)
+    {
+        TestStreamBlocks("test/lena8b.jls", blockSize);
+        TestStreamBlocks("test/conformance/T8C0E0.JLS", blockSize);
+        TestStreamBlocks("test/conformance/T8C1E3.JLS", blockSize);
+        TestStreamBlocks("test/conformance/T8C2E3.JLS", blockSize);
+        TestStreamBlocks("test/conformance/T16E3.JLS", blockSize);
+    }
+}
+
+
 void TestEncodeFromStream()
 {
     ////TestDecodeFromStream("test/user_supplied/output.jls");
@@ -579,6 +2712,81 @@ void UnitTest()
 
         TestDecodeRect();
 
+        printf("Test Push decoder\r\n");
+        TestPushDecoder();
+
+        printf("Test Push encoder\r\n");
+        TestPushEncoder();
+
+        printf("Test DNL marker segment\r\n");
+        TestDefineNumberOfLines();
+
+        printf("Test Line callbacks\r\n");
+        TestLineCallbacks();
+
+        printf("Test Batch\r\n");
+        TestBatch();
+
+        printf("Test Decode fragments\r\n");
+        TestDecodeFragments();
+
+        printf("Test C API\r\n");
+        Assert::IsTrue(TestCApi() == 0);
+
+        printf("Test Encode to chunks\r\n");
+        TestEncodeToChunks();
+
+        printf("Test Stream blocks\r\n");
+        TestStreamBlocks();
+
+        printf("Test Memory mapped files\r\n");
+        TestMappedFiles();
+
+        printf("Test Callback streams\r\n");
+        TestCallbackStream();
+
+        printf("Test Decode components\r\n");
+        TestDecodeComponents();
+
+        printf("Test Segment index\r\n");
+        TestSegmentIndex();
+
+        printf("Test Mapping table\r\n");
+        TestMappingTable();
+
+        printf("Test Oversize image\r\n");
+        TestOversizeImage();
+
+        printf("Test Transcode\r\n");
+        TestTranscode();
+
+        printf("Test Decode reduced\r\n");
+        TestDecodeReduced();
+
+        printf("Test Decode transformed\r\n");
+        TestDecodeTransformed();
+
+        printf("Test Decode layout\r\n");
+        TestDecodeLayout();
+
+        printf("Test Decode oriented\r\n");
+        TestDecodeOriented();
+
+        printf("Test Encode layout\r\n");
+        TestEncodeLayout();
+
+        printf("Test Encode format\r\n");
+        TestEncodeFormat();
+
+        printf("Test Executor\r\n");
+        TestExecutor();
+
+        printf("Test Decode pipelined\r\n");
+        TestDecodePipelined();
+
+        printf("Test Encode pipelined\r\n");
+        TestEncodePipelined();
+
         printf("Test Traits\r\n");
         TestTraits16bit();
         TestTraits8bit();
@@ -587,6 +2795,9 @@ void UnitTest()
         TestBgr();
         TestBgra();
 
+        printf("Test Inlined line processing\r\n");
+        TestInlinedLineProcessing();
+
         printf("Test Small buffer\r\n");
         TestTooSmallOutputBuffer();
 
@@ -619,7 +2830,7 @@ int main(int argc, char* argv[])
 {
     if (argc == 1)
     {
-        printf("CharLS test runner.\r\nOptions: -unittest, -bitstreamdamage, -performance[:loop-count], -decodeperformance[:loop-count], -dontwait -decoderaw -encodepnm -decodetopnm -comparepnm\r\n");
+        printf("CharLS test runner.\r\nOptions: -unittest, -bitstreamdamage, -performance[:loop-count], -decodeperformance[:loop-count], -streamperformance[:loop-count], -dontwait -decoderaw -encodepnm -decodetopnm -comparepnm\r\n");
         return EXIT_FAILURE;
     }
 
@@ -735,6 +2946,26 @@ int main(int argc, char* argv[])
             continue;
         }
 
+        if (str.compare(0, 18, "-streamperformance") == 0)
+        {
+            int loopCount = 1;
+
+            // Extract the optional loop count from the command line. Longer running tests make the measurements more reliable.
+            auto index = str.find(':');
+            if (index != std::string::npos)
+            {
+                loopCount = std::stoi(str.substr(++index));
+                if (loopCount < 1)
+                {
+                    printf("Loop count not understood or invalid: %s\r\n", str.c_str());
+                    break;
+                }
+            }
+
+            StreamPerformanceTests(loopCount);
+            continue;
+        }
+
         if (str == "-dicom")
         {
             TestDicomWG4Images();
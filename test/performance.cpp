@@ -9,6 +9,9 @@
 #include <vector>
 #include <ratio>
 #include <chrono>
+#include <functional>
+#include <sstream>
+#include <iostream>
 
 namespace
 {
@@ -61,9 +64,92 @@ void TestPerformance(int loopCount)
 }
 
 
+double StreamModeTime(const char* name, int loopCount, const std::function<void()>& action)
+{
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < loopCount; ++i)
+    {
+        action();
+    }
+    const auto time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / loopCount;
+    printf("  %-36s %8.2f ms\r\n", name, time);
+    return time;
+}
+
+
+void TestStreamPerformance(const char* filename, int ioffs, Size size, int cbit, int ccomp, size_t blockSize, int loopCount)
+{
+    std::vector<uint8_t> uncompressed;
+    if (!ReadFile(filename, &uncompressed, ioffs))
+        return;
+
+    JlsParameters params{};
+    params.width = static_cast<int>(size.cx);
+    params.height = static_cast<int>(size.cy);
+    params.bitsPerSample = cbit;
+    params.components = ccomp;
+    params.interleaveMode = ccomp == 3 ? charls::InterleaveMode::Sample : charls::InterleaveMode::None;
+
+    std::vector<uint8_t> compressed(uncompressed.size() * 2 + 1024);
+    size_t compressedLength = 0;
+    if (JpegLsEncode(compressed.data(), compressed.size(), &compressedLength, uncompressed.data(), uncompressed.size(), &params, nullptr) != charls::ApiResult::OK)
+        return;
+    compressed.resize(compressedLength);
+    const std::string compressedString(compressed.begin(), compressed.end());
+
+    printf("%s (%dx%d, %d bit, %d components)\r\n", filename, params.width, params.height, cbit, ccomp);
+
+    std::vector<uint8_t> encoded(uncompressed.size() * 2 + 1024);
+    StreamModeTime("encode buffer -> buffer", loopCount, [&]
+    {
+        size_t bytesWritten;
+        JpegLsEncode(encoded.data(), encoded.size(), &bytesWritten, uncompressed.data(), uncompressed.size(), &params, nullptr);
+    });
+    StreamModeTime("encode buffer -> stream", loopCount, [&]
+    {
+        std::stringbuf output;
+        size_t bytesWritten;
+        JpegLsEncodeStream({&output, nullptr, 0, blockSize}, bytesWritten, FromByteArray(uncompressed.data(), uncompressed.size()), params, nullptr);
+    });
+
+    std::vector<uint8_t> decoded(uncompressed.size());
+    StreamModeTime("decode buffer -> buffer", loopCount, [&]
+    {
+        JpegLsDecode(decoded.data(), decoded.size(), compressed.data(), compressed.size(), nullptr, nullptr);
+    });
+    StreamModeTime("decode stream -> buffer", loopCount, [&]
+    {
+        std::stringbuf input(compressedString, std::ios_base::in);
+        JpegLsDecodeStream(FromByteArray(decoded.data(), decoded.size()), {&input, nullptr, 0, blockSize}, nullptr, nullptr);
+    });
+    StreamModeTime("decode stream -> stream", loopCount, [&]
+    {
+        std::stringbuf input(compressedString, std::ios_base::in);
+        std::stringbuf output;
+        JpegLsDecodeStream({&output, nullptr, 0, blockSize}, {&input, nullptr, 0, blockSize}, nullptr, nullptr);
+    });
+}
+
 } // namespace
 
 
+void StreamPerformanceTests(int loopCount)
+{
+#ifdef _DEBUG
+    printf("NOTE: running performance test in debug mode, performance may be slow!\r\n");
+#endif
+    printf("Test stream mode vs buffer mode Perf (with loop count %i)\r\n", loopCount);
+
+    const size_t blockSizes[] = { 4 * 1024, 64 * 1024, 1024 * 1024 };
+    for (const auto blockSize : blockSizes)
+    {
+        printf("Stream block size: %u bytes\r\n", static_cast<unsigned int>(blockSize));
+        TestStreamPerformance("test/0015.raw", 0, Size(1024, 1024), 8, 1, blockSize, loopCount);
+        TestStreamPerformance("test/desktop.ppm", 40, Size(1280, 1024), 8, 3, blockSize, loopCount);
+    }
+}
+
+
 void PerformanceTests(int loopCount)
 {
 #ifdef _DEBUG
@@ -8,5 +8,6 @@
 void PerformanceTests(int loopCount);
 void DecodePerformanceTests(int loopCount);
 void TestLargeImagePerformanceRgb8(int loopCount);
+void StreamPerformanceTests(int loopCount);
 
 #endif
@@ -94,7 +94,7 @@ void TestRoundTrip(const char* strName, const std::vector<uint8_t>& rgbyteRaw, S
 
 void TestRoundTrip(const char* strName, const std::vector<uint8_t>& rgbyteRaw, JlsParameters& params, int loopCount)
 {
-    std::vector<uint8_t> rgbyteCompressed(params.height * params.width * params.components * params.bitsPerSample / 4);
+    std::vector<uint8_t> rgbyteCompressed(static_cast<size_t>(params.height) * params.width * params.components * params.bitsPerSample / 4);
 
     std::vector<uint8_t> rgbyteOut(static_cast<size_t>(params.height) * params.width * ((params.bitsPerSample + 7) / 8) * params.components);
 
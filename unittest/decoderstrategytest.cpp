@@ -35,6 +35,14 @@ public:
     void DecodeScan(std::unique_ptr<ProcessLine> /*outputData*/, const JlsRect& /*size*/, ByteStreamInfo& /*compressedData*/) override
     {
     }
+
+    void StartDecodeScan(std::unique_ptr<ProcessLine> /*outputData*/, const JlsRect& /*size*/, ByteStreamInfo& /*compressedData*/) override
+    {
+    }
+
+    void DecodeLines(int32_t /*lineCount*/) override
+    {
+    }
     WARNING_UNSUPPRESS()
 
     int32_t Read(int32_t length) { return ReadLongValue(length); }
@@ -24,6 +24,14 @@ public:
         return 0;
     }
 
+    void StartEncodeScan(ByteStreamInfo&) override
+    {
+    }
+
+    void EncodeLines(std::unique_ptr<ProcessLine>, int32_t) override
+    {
+    }
+
     std::unique_ptr<ProcessLine> CreateProcess(ByteStreamInfo) override
     {
         return nullptr;